@@ -0,0 +1,13 @@
+#ifndef TETRIS_ATOMIC_FILE_H
+#define TETRIS_ATOMIC_FILE_H
+
+#include <string>
+
+// Replaces the file at 'path' with 'contents' so that a crash or power cut
+// at any moment leaves either the old file or the new one, never half of
+// each: the data goes to 'path.tmp', is flushed to disk, and only then
+// renamed over the original. Returns false if any step failed (the old
+// file is then untouched). Each platform has its own AtomicFile_*.cpp.
+bool WriteFileAtomically(const std::string& path, const std::string& contents);
+
+#endif
@@ -0,0 +1,21 @@
+#include "AtomicFile.h"
+#include <windows.h>
+
+bool WriteFileAtomically(const std::string& path, const std::string& contents) {
+    std::string temp_path = path + ".tmp";
+    HANDLE file = CreateFileA(temp_path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    DWORD written = 0;
+    bool ok = WriteFile(file, contents.data(), static_cast<DWORD>(contents.size()), &written, nullptr) &&
+              written == contents.size() && FlushFileBuffers(file);
+    ok = CloseHandle(file) && ok;
+
+    // WRITE_THROUGH makes MoveFileEx return only once the rename is on disk.
+    if (!ok || !MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileA(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
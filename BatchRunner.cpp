@@ -0,0 +1,68 @@
+#include "BatchRunner.h"
+#include <chrono>
+
+BatchRunner::BatchRunner(int thread_count) : pool(thread_count) {}
+
+uint64_t BatchRunner::SeedForGame(uint64_t base_seed, int index) {
+    // splitmix64 of (base, index) so neighbouring games get unrelated seeds.
+    return SplitMix64(base_seed + 0x9E3779B97F4A7C15ull * static_cast<uint64_t>(index));
+}
+
+void BatchRunner::PlayGame(const BatchConfig& config, int index) {
+    GameState& state = games[index];
+    GameStats& stats = results[index];
+
+    stats = GameStats();
+    stats.seed = SeedForGame(config.base_seed, index);
+    state.line_clear_delay_ms = 0; // Nobody is watching the flash.
+    state.randomizer.Reset(stats.seed, config.randomizer_mode);
+    ResetGameState(state, stats.seed);
+
+    size_t stream_size = config.input_stream.size();
+    while (!state.is_game_over && stats.steps < config.max_steps_per_game) {
+        Action action = Action::None;
+        if (config.policy) {
+            action = config.policy(state, stats.steps);
+        } else if (stream_size > 0) {
+            action = config.input_stream[stats.steps % stream_size];
+        }
+
+        StepResult result = StepGame(state, action, config.ms_per_step);
+        stats.pieces += result.pieces_locked;
+        stats.steps++;
+    }
+
+    stats.score = state.score;
+    stats.lines = state.lines_cleared;
+}
+
+BatchStats BatchRunner::Run(const BatchConfig& config) {
+    if (config.game_count < 1) return BatchStats(); // Nothing to play.
+
+    games.resize(config.game_count);
+    results.resize(config.game_count);
+
+    auto start = std::chrono::steady_clock::now();
+    pool.ParallelFor(config.game_count, [&](int index) { PlayGame(config, index); });
+    auto end = std::chrono::steady_clock::now();
+
+    // Sum up in game order so the hash doesn't care which thread ran what.
+    BatchStats stats;
+    stats.games = config.game_count;
+    stats.result_hash = 0xCBF29CE484222325ull;
+    for (const GameStats& game : results) {
+        stats.total_score += game.score;
+        stats.total_lines += game.lines;
+        stats.total_pieces += game.pieces;
+        stats.total_steps += game.steps;
+
+        for (uint64_t value : {game.seed, static_cast<uint64_t>(game.score),
+                               static_cast<uint64_t>(game.lines), static_cast<uint64_t>(game.pieces)}) {
+            stats.result_hash = (stats.result_hash ^ value) * 0x100000001B3ull;
+        }
+    }
+
+    stats.seconds = std::chrono::duration<double>(end - start).count();
+    stats.games_per_second = stats.seconds > 0.0 ? stats.games / stats.seconds : 0.0;
+    return stats;
+}
@@ -0,0 +1,74 @@
+#ifndef TETRIS_BATCH_RUNNER_H
+#define TETRIS_BATCH_RUNNER_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Engine.h"
+#include "ThreadPool.h"
+
+// Decides the next action for one game. 'step' counts the actions this game
+// has taken so far. It is called from several threads at once, so it must
+// not touch shared mutable state.
+using Policy = std::function<Action(const GameState& state, uint64_t step)>;
+
+struct BatchConfig {
+    int game_count = 1000;
+    uint64_t base_seed = 1;          // Game i is seeded from (base_seed, i).
+    int ms_per_step = 16;            // Game time that passes after every action.
+    uint64_t max_steps_per_game = 1000000;
+    RandomizerMode randomizer_mode = RandomizerMode::SevenBag;
+
+    // Used when 'policy' is empty: the games replay this list over and over.
+    std::vector<Action> input_stream;
+    Policy policy;
+};
+
+// The final numbers for one game.
+struct GameStats {
+    uint64_t seed = 0;
+    int score = 0;
+    int lines = 0;
+    int pieces = 0;
+    uint64_t steps = 0;
+};
+
+// The totals for a whole batch.
+struct BatchStats {
+    int games = 0;
+    long long total_score = 0;
+    long long total_lines = 0;
+    long long total_pieces = 0;
+    uint64_t total_steps = 0;
+    double seconds = 0.0;
+    double games_per_second = 0.0;
+    uint64_t result_hash = 0;        // Depends only on the per-game results, never on threads.
+};
+
+// Owns N independent games and plays all of them to the end, spread across a
+// work-stealing thread pool. Every game is fully determined by its seed and
+// the policy, so the stats are identical no matter how many threads run.
+class BatchRunner {
+public:
+    // 0 threads = one per hardware core.
+    explicit BatchRunner(int thread_count = 0);
+
+    // Plays config.game_count games (at least 1; a smaller count plays
+    // nothing and returns empty stats).
+    BatchStats Run(const BatchConfig& config);
+
+    // Per-game results from the last Run, in game order.
+    const std::vector<GameStats>& Results() const { return results; }
+
+    // The seed game 'index' of a batch gets.
+    static uint64_t SeedForGame(uint64_t base_seed, int index);
+
+private:
+    void PlayGame(const BatchConfig& config, int index);
+
+    ThreadPool pool;
+    std::vector<GameState> games;
+    std::vector<GameStats> results;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "BatchRunner.h"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const char* USAGE = "usage: tetris_batch [games (1 or more)] [threads (0 = one per core)] [seed]\n";
+
+// Reads a whole argument as a number in [min_value, INT_MAX]; false if it
+// is anything else (empty, trailing junk, out of range).
+bool ParseCount(const char* text, int min_value, int& out) {
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || value < min_value || value > INT_MAX) return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+} // namespace
+
+// Plays a batch of headless games and prints the totals.
+// Usage: tetris_batch [games] [threads] [seed]
+int main(int argc, char** argv) {
+    BatchConfig config;
+    config.game_count = 10000;
+    int threads = 0;
+    config.base_seed = 1;
+
+    char* seed_end = nullptr;
+    if (argc > 3) config.base_seed = std::strtoull(argv[3], &seed_end, 10);
+    if (argc > 4 || (argc > 1 && !ParseCount(argv[1], 1, config.game_count)) ||
+        (argc > 2 && !ParseCount(argv[2], 0, threads)) || (argc > 3 && (seed_end == argv[3] || *seed_end != '\0'))) {
+        std::fprintf(stderr, "%s", USAGE);
+        return 2;
+    }
+
+    // A fixed input stream that spreads pieces across the well.
+    config.input_stream = {
+        Action::MoveLeft, Action::MoveLeft, Action::MoveLeft, Action::MoveLeft, Action::HardDrop,
+        Action::Rotate, Action::MoveLeft, Action::MoveLeft, Action::HardDrop,
+        Action::HardDrop,
+        Action::Rotate, Action::MoveRight, Action::MoveRight, Action::HardDrop,
+        Action::MoveRight, Action::MoveRight, Action::MoveRight, Action::MoveRight, Action::HardDrop,
+    };
+
+    BatchRunner runner(threads);
+    BatchStats stats = runner.Run(config);
+
+    std::printf("games:        %d\n", stats.games);
+    std::printf("total score:  %lld\n", stats.total_score);
+    std::printf("total lines:  %lld\n", stats.total_lines);
+    std::printf("total pieces: %lld (%.1f per game)\n", stats.total_pieces,
+                stats.games ? static_cast<double>(stats.total_pieces) / stats.games : 0.0);
+    std::printf("seconds:      %.3f\n", stats.seconds);
+    std::printf("games/sec:    %.0f\n", stats.games_per_second);
+    std::printf("result hash:  %016llx\n", static_cast<unsigned long long>(stats.result_hash));
+    return 0;
+}
@@ -0,0 +1,760 @@
+#include "BoardEval.h"
+#include "BoardView.h"
+#include "Bot.h"
+#include "Engine.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "Replay.h"
+#include "Scheduler.h"
+#include "Snapshot.h"
+#include "VectorEnv.h"
+#include "Zobrist.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Microbenchmarks for the engine's hot paths, in the spirit of Google
+// Benchmark but with no dependencies. Each benchmark runs its operation in
+// growing batches until it has been timed for at least --min-time seconds,
+// on four kinds of board: empty, half-filled, near top-out and a
+// tetris-ready well. Every global operator new is counted too, so the
+// results show allocations per operation next to ns per operation.
+//
+//   tetris_bench [--filter=TEXT] [--min-time=SECONDS] [--out=FILE]
+//       Runs every benchmark whose name contains TEXT and writes the results
+//       as JSON (to stdout, or FILE). Exits with 1 if anything allocated.
+//   tetris_bench bot [pieces] [threads]
+//       How many placements per second the autoplayer evaluates.
+//   tetris_bench env [envs] [steps] [threads]
+//       How many environment steps per second VectorEnv takes with random
+//       actions. Exits with 1 if a Step allocated.
+//   tetris_bench frames [count]
+//       Runs the game's frame loop headless and exits with 1 if any of it
+//       touched the heap after the first game (see CheckFrameAllocations).
+
+static std::atomic<long long> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// Keeps the compiler from optimizing away a result we never look at.
+template <typename T>
+static void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+// --- Board fixtures ---
+
+struct Fixture {
+    const char* name;
+    GameState state;
+};
+
+static void FillCell(Bitboard& board, int x, int y) {
+    board.rows[y] |= static_cast<RowMask>(1u << x);
+    board.colors[y][x] = static_cast<uint8_t>(1 + x % PIECE_TYPE_COUNT);
+}
+
+// Fills play rows [top, bottom] leaving one pseudo-random gap per row.
+static void FillRowsWithGaps(Bitboard& board, int top, int bottom, unsigned seed) {
+    for (int y = top; y <= bottom; ++y) {
+        seed = seed * 1103515245u + 12345u;
+        int gap = 1 + static_cast<int>((seed >> 16) % (LOGICAL_BOARD_WIDTH - 2));
+        for (int x = 1; x < LOGICAL_BOARD_WIDTH - 1; ++x) {
+            if (x != gap) FillCell(board, x, y);
+        }
+    }
+}
+
+static std::vector<Fixture> MakeFixtures() {
+    const int bottom = GAME_BOARD_HEIGHT - 2;
+    std::vector<Fixture> fixtures(4);
+
+    for (Fixture& fixture : fixtures) {
+        fixture.state.line_clear_delay_ms = 0;
+        ResetGameState(fixture.state, 1);
+    }
+
+    fixtures[0].name = "empty";
+
+    fixtures[1].name = "half";
+    FillRowsWithGaps(fixtures[1].state.board, bottom - 9, bottom, 1);
+
+    fixtures[2].name = "near_topout";
+    FillRowsWithGaps(fixtures[2].state.board, 4, bottom, 2);
+
+    // Four solid rows with the right-most column left open for an I piece.
+    fixtures[3].name = "tetris_ready";
+    Bitboard& well = fixtures[3].state.board;
+    for (int y = bottom - 3; y <= bottom; ++y) {
+        for (int x = 1; x < LOGICAL_BOARD_WIDTH - 2; ++x) FillCell(well, x, y);
+    }
+
+    // FillCell writes the rows directly, behind the column tops' back.
+    for (Fixture& fixture : fixtures) fixture.state.board.RebuildColumnTops();
+    return fixtures;
+}
+
+// A piece somewhere on a board, with its position.
+struct Spot {
+    Piece piece;
+    Position pos;
+};
+
+// Every (piece, rotation, x, y) there is, colliding or not.
+static std::vector<Spot> AllSpots() {
+    std::vector<Spot> spots;
+    for (uint8_t type = 0; type < PIECE_TYPE_COUNT; ++type) {
+        for (uint8_t rotation = 0; rotation < ROTATION_COUNT; ++rotation) {
+            for (int x = -3; x < LOGICAL_BOARD_WIDTH + 1; ++x) {
+                for (int y = 0; y < GAME_BOARD_HEIGHT; ++y) spots.push_back({{type, rotation}, {x, y}});
+            }
+        }
+    }
+    return spots;
+}
+
+// Every spot a piece dropped straight down from the top comes to rest at.
+static std::vector<Spot> LandingSpots(const Bitboard& board) {
+    std::vector<Spot> spots;
+    for (uint8_t type = 0; type < PIECE_TYPE_COUNT; ++type) {
+        for (uint8_t rotation = 0; rotation < ROTATION_COUNT; ++rotation) {
+            Piece piece = {type, rotation};
+            for (int x = -3; x < LOGICAL_BOARD_WIDTH + 1; ++x) {
+                if (board.Collides(piece.Mask(), x, 0)) continue;
+                int y = 0;
+                while (!board.Collides(piece.Mask(), x, y + 1)) ++y;
+                spots.push_back({piece, {x, y}});
+            }
+        }
+    }
+    return spots;
+}
+
+// --- Runner ---
+
+struct BenchResult {
+    std::string name;
+    long long iterations;
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+static std::vector<BenchResult> g_results;
+static std::string g_filter;
+static double g_min_time = 0.2;
+
+// Times 'run(iterations)' in growing batches until a batch lasts long enough.
+template <typename Run>
+static void Benchmark(const std::string& name, Run run) {
+    if (!g_filter.empty() && name.find(g_filter) == std::string::npos) return;
+
+    run(1); // Warm up caches (and any lazy setup) outside the timing.
+
+    long long iterations = 1;
+    for (;;) {
+        long long allocations_before = g_allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        run(iterations);
+        auto end = std::chrono::steady_clock::now();
+        long long allocations = g_allocations.load() - allocations_before;
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        if (seconds >= g_min_time || iterations >= 1000000000LL) {
+            g_results.push_back({name, iterations, seconds * 1e9 / iterations,
+                                 static_cast<double>(allocations) / iterations});
+            std::fprintf(stderr, "%-40s %12.1f ns/op %8.3f allocs/op\n", name.c_str(),
+                         g_results.back().ns_per_op, g_results.back().allocs_per_op);
+            return;
+        }
+
+        // Aim a bit past the target, growing at most 10x per round.
+        double scale = (seconds > 0.0) ? g_min_time * 1.4 / seconds : 10.0;
+        if (scale > 10.0) scale = 10.0;
+        if (scale < 2.0) scale = 2.0;
+        iterations = static_cast<long long>(iterations * scale);
+    }
+}
+
+// Plays one piece: a few rotations and sideways moves, then a hard drop.
+template <class Board>
+static void PlayOnePlacement(BasicGameState<Board>& state, unsigned& seed) {
+    seed = seed * 1103515245u + 12345u;
+    int rotations = (seed >> 16) & 3;
+    int shift = static_cast<int>((seed >> 20) % 9) - 4;
+
+    for (int i = 0; i < rotations; ++i) StepGame(state, Action::Rotate);
+    for (int i = 0; i < shift; ++i) StepGame(state, Action::MoveRight);
+    for (int i = 0; i > shift; --i) StepGame(state, Action::MoveLeft);
+    StepGame(state, Action::HardDrop);
+}
+
+// Plays 'n' whole games, reusing 'state' so nothing is copied while timing.
+template <class State>
+static void PlayFullGames(State& state, long long n) {
+    state.line_clear_delay_ms = 0;
+    unsigned seed = 1;
+    for (long long i = 0; i < n; ++i) {
+        ResetGameState(state, static_cast<uint64_t>(i) + 1);
+        while (!state.is_game_over) PlayOnePlacement(state, seed);
+    }
+    DoNotOptimize(state.score);
+}
+
+static void RunSuite() {
+    std::vector<Fixture> fixtures = MakeFixtures();
+    std::vector<Spot> all_spots = AllSpots();
+    Renderer renderer; // Built once: its output buffer is reserved up front.
+    Renderer tall_renderer(Renderer::SCREEN_WIDTH,
+                           PlayfieldScreenHeight(TallBitboard())); // Fits the 10x40 board's visible rows.
+
+    // Board independent: rotating a mask by hand vs. looking it up.
+    Benchmark("RotatePiece", [&](long long n) {
+        PieceMask mask = PIECE_TABLE.masks[0][0];
+        for (long long i = 0; i < n; ++i) {
+            mask = RotatePiece(mask);
+            DoNotOptimize(mask);
+        }
+    });
+    Benchmark("Piece::Rotated", [&](long long n) {
+        Piece piece = {0, 0};
+        for (long long i = 0; i < n; ++i) {
+            piece.type = static_cast<uint8_t>(i % PIECE_TYPE_COUNT);
+            piece = piece.Rotated();
+            DoNotOptimize(piece);
+        }
+    });
+
+    for (Fixture& fixture : fixtures) {
+        const std::string suffix = std::string("/") + fixture.name;
+        const GameState& base = fixture.state;
+        std::vector<Spot> landings = LandingSpots(base.board);
+        size_t spot_count = all_spots.size();
+        size_t landing_count = landings.size();
+
+        Benchmark("CheckCollision" + suffix, [&](long long n) {
+            size_t next = 0;
+            for (long long i = 0; i < n; ++i) {
+                const Spot& spot = all_spots[next];
+                next = (next + 1 == spot_count) ? 0 : next + 1;
+                bool hit = CheckCollision(base, spot.piece.Mask(), spot.pos.x, spot.pos.y);
+                DoNotOptimize(hit);
+            }
+        });
+
+        // Where a piece dropped from the top of each column lands, from the
+        // column tops (what hard drops and the ghost piece use).
+        Benchmark("LandingRow" + suffix, [&](long long n) {
+            size_t next = 0;
+            for (long long i = 0; i < n; ++i) {
+                const Spot& spot = landings[next];
+                next = (next + 1 == landing_count) ? 0 : next + 1;
+                Position landing = LandingPosition(base.board, spot.piece, Position{spot.pos.x, 0});
+                DoNotOptimize(landing);
+            }
+        });
+
+        Benchmark("TryRotationWithWallKicks" + suffix, [&](long long n) {
+            GameState state = base;
+            size_t next = 0;
+            for (long long i = 0; i < n; ++i) {
+                const Spot& spot = landings[next];
+                next = (next + 1 == landing_count) ? 0 : next + 1;
+                state.current_piece = spot.piece;
+                state.current_pos = spot.pos;
+                bool rotated = TryRotationWithWallKicks(state);
+                DoNotOptimize(rotated);
+            }
+        });
+
+        // The same spots with the SRS tables, cycling through all three turns.
+        Benchmark("TryRotationWithWallKicks/srs" + suffix, [&](long long n) {
+            GameState state = base;
+            state.rotation_system = RotationSystem::SRS;
+            size_t next = 0;
+            for (long long i = 0; i < n; ++i) {
+                const Spot& spot = landings[next];
+                next = (next + 1 == landing_count) ? 0 : next + 1;
+                state.current_piece = spot.piece;
+                state.current_pos = spot.pos;
+                bool rotated = TryRotationWithWallKicks(state, 1 + static_cast<int>(i % 3));
+                DoNotOptimize(rotated);
+            }
+        });
+
+        // Copying the whole GameState is part of the next few benchmarks, so
+        // it gets a line of its own to subtract.
+        Benchmark("CopyState" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; ++i) {
+                GameState state = base;
+                DoNotOptimize(state);
+            }
+        });
+
+        // Save states for rollback and lookahead (Snapshot.h), against the CopyState above.
+        Benchmark("GameSnapshot::Save" + suffix, [&](long long n) {
+            GameSnapshot snapshot;
+            for (long long i = 0; i < n; ++i) {
+                snapshot.Save(base);
+                DoNotOptimize(snapshot);
+            }
+        });
+
+        GameSnapshot saved;
+        saved.Save(base);
+        Benchmark("GameSnapshot::Restore" + suffix, [&](long long n) {
+            GameState state;
+            for (long long i = 0; i < n; ++i) {
+                saved.Restore(state);
+                DoNotOptimize(state);
+            }
+        });
+
+        std::vector<uint8_t> serialized;
+        serialized.reserve(GameSnapshot::SERIALIZED_SIZE);
+        // Out to the file format and back in, with every field checked.
+        Benchmark("GameSnapshot::Serialize" + suffix, [&](long long n) {
+            GameSnapshot loaded;
+            for (long long i = 0; i < n; ++i) {
+                serialized.clear();
+                saved.Serialize(serialized);
+                bool ok = loaded.Deserialize(serialized.data(), serialized.size());
+                DoNotOptimize(ok);
+            }
+        });
+
+        Benchmark("ZobristHash" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; ++i) {
+                uint64_t hash = ZobristHash(base);
+                DoNotOptimize(hash);
+            }
+        });
+
+        // Scoring the board after every landing spot at once, the way the
+        // solver scores a node's children, at each SIMD level there is here.
+        BoardBatch batch;
+        batch.Clear();
+        for (const Spot& spot : landings) {
+            Bitboard after = base.board;
+            after.Place(spot.piece.Mask(), spot.pos.x, spot.pos.y, static_cast<uint8_t>(spot.piece.Id()));
+            if (batch.Add(after) < 0) break;
+        }
+        float scores[BoardBatch::CAPACITY];
+        for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2}) {
+            if (level > DetectSimdLevel()) continue;
+            Benchmark(std::string("EvaluateBatch/") + SimdLevelName(level) + suffix, [&](long long n) {
+                for (long long i = 0; i < n; ++i) {
+                    EvaluateBatch(batch, EvalWeights(), scores, level);
+                    DoNotOptimize(scores[0]);
+                }
+            });
+        }
+
+        Benchmark("LockPiece" + suffix, [&](long long n) {
+            size_t next = 0;
+            for (long long i = 0; i < n; ++i) {
+                const Spot& spot = landings[next];
+                next = (next + 1 == landing_count) ? 0 : next + 1;
+                GameState state = base;
+                state.line_clear_delay_ms = 1; // Just find the lines, don't remove them.
+                state.current_piece = spot.piece;
+                state.current_pos = spot.pos;
+                StepResult result;
+                LockPiece(state, result);
+                DoNotOptimize(state);
+            }
+        });
+
+        // The same board with its bottom row completed (or, on the
+        // tetris-ready board, the well filled) so there is always work to do.
+        GameState clearing = base;
+        const int bottom = GAME_BOARD_HEIGHT - 2;
+        for (int x = 1; x < LOGICAL_BOARD_WIDTH - 1; ++x) FillCell(clearing.board, x, bottom);
+        if (std::strcmp(fixture.name, "tetris_ready") == 0) {
+            for (int y = bottom - 3; y < bottom; ++y) FillCell(clearing.board, LOGICAL_BOARD_WIDTH - 2, y);
+        }
+
+        // The rows a piece finishing those lines would have touched.
+        const RowSet touched_rows = RowSet(0xF) << (bottom - 3);
+
+        Benchmark("ClearLines+ShiftLinesDown" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; ++i) {
+                GameState state = clearing;
+                StepResult result;
+                ClearLines(state, touched_rows);
+                ShiftLinesDown(state, result);
+                DoNotOptimize(state);
+            }
+        });
+
+        // Composes the playfield and diffs it; the piece alternates between
+        // two columns so every frame has something to send.
+        Benchmark("DrawBoard" + suffix, [&](long long n) {
+            GameState frames[2] = {base, base};
+            frames[1].current_pos.x += 1;
+            for (long long i = 0; i < n; ++i) {
+                renderer.BeginFrame();
+                DrawPlayfield(renderer, frames[i & 1], 0);
+                const std::string& output = renderer.Present();
+                DoNotOptimize(output.size());
+            }
+        });
+    }
+
+    // One piece, start to finish, through StepGame.
+    Benchmark("Placement", [&](long long n) {
+        GameState state;
+        state.line_clear_delay_ms = 0;
+        ResetGameState(state, 1);
+        unsigned seed = 1;
+        uint64_t games = 1;
+        for (long long i = 0; i < n; ++i) {
+            if (state.is_game_over) ResetGameState(state, ++games);
+            PlayOnePlacement(state, seed);
+        }
+        DoNotOptimize(state);
+    });
+
+    // Whole headless games from spawn to top-out.
+    GameState standard_state;
+    Benchmark("FullGame", [&](long long n) { PlayFullGames(standard_state, n); });
+
+    // The same games on the other board sizes. "dynamic" is the runtime-sized
+    // fallback on the classic 10x20 board, so it compares directly with
+    // FullGame above.
+    TallGameState tall_state;
+    WideGameState wide_state;
+    DynamicGameState dynamic_state;
+    Benchmark("FullGame/tall", [&](long long n) { PlayFullGames(tall_state, n); });
+    Benchmark("FullGame/wide", [&](long long n) { PlayFullGames(wide_state, n); });
+    Benchmark("FullGame/dynamic", [&](long long n) { PlayFullGames(dynamic_state, n); });
+
+    // The same games under the guideline rules: another instantiation of
+    // the engine, so it should cost the same as FullGame.
+    GameState marathon_state;
+    marathon_state.mode = GameMode::Marathon;
+    Benchmark("FullGame/marathon", [&](long long n) { PlayFullGames(marathon_state, n); });
+
+    // Drawing a 10x40 board with a 20 row buffer zone: only 20 rows show.
+    Benchmark("DrawBoard/tall", [&](long long n) {
+        TallGameState frames[2];
+        for (TallGameState& frame : frames) {
+            frame.line_clear_delay_ms = 0;
+            ResetGameState(frame, 1);
+        }
+        frames[1].current_pos.x += 1;
+        for (long long i = 0; i < n; ++i) {
+            tall_renderer.BeginFrame();
+            DrawPlayfield(tall_renderer, frames[i & 1], 0);
+            const std::string& output = tall_renderer.Present();
+            DoNotOptimize(output.size());
+        }
+    });
+}
+
+// Writes the results in the same shape as Google Benchmark's JSON output.
+static void WriteJson(std::FILE* out) {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    std::fprintf(out, "{\n  \"context\": {\n");
+    std::fprintf(out, "    \"date\": \"%s\",\n", date);
+    std::fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    std::fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+    std::fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+    std::fprintf(out, "  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < g_results.size(); ++i) {
+        const BenchResult& result = g_results[i];
+        std::fprintf(out, "    {\"name\": \"%s\", \"iterations\": %lld, \"real_time\": %.3f, "
+                          "\"time_unit\": \"ns\", \"allocs_per_op\": %.6f",
+                     result.name.c_str(), result.iterations, result.ns_per_op, result.allocs_per_op);
+        if (result.name == "FullGame") {
+            std::fprintf(out, ", \"games_per_second\": %.1f", 1e9 / result.ns_per_op);
+        }
+        std::fprintf(out, "}%s\n", (i + 1 < g_results.size()) ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+// Lets the bot play 'pieces' pieces (starting new games as needed) and
+// reports how many final boards it scored per second.
+static int BenchBot(long long pieces, int threads, RotationSystem rotation_system) {
+    Bot bot(threads);
+
+    GameState state;
+    state.line_clear_delay_ms = 0;
+    state.rotation_system = rotation_system;
+    ResetGameState(state, 1);
+
+    long long games = 1;
+    long long lines = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (long long i = 0; i < pieces; ++i) {
+        if (state.is_game_over) {
+            games++;
+            ResetGameState(state, games);
+        }
+        BotMove move;
+        if (!bot.FindBestMove(state, move)) continue;
+        for (int a = 0; a < move.action_count; ++a) {
+            lines += StepGame(state, move.actions[a]).lines_cleared;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double evaluated = static_cast<double>(bot.PlacementsEvaluated());
+
+    std::printf("pieces:                %lld\n", pieces);
+    std::printf("games:                 %lld\n", games);
+    std::printf("lines:                 %lld\n", lines);
+    std::printf("placements evaluated:  %.0f\n", evaluated);
+    std::printf("placements per second: %.0f\n", evaluated / seconds);
+    std::printf("us per piece:          %.1f\n", seconds * 1e6 / pieces);
+    return 0;
+}
+
+// Steps 'envs' environments 'steps' times with random actions, the way a
+// training loop would, and reports environment steps per second.
+static int BenchEnv(int envs, long long steps, int threads) {
+    EnvConfig config;
+    config.env_count = envs;
+    VectorEnv env(config, threads);
+
+    std::vector<float> observations(static_cast<size_t>(envs) * VectorEnv::OBSERVATION_SIZE);
+    std::vector<float> rewards(envs);
+    std::vector<uint8_t> dones(envs);
+    std::vector<int32_t> actions(envs);
+    env.Reset(1, observations.data());
+
+    unsigned seed = 1;
+    double total_reward = 0.0;
+    long long allocations = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (long long step = 0; step < steps; ++step) {
+        for (int32_t& action : actions) {
+            seed = seed * 1103515245u + 12345u;
+            action = static_cast<int32_t>((seed >> 16) % VectorEnv::ACTION_COUNT);
+        }
+        long long before = g_allocations.load();
+        env.Step(actions.data(), observations.data(), rewards.data(), dones.data());
+        allocations += g_allocations.load() - before;
+        for (float reward : rewards) total_reward += reward;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double env_steps = static_cast<double>(steps) * envs;
+
+    std::printf("environments:          %d\n", envs);
+    std::printf("steps:                 %lld\n", steps);
+    std::printf("episodes finished:     %llu\n", static_cast<unsigned long long>(env.EpisodesFinished()));
+    std::printf("total reward:          %.0f\n", total_reward);
+    std::printf("env steps per second:  %.0f\n", env_steps / seconds);
+    std::printf("ns per env step:       %.1f\n", seconds * 1e9 / env_steps);
+    std::printf("allocations in Step:   %lld\n", allocations);
+    return allocations > 0 ? 1 : 0;
+}
+
+// Runs the same work as the game's frame loop (Game_Render.cpp), minus the
+// console: time and key presses into the engine, every action into the
+// replay, the bot taking turns, the board and HUD drawn and diffed, the
+// profiler, latency and run stats read back, and a new game whenever one ends.
+// The first game after the warm-up is the bot's alone and runs for
+// LONG_GAME_PIECES pieces, long enough that the replay writer (given a small
+// block here) has to move its recording out to the scratch file many times.
+// After one warm-up game nothing in there may touch the heap. Run after
+// every build of tetris_bench, so an allocation sneaking into the loop
+// fails the build and says which part it came from.
+static int CheckFrameAllocations(long long frames) {
+    enum Stage { ENGINE, REPLAY, BOT, RENDER, STATS, NEW_GAME, STAGE_COUNT };
+    const char* const STAGE_NAMES[STAGE_COUNT] = {"engine", "replay", "bot", "render", "stats",
+                                                  "new game"};
+    long long allocations[STAGE_COUNT] = {};
+    long long* current = nullptr; // Where the allocations of the stage being run go.
+    auto run = [&](Stage stage, auto work) {
+        long long before = g_allocations.load();
+        work();
+        if (current) current[stage] += g_allocations.load() - before;
+    };
+
+    // Startup: everything the game builds once, with the game's own settings.
+    GameState state;
+    state.rotation_system = RotationSystem::SRS;
+    state.lock_delay_ms = 500;
+    ResetGameState(state, 1);
+    Bot bot;
+    Renderer renderer;
+    const size_t REPLAY_BLOCK_BYTES = 256;
+    ReplayWriter replay(REPLAY_BLOCK_BYTES);
+    LatencyStats latency;
+    RunStats run_stats;
+    replay.Begin(state);
+    run_stats.Start(std::chrono::steady_clock::now());
+
+    const int FRAME_MS = 16;
+    const int BOT_EVERY = 4; // Frames between bot placements; the rest are key presses.
+    const int LONG_GAME_PIECES = 600;
+    int long_game_pieces = 0;
+    size_t long_game_bytes = 0;
+    long long long_game_frames = 0;
+    unsigned seed = 1;
+    long long games = 1;
+    long long warm_up = -1;
+    char text[64];
+
+    for (long long frame = 0; frame < frames || warm_up < 0; ++frame) {
+        // The first game (and the first use of every buffer) is startup.
+        if (warm_up < 0 && games > 1) {
+            warm_up = frame;
+            frames += frame;
+            current = allocations;
+        }
+
+        bool is_long_game = (games == 2);
+        if (is_long_game) {
+            frames++; // Its frames come on top of the rest.
+            long_game_frames++;
+        }
+        run(ENGINE, [&] {
+            replay.Record(state.frame, Action::None);
+            StepGame(state, Action::None, FRAME_MS);
+        });
+        if (is_long_game || frame % BOT_EVERY == 0) {
+            BotMove move;
+            bool found = false;
+            // Playing every frame, the bot waits out the flash like the game's own does.
+            if (!is_long_game || !state.is_clearing_lines) run(BOT, [&] { found = bot.FindBestMove(state, move); });
+            for (int a = 0; found && a < move.action_count; ++a) {
+                run(REPLAY, [&] { replay.Record(state.frame, move.actions[a]); });
+                run(ENGINE, [&] { StepGame(state, move.actions[a]); });
+            }
+            if (is_long_game && found) long_game_pieces++;
+        } else {
+            seed = seed * 1103515245u + 12345u;
+            Action key = static_cast<Action>(1 + (seed >> 16) % static_cast<int>(Action::Hold));
+            run(REPLAY, [&] { replay.Record(state.frame, key); });
+            run(ENGINE, [&] { StepGame(state, key); });
+        }
+
+        run(RENDER, [&] {
+            TETRIS_PROFILE_SCOPE("DrawBoard");
+            renderer.BeginFrame();
+            DrawPlayfield(renderer, state, (state.line_clear_elapsed_ms / 100) % 2);
+            std::snprintf(text, sizeof(text), "SCORE: %d", state.score);
+            renderer.Put(PlayfieldScreenWidth(state.board) + 4, 5, text);
+            DoNotOptimize(renderer.Present().size());
+        });
+        run(STATS, [&] {
+            auto now = std::chrono::steady_clock::now();
+            run_stats.AddKeys(1);
+            run_stats.UpdateLines(state.lines_cleared, now);
+            FormatRunTime(run_stats.ElapsedNs(now), text, sizeof(text));
+            DoNotOptimize(run_stats.PiecesPerSecond(now));
+            latency.Record(std::chrono::nanoseconds(frame % 1000));
+            profiler::SampleCounters();
+            if (frame % 30 == 0) {
+                DoNotOptimize(profiler::Summarize("DrawBoard"));
+                DoNotOptimize(latency.Summarize());
+            }
+        });
+
+        if (state.is_game_over || (is_long_game && long_game_pieces >= LONG_GAME_PIECES)) {
+            run(NEW_GAME, [&] {
+                replay.End(state);
+                if (is_long_game) long_game_bytes = replay.Size();
+                run_stats.Stop(std::chrono::steady_clock::now());
+                ResetGameState(state, static_cast<uint64_t>(++games));
+                replay.Begin(state);
+                run_stats.Start(std::chrono::steady_clock::now());
+            });
+        }
+    }
+
+    long long total = 0;
+    for (long long count : allocations) total += count;
+    std::printf("frame loop: %lld frames over %lld games plus a %d piece bot game (%zu replay bytes) "
+                "after a %lld frame warm-up, %lld allocations\n",
+                frames - warm_up - long_game_frames, games - 2, long_game_pieces, long_game_bytes, warm_up, total);
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        if (allocations[stage] > 0) std::printf("  %-18s %lld allocations\n", STAGE_NAMES[stage], allocations[stage]);
+    }
+    return total > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "frames") == 0) {
+        return CheckFrameAllocations((argc > 2) ? std::atoll(argv[2]) : 5000);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "bot") == 0) {
+        long long pieces = (argc > 2) ? std::atoll(argv[2]) : 2000;
+        int threads = (argc > 3) ? std::atoi(argv[3]) : 0;
+        bool srs = (argc > 4) && std::strcmp(argv[4], "srs") == 0;
+        return BenchBot(pieces, threads, srs ? RotationSystem::SRS : RotationSystem::Classic);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "env") == 0) {
+        int envs = (argc > 2) ? std::atoi(argv[2]) : 256;
+        long long steps = (argc > 3) ? std::atoll(argv[3]) : 2000;
+        int threads = (argc > 4) ? std::atoi(argv[4]) : 0;
+        return BenchEnv(envs > 0 ? envs : 1, steps, threads);
+    }
+
+    const char* out_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            g_filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--min-time=", 11) == 0) {
+            g_min_time = std::atof(argv[i] + 11);
+        } else if (std::strncmp(argv[i], "--out=", 6) == 0) {
+            out_path = argv[i] + 6;
+        } else {
+            std::fprintf(stderr, "usage: tetris_bench [--filter=TEXT] [--min-time=SECONDS] [--out=FILE]\n"
+                                 "       tetris_bench bot [pieces] [threads] [classic|srs]\n"
+                                 "       tetris_bench env [envs] [steps] [threads]\n"
+                                 "       tetris_bench frames [count]\n");
+            return 2;
+        }
+    }
+
+    g_results.reserve(128);
+    RunSuite();
+
+    std::FILE* out = out_path ? std::fopen(out_path, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "could not open %s\n", out_path);
+        return 2;
+    }
+    WriteJson(out);
+    if (out != stdout) std::fclose(out);
+
+    // The hot paths are supposed to be allocation free.
+    for (const BenchResult& result : g_results) {
+        if (result.allocs_per_op > 0.0) return 1;
+    }
+    return 0;
+}
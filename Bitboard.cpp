@@ -0,0 +1,203 @@
+#include "Bitboard.h"
+#include <algorithm>
+#include <cstring>
+
+template <class Board, typename Mask>
+void BoardBase<Board, Mask>::Reset() {
+    Board& board = Self();
+    const int width = board.Width();
+    const int height = board.Height();
+    const RowMask empty_row = WallRowMask();
+
+    // The top and bottom rows are solid, every other row only has its side walls.
+    for (int y = 0; y < height; ++y) {
+        bool is_edge = (y == 0 || y == height - 1);
+        board.rows[y] = is_edge ? FULL_ROW_MASK : empty_row;
+
+        uint8_t* colors = board.ColorRow(y);
+        for (int x = 0; x < width; ++x) {
+            bool is_wall = is_edge || x == 0 || x == width - 1;
+            colors[x] = is_wall ? WALL_CELL : 0;
+        }
+    }
+
+    // Walls reach the ceiling; every play column is empty down to the floor.
+    for (int x = 0; x < width; ++x) {
+        bool is_wall = (x == 0 || x == width - 1);
+        board.column_tops[x] = static_cast<uint8_t>(is_wall ? 0 : height - 1);
+    }
+}
+
+template <class Board, typename Mask>
+RowSet BoardBase<Board, Mask>::Place(const PieceMask& piece, int x, int y, uint8_t color) {
+    Board& board = Self();
+    RowSet touched = 0;
+    for (int py = 0; py < 4; ++py) {
+        uint32_t bits = piece.rows[py];
+        if (bits == 0) continue;
+
+        RowMask shifted = (x >= 0) ? static_cast<RowMask>(static_cast<RowMask>(bits) << x)
+                                   : static_cast<RowMask>(bits >> -x);
+        board.rows[y + py] |= shifted;
+        touched |= RowSet(1) << (y + py);
+
+        // Only the (at most 4) columns the piece row covers can be set.
+        uint8_t* colors = board.ColorRow(y + py);
+        for (int px = 0; px < 4; ++px) {
+            if (bits & (1u << px)) {
+                colors[x + px] = color;
+                if (y + py < board.column_tops[x + px]) board.column_tops[x + px] = static_cast<uint8_t>(y + py);
+            }
+        }
+    }
+    return touched;
+}
+
+template <class Board, typename Mask>
+RowSet BoardBase<Board, Mask>::FullRows(RowSet candidates) const {
+    const int height = Self().Height();
+    RowSet full = 0;
+    for (RowSet bits = candidates; bits != 0; bits &= bits - 1) {
+        int y = 0;
+        while (!(bits & (RowSet(1) << y))) ++y; // Lowest set bit.
+        if (y >= 1 && y < height - 1 && IsRowFull(y)) full |= RowSet(1) << y;
+    }
+    return full;
+}
+
+template <class Board, typename Mask>
+void BoardBase<Board, Mask>::RemoveRows(RowSet cleared) {
+    Board& board = Self();
+    const int width = board.Width();
+    const RowMask empty_row = WallRowMask();
+
+    // Blocks only move down, so no column ends up above today's highest top.
+    int highest_top = board.Height() - 1;
+    for (int x = 1; x < width - 1; ++x) highest_top = std::min<int>(highest_top, board.column_tops[x]);
+
+    // Walk from the floor up. The surviving rows between two cleared rows form
+    // a block that drops by however many cleared rows lie below it, so each
+    // block moves with one memmove per plane instead of row by row.
+    int shift = 0;
+    int y = board.Height() - 2;
+    while (y >= 1) {
+        if (cleared & (RowSet(1) << y)) {
+            ++shift;
+            --y;
+            continue;
+        }
+
+        int bottom = y;
+        while (y >= 1 && !(cleared & (RowSet(1) << y))) --y;
+        int top = y + 1;
+
+        if (shift > 0) {
+            int count = bottom - top + 1;
+            std::memmove(&board.rows[top + shift], &board.rows[top], count * sizeof(RowMask));
+            std::memmove(board.ColorRow(top + shift), board.ColorRow(top), count * width);
+        }
+    }
+
+    // The rows that opened up at the top become fresh empty rows.
+    for (y = 1; y <= shift; ++y) {
+        board.rows[y] = empty_row;
+        uint8_t* colors = board.ColorRow(y);
+        std::memset(colors, 0, width);
+        colors[0] = WALL_CELL;
+        colors[width - 1] = WALL_CELL;
+    }
+    RecomputeColumnTops(std::max(highest_top, 1));
+}
+
+template <class Board, typename Mask>
+bool BoardBase<Board, Mask>::InsertGarbage(int count, int hole_x) {
+    Board& board = Self();
+    const int width = board.Width();
+    const int floor_y = board.Height() - 1;
+    const RowMask empty_row = WallRowMask();
+    if (count <= 0) return false;
+    if (count > floor_y - 1) count = floor_y - 1;
+
+    int highest_top = floor_y;
+    for (int x = 1; x < width - 1; ++x) highest_top = std::min<int>(highest_top, board.column_tops[x]);
+
+    // Anything in the top 'count' play rows has nowhere to go.
+    bool overflowed = false;
+    for (int y = 1; y <= count; ++y) {
+        if (board.rows[y] != empty_row) overflowed = true;
+    }
+
+    // Everything else moves up in one block, like RemoveRows in reverse.
+    int moved = floor_y - 1 - count;
+    std::memmove(&board.rows[1], &board.rows[1 + count], moved * sizeof(RowMask));
+    std::memmove(board.ColorRow(1), board.ColorRow(1 + count), moved * width);
+
+    const RowMask garbage_row = static_cast<RowMask>(FULL_ROW_MASK & ~(RowMask(1) << hole_x));
+    for (int y = floor_y - count; y < floor_y; ++y) {
+        board.rows[y] = garbage_row;
+        uint8_t* colors = board.ColorRow(y);
+        std::memset(colors + 1, GARBAGE_CELL, width - 2);
+        colors[hole_x] = 0;
+    }
+    RecomputeColumnTops(std::max(highest_top - count, 1));
+    return overflowed;
+}
+
+template <class Board, typename Mask>
+void BoardBase<Board, Mask>::RecomputeColumnTops(int first_row) {
+    Board& board = Self();
+    const int width = board.Width();
+    const int floor_y = board.Height() - 1;
+
+    // Walk down the rows with a mask of the columns that haven't shown a
+    // block yet. It usually empties long before the floor.
+    RowMask open = static_cast<RowMask>(~WallRowMask());
+    for (int y = first_row; y < floor_y && open != 0; ++y) {
+        RowMask found = board.rows[y] & open;
+        if (found == 0) continue;
+        for (int x = 1; x < width - 1; ++x) {
+            if (found & (RowMask(1) << x)) board.column_tops[x] = static_cast<uint8_t>(y);
+        }
+        open = static_cast<RowMask>(open & ~found);
+    }
+    for (int x = 1; x < width - 1; ++x) {
+        if (open & (RowMask(1) << x)) board.column_tops[x] = static_cast<uint8_t>(floor_y);
+    }
+}
+
+template <class Board, typename Mask>
+uint64_t BoardBase<Board, Mask>::Hash() const {
+    const Board& board = Self();
+    const int width = board.Width();
+    const int height = board.Height();
+
+    // FNV-1a over the row masks (low byte first) and then the color plane.
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int y = 0; y < height; ++y) {
+        for (size_t byte = 0; byte < sizeof(RowMask); ++byte) {
+            hash = (hash ^ ((board.rows[y] >> (8 * byte)) & 0xFF)) * 0x100000001B3ull;
+        }
+    }
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* colors = board.ColorRow(y);
+        for (int x = 0; x < width; ++x) {
+            hash = (hash ^ colors[x]) * 0x100000001B3ull;
+        }
+    }
+    return hash;
+}
+
+DynamicBitboard::DynamicBitboard(int play_width, int play_height, int buffer_rows)
+    : width(std::min(std::max(play_width, 4), 59) + 2),
+      height(std::min(std::max(play_height, 4), 62) + 2),
+      buffer_rows(std::min(std::max(buffer_rows, 0), height - 3)) {
+    rows.resize(height);
+    colors.resize(height * width);
+    column_tops.resize(width);
+    Reset();
+}
+
+template class BoardBase<Bitboard, Bitboard::RowMask>;
+template class BoardBase<TallBitboard, TallBitboard::RowMask>;
+template class BoardBase<WideBitboard, WideBitboard::RowMask>;
+template class BoardBase<DynamicBitboard, uint64_t>;
@@ -0,0 +1,268 @@
+#ifndef TETRIS_BITBOARD_H
+#define TETRIS_BITBOARD_H
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// The color id stored for wall cells in the render plane.
+const uint8_t WALL_CELL = 9;
+
+// The color id of garbage rows sent by an opponent in versus mode.
+const uint8_t GARBAGE_CELL = 8;
+
+// A set of board rows: bit y = row y. Boards are at most 64 rows tall.
+using RowSet = uint64_t;
+
+// A piece squeezed down to 4 row masks (bit 0 = left-most column of its 4x4 grid).
+struct PieceMask {
+    uint8_t rows[4];
+};
+
+// How far down each column of a piece's 4x4 grid reaches: bottom[px] is the
+// lowest row with a block in column px, or -1 if that column is empty.
+struct PieceProfile {
+    int8_t bottom[4];
+};
+
+constexpr PieceProfile BuildPieceProfile(const PieceMask& mask) {
+    PieceProfile profile = {{-1, -1, -1, -1}};
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            if (mask.rows[y] & (1u << x)) profile.bottom[x] = static_cast<int8_t>(y);
+        }
+    }
+    return profile;
+}
+
+// The smallest unsigned type with at least 'Bits' bits.
+template <int Bits>
+using RowMaskFor = typename std::conditional<
+    (Bits <= 16), uint16_t,
+    typename std::conditional<(Bits <= 32), uint32_t, uint64_t>::type>::type;
+
+// The size of a board, fixed at compile time.
+// PlayWidth x PlayHeight is the area pieces move in; the board adds a wall on
+// each side, a ceiling and a floor around it. The top 'BufferRows' play rows
+// are a hidden buffer zone: pieces spawn there and it isn't drawn.
+template <int PlayWidth, int PlayHeight, int BufferRows = 0>
+struct BoardGeometry {
+    // A row mask needs the walls plus 3 spare bits so a piece hanging over
+    // the right wall still fits in it (those spare bits are always "solid").
+    static_assert(PlayWidth >= 4 && PlayWidth + 5 <= 64, "boards are 4 to 59 columns wide");
+    static_assert(PlayHeight >= 4 && PlayHeight + 2 <= 64, "boards are 4 to 62 rows tall");
+    static_assert(BufferRows >= 0 && BufferRows < PlayHeight, "the buffer zone must leave rows to see");
+
+    static constexpr int WIDTH = PlayWidth + 2;
+    static constexpr int HEIGHT = PlayHeight + 2;
+    static constexpr int BUFFER_ROWS = BufferRows;
+    using RowMask = RowMaskFor<WIDTH + 3>;
+};
+
+// The rules every board shares, written once for both the fixed-size boards
+// and the runtime-sized one. 'Board' provides Width(), Height(), BufferRows(),
+// 'rows' and 'column_tops' arrays and ColorRow(y); for the fixed-size boards
+// those are compile-time constants, so the compiler specializes every loop below.
+//
+// The board is stored as two "planes":
+// - rows:   one bitmask per row, used for collisions, locking and line clears.
+// - colors: the piece id of every cell, only needed when drawing.
+// plus the top of every column, so a drop can be worked out without
+// stepping down the rows.
+template <class Board, typename Mask>
+class BoardBase {
+public:
+    using RowMask = Mask;
+
+    // A row with every bit set. A play row that reaches this value is a full line.
+    static constexpr RowMask FULL_ROW_MASK = static_cast<RowMask>(~RowMask(0));
+    static constexpr int MASK_BITS = static_cast<int>(sizeof(RowMask) * 8);
+
+    // An empty play row: only the two walls are set, plus every bit to the right of
+    // the right wall so a piece hanging off the edge still "hits" something.
+    RowMask WallRowMask() const {
+        RowMask play = static_cast<RowMask>(((RowMask(1) << (Self().Width() - 2)) - 1) << 1);
+        return static_cast<RowMask>(FULL_ROW_MASK & ~play);
+    }
+
+    // The first play row that is drawn (everything above it is buffer zone).
+    int FirstVisibleRow() const { return 1 + Self().BufferRows(); }
+
+    // Empties the play area and rebuilds the walls, floor and ceiling.
+    void Reset();
+
+    // True if the piece would overlap a wall, a locked block or leave the board.
+    bool Collides(const PieceMask& piece, int x, int y) const;
+
+    // Glues the piece into both planes. Returns the rows it landed on
+    // (bit y = row y), which are the only rows that can have just filled up.
+    RowSet Place(const PieceMask& piece, int x, int y, uint8_t color);
+
+    bool IsRowFull(int y) const { return Self().rows[y] == FULL_ROW_MASK; }
+
+    // The rows in 'candidates' (bit y = row y) that are full. Costs one
+    // compare per candidate, so checking what a piece touched is O(piece height).
+    RowSet FullRows(RowSet candidates) const;
+
+    // Removes every row whose bit is set in 'cleared' (bit y = row y) and drops
+    // the rows above it down, like compacting an array.
+    void RemoveRows(RowSet cleared);
+
+    // Pushes the whole stack up by 'count' rows and fills the bottom with
+    // garbage rows that are solid except for column 'hole_x' (a play column,
+    // 1 .. Width() - 2). Returns true if any block was pushed out of the top.
+    bool InsertGarbage(int count, int hole_x);
+
+    // A 64-bit fingerprint of both planes; two boards that look the same hash the same.
+    uint64_t Hash() const;
+
+    // The highest solid play row of column x, or the floor row if the column
+    // is empty (the walls are solid to the ceiling). Place, RemoveRows and
+    // InsertGarbage keep these up to date.
+    int ColumnTop(int x) const { return Self().column_tops[x]; }
+
+    // How tall the stack in column x is, in rows (0 = empty).
+    int ColumnHeight(int x) const { return Self().Height() - 1 - ColumnTop(x); }
+
+    // Code that edits 'rows' directly (test boards, a board received over the
+    // network) calls this afterwards to bring the column tops back in line.
+    void RebuildColumnTops() { RecomputeColumnTops(1); }
+
+    // The row a piece that fits at (x, y) comes to rest on if it drops
+    // straight down. While every column of the piece is above that column's
+    // top, this is one subtraction per column; a piece tucked under an
+    // overhang falls back to testing the rows one by one.
+    int LandingRow(const PieceMask& piece, const PieceProfile& profile, int x, int y) const;
+
+    uint8_t Color(int x, int y) const { return Self().ColorRow(y)[x]; }
+
+private:
+    const Board& Self() const { return static_cast<const Board&>(*this); }
+    Board& Self() { return static_cast<Board&>(*this); }
+
+    // Finds the top of every play column again, starting the search at
+    // 'first_row' (every block is known to be at or below it).
+    void RecomputeColumnTops(int first_row);
+};
+
+// A board whose size is a template parameter. This is the fast path: every
+// size-dependent number is a constant and both planes are plain arrays, so a
+// GameState stays one flat, trivially copyable struct.
+template <class Geometry>
+struct BasicBitboard : BoardBase<BasicBitboard<Geometry>, typename Geometry::RowMask> {
+    using RowMask = typename Geometry::RowMask;
+
+    static constexpr int Width() { return Geometry::WIDTH; }
+    static constexpr int Height() { return Geometry::HEIGHT; }
+    static constexpr int BufferRows() { return Geometry::BUFFER_ROWS; }
+
+    uint8_t* ColorRow(int y) { return colors[y]; }
+    const uint8_t* ColorRow(int y) const { return colors[y]; }
+
+    RowMask rows[Geometry::HEIGHT];
+    uint8_t colors[Geometry::HEIGHT][Geometry::WIDTH];
+    uint8_t column_tops[Geometry::WIDTH];
+};
+
+// The fallback for sizes only known at run time (e.g. read from a command
+// line). Same rules, but the sizes are loaded from memory and the planes live
+// on the heap, so it is slower than a BasicBitboard and copying it allocates.
+class DynamicBitboard : public BoardBase<DynamicBitboard, uint64_t> {
+public:
+    // Sizes outside what a BoardGeometry allows are clamped into range.
+    explicit DynamicBitboard(int play_width = 10, int play_height = 20, int buffer_rows = 0);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    int BufferRows() const { return buffer_rows; }
+
+    uint8_t* ColorRow(int y) { return &colors[y * width]; }
+    const uint8_t* ColorRow(int y) const { return &colors[y * width]; }
+
+    std::vector<uint64_t> rows;
+    std::vector<uint8_t> colors;
+    std::vector<uint8_t> column_tops;
+
+private:
+    int width;
+    int height;
+    int buffer_rows;
+};
+
+// The sizes we build a specialized engine for (see Engine.cpp).
+using StandardGeometry = BoardGeometry<10, 20>;   // The classic playfield.
+using TallGeometry = BoardGeometry<10, 40, 20>;   // 10x40 with a 20 row hidden buffer zone.
+using WideGeometry = BoardGeometry<40, 20>;       // For stress tests.
+
+using Bitboard = BasicBitboard<StandardGeometry>;
+using TallBitboard = BasicBitboard<TallGeometry>;
+using WideBitboard = BasicBitboard<WideGeometry>;
+
+// The standard board's numbers, for code that only ever deals with it.
+const int LOGICAL_BOARD_WIDTH = StandardGeometry::WIDTH;  // 10 columns for play + 2 for side walls.
+const int GAME_BOARD_HEIGHT = StandardGeometry::HEIGHT;   // 20 rows for play + 1 top wall + 1 bottom wall.
+using RowMask = Bitboard::RowMask;
+const RowMask FULL_ROW_MASK = Bitboard::FULL_ROW_MASK;
+const RowMask WALL_ROW_MASK =
+    static_cast<RowMask>(FULL_ROW_MASK & ~(((1u << (LOGICAL_BOARD_WIDTH - 2)) - 1) << 1));
+
+// Collision is at most four AND operations: shift each piece row into board
+// space and test it against the matching board row. Every row mask has at
+// least 3 solid bits past the right wall, so a shifted piece row never
+// overflows the mask.
+template <class Board, typename Mask>
+inline bool BoardBase<Board, Mask>::Collides(const PieceMask& piece, int x, int y) const {
+    if (x <= -4 || x > MASK_BITS - 4) return true; // Way off the board, no need to look.
+
+    // Shift in at least 32 bits, like plain int math, so nothing gets truncated.
+    using Shifted = typename std::conditional<(sizeof(RowMask) <= 4), uint32_t, uint64_t>::type;
+
+    const Board& board = Self();
+    for (int py = 0; py < 4; ++py) {
+        Shifted bits = piece.rows[py];
+        if (bits == 0) continue;
+
+        int boardY = y + py;
+        if (boardY < 0 || boardY >= board.Height()) return true;
+
+        if (x >= 0) {
+            bits <<= x;
+        } else {
+            if (bits & ((Shifted(1) << -x) - 1)) return true; // Fell off the left side.
+            bits >>= -x;
+        }
+
+        if (board.rows[boardY] & bits) return true;
+    }
+    return false;
+}
+
+template <class Board, typename Mask>
+inline int BoardBase<Board, Mask>::LandingRow(const PieceMask& piece, const PieceProfile& profile, int x, int y) const {
+    const Board& board = Self();
+    int landing = board.Height();
+    for (int px = 0; px < 4; ++px) {
+        int bottom = profile.bottom[px];
+        if (bottom < 0) continue;
+
+        // Everything above a column's top is empty, so this column stops the
+        // piece one row above its top...
+        int top = board.column_tops[x + px];
+        if (y + bottom >= top) {
+            // ...unless the piece is already below it, tucked under an
+            // overhang. Then feel the way down.
+            while (!Collides(piece, x, y + 1)) ++y;
+            return y;
+        }
+        if (top - 1 - bottom < landing) landing = top - 1 - bottom;
+    }
+    return landing;
+}
+
+// The out-of-line members are compiled once, in Bitboard.cpp, for these boards.
+extern template class BoardBase<Bitboard, Bitboard::RowMask>;
+extern template class BoardBase<TallBitboard, TallBitboard::RowMask>;
+extern template class BoardBase<WideBitboard, WideBitboard::RowMask>;
+extern template class BoardBase<DynamicBitboard, uint64_t>;
+
+#endif
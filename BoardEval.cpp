@@ -0,0 +1,79 @@
+#include "BoardEval.h"
+
+namespace {
+
+// The play columns of a row mask (bit 0 is the left wall).
+const uint32_t PLAY_MASK = ((1u << (LOGICAL_BOARD_WIDTH - 2)) - 1) << 1;
+
+// Neighbouring pairs from (left wall, first column) to (last column, right wall).
+const uint32_t PAIR_MASK = (1u << (LOGICAL_BOARD_WIDTH - 1)) - 1;
+
+// The same bit counting the vector kernels do on each 16-bit lane.
+int CountBits16(uint32_t x) {
+    x = x - ((x >> 1) & 0x5555);
+    x = (x & 0x3333) + ((x >> 2) & 0x3333);
+    x = (x + (x >> 4)) & 0x0F0F;
+    return static_cast<int>((x + (x >> 8)) & 0x1F);
+}
+
+SimdLevel FindSimdLevel() {
+#if TETRIS_X86_SIMD && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    return SimdLevel::SSE2;
+#elif TETRIS_X86_SIMD
+    return SimdLevel::SSE2; // Every x86-64 CPU has it; AVX2 needs the GCC/Clang check above.
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+} // namespace
+
+SimdLevel DetectSimdLevel() {
+    static const SimdLevel level = FindSimdLevel();
+    return level;
+}
+
+const char* SimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE2: return "sse2";
+        default:              return "scalar";
+    }
+}
+
+void EvaluateBatchScalar(const BoardBatch& batch, int first, const EvalWeights& weights, float* scores) {
+    for (int lane = first; lane < batch.count; ++lane) {
+        uint32_t covered = 0;
+        int aggregate_height = 0, holes = 0, max_height = 0, transitions = 0;
+        for (int y = 0; y < BoardBatch::PLAY_HEIGHT; ++y) {
+            uint32_t row = batch.rows[y][lane];
+            covered |= row & PLAY_MASK;
+            aggregate_height += CountBits16(covered);
+            holes += CountBits16(covered & ~row);
+            max_height += (covered != 0);
+            transitions += CountBits16((row ^ (row >> 1)) & PAIR_MASK);
+        }
+        // Same order of operations as the vector kernels, so the floats match bit for bit.
+        float score = static_cast<float>(aggregate_height) * weights.aggregate_height;
+        score = score + static_cast<float>(holes) * weights.holes;
+        score = score + static_cast<float>(transitions) * weights.row_transitions;
+        score = score + static_cast<float>(max_height) * weights.max_height;
+        scores[lane] = score;
+    }
+}
+
+void EvaluateBatch(const BoardBatch& batch, const EvalWeights& weights, float* scores, SimdLevel level) {
+    int done = 0;
+#if TETRIS_X86_SIMD
+    if (level == SimdLevel::AVX2) {
+        done = EvaluateBatchAvx2(batch, weights, scores);
+    } else if (level == SimdLevel::SSE2) {
+        done = EvaluateBatchSse2(batch, weights, scores);
+    }
+#else
+    (void)level;
+#endif
+    EvaluateBatchScalar(batch, done, weights, scores);
+}
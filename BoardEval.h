@@ -0,0 +1,70 @@
+#ifndef TETRIS_BOARD_EVAL_H
+#define TETRIS_BOARD_EVAL_H
+
+#include <cstdint>
+#include "Bitboard.h"
+
+// Scores many classic 10x20 boards at once. A search that has just tried
+// every placement of a piece copies the resulting boards into a BoardBatch,
+// where row y of every board sits side by side ("structure of arrays"), and
+// one pass down the rows works out the features of 8 (SSE2) or 16 (AVX2)
+// boards per instruction. Each board's features only need the rows above
+// it, so the pass is the same for every lane:
+//   covered = OR of the rows so far (a column is covered below its top)
+//   aggregate height += popcount(covered)
+//   holes            += popcount(covered & ~row)
+//   max height       += (covered != 0)
+//   row transitions  += popcount(row ^ (row >> 1)), walls included
+
+// How much the search cares about each feature. All of them are bad.
+struct EvalWeights {
+    float aggregate_height = -0.51f; // Sum of all column heights.
+    float holes = -3.5f;             // Empty cells under their column's top.
+    float row_transitions = -0.32f;  // Filled/empty changes along each row.
+    float max_height = -0.2f;        // The tallest column.
+};
+
+// Which instructions EvaluateBatch may use.
+enum class SimdLevel : uint8_t {
+    Scalar, // Plain C++, one board at a time. Always there.
+    SSE2,   // 8 boards per 128-bit register (every x86-64 CPU).
+    AVX2    // 16 boards per 256-bit register.
+};
+
+// The best level this build and this CPU support.
+SimdLevel DetectSimdLevel();
+const char* SimdLevelName(SimdLevel level);
+
+// Up to CAPACITY boards, stored row-major across boards. Only the play rows
+// are kept (the walls are the same everywhere), as full row masks.
+struct BoardBatch {
+    static const int CAPACITY = 256; // A multiple of every vector width; room for two pieces' placements.
+    static const int PLAY_HEIGHT = GAME_BOARD_HEIGHT - 2;
+
+    alignas(32) uint16_t rows[PLAY_HEIGHT][CAPACITY];
+    int count = 0;
+
+    void Clear() { count = 0; }
+
+    // Copies 'board' into the next free lane and returns its index.
+    int Add(const Bitboard& board) {
+        for (int y = 0; y < PLAY_HEIGHT; ++y) rows[y][count] = board.rows[y + 1];
+        return count++;
+    }
+};
+
+// Writes the weighted score of every board in 'batch' to scores[0 .. count).
+// Every level gives exactly the same numbers; higher ones just get there sooner.
+void EvaluateBatch(const BoardBatch& batch, const EvalWeights& weights, float* scores,
+                   SimdLevel level = DetectSimdLevel());
+
+// The kernels behind EvaluateBatch. The vector ones score whole registers
+// of boards from lane 0 and return how many lanes that was (a multiple of
+// their width, at most batch.count); the scalar one scores the rest.
+void EvaluateBatchScalar(const BoardBatch& batch, int first, const EvalWeights& weights, float* scores);
+#if TETRIS_X86_SIMD
+int EvaluateBatchSse2(const BoardBatch& batch, const EvalWeights& weights, float* scores);
+int EvaluateBatchAvx2(const BoardBatch& batch, const EvalWeights& weights, float* scores);
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#include "BoardEval.h"
+#include <immintrin.h>
+
+// The AVX2 kernel: 16 boards per register, one 16-bit lane each. This file
+// is the only one built with AVX2 enabled (see CMakeLists.txt), and it is
+// only called after DetectSimdLevel has seen the CPU supports it.
+
+namespace {
+
+// Counts the set bits of every 16-bit lane.
+inline __m256i CountBits(__m256i x) {
+    x = _mm256_sub_epi16(x, _mm256_and_si256(_mm256_srli_epi16(x, 1), _mm256_set1_epi16(0x5555)));
+    x = _mm256_add_epi16(_mm256_and_si256(x, _mm256_set1_epi16(0x3333)),
+                         _mm256_and_si256(_mm256_srli_epi16(x, 2), _mm256_set1_epi16(0x3333)));
+    x = _mm256_and_si256(_mm256_add_epi16(x, _mm256_srli_epi16(x, 4)), _mm256_set1_epi16(0x0F0F));
+    return _mm256_and_si256(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), _mm256_set1_epi16(0x1F));
+}
+
+// Widens 8 of the 16-bit counts to floats.
+inline __m256 ToFloats(__m128i counts) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(counts));
+}
+
+// Weights eight boards' features in the scalar kernel's order.
+inline __m256 Score(__m128i aggregate_height, __m128i holes, __m128i transitions, __m128i max_height,
+                    const EvalWeights& weights) {
+    __m256 score = _mm256_mul_ps(ToFloats(aggregate_height), _mm256_set1_ps(weights.aggregate_height));
+    score = _mm256_add_ps(score, _mm256_mul_ps(ToFloats(holes), _mm256_set1_ps(weights.holes)));
+    score = _mm256_add_ps(score, _mm256_mul_ps(ToFloats(transitions), _mm256_set1_ps(weights.row_transitions)));
+    return _mm256_add_ps(score, _mm256_mul_ps(ToFloats(max_height), _mm256_set1_ps(weights.max_height)));
+}
+
+} // namespace
+
+int EvaluateBatchAvx2(const BoardBatch& batch, const EvalWeights& weights, float* scores) {
+    const int width = 16;
+    const int lanes = batch.count - batch.count % width;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i play_mask = _mm256_set1_epi16(static_cast<short>(((1u << (LOGICAL_BOARD_WIDTH - 2)) - 1) << 1));
+    const __m256i pair_mask = _mm256_set1_epi16(static_cast<short>((1u << (LOGICAL_BOARD_WIDTH - 1)) - 1));
+
+    for (int lane = 0; lane < lanes; lane += width) {
+        __m256i covered = zero, aggregate_height = zero, holes = zero, transitions = zero, empty_rows = zero;
+        for (int y = 0; y < BoardBatch::PLAY_HEIGHT; ++y) {
+            __m256i row = _mm256_load_si256(reinterpret_cast<const __m256i*>(&batch.rows[y][lane]));
+            covered = _mm256_or_si256(covered, _mm256_and_si256(row, play_mask));
+            aggregate_height = _mm256_add_epi16(aggregate_height, CountBits(covered));
+            holes = _mm256_add_epi16(holes, CountBits(_mm256_andnot_si256(row, covered)));
+            empty_rows = _mm256_sub_epi16(empty_rows, _mm256_cmpeq_epi16(covered, zero)); // cmpeq is -1 per match.
+            __m256i pairs = _mm256_xor_si256(row, _mm256_srli_epi16(row, 1));
+            transitions = _mm256_add_epi16(transitions, CountBits(_mm256_and_si256(pairs, pair_mask)));
+        }
+        __m256i max_height = _mm256_sub_epi16(_mm256_set1_epi16(BoardBatch::PLAY_HEIGHT), empty_rows);
+
+        _mm256_storeu_ps(scores + lane,
+                         Score(_mm256_castsi256_si128(aggregate_height), _mm256_castsi256_si128(holes),
+                               _mm256_castsi256_si128(transitions), _mm256_castsi256_si128(max_height), weights));
+        _mm256_storeu_ps(scores + lane + 8,
+                         Score(_mm256_extracti128_si256(aggregate_height, 1), _mm256_extracti128_si256(holes, 1),
+                               _mm256_extracti128_si256(transitions, 1), _mm256_extracti128_si256(max_height, 1),
+                               weights));
+    }
+    return lanes;
+}
@@ -0,0 +1,57 @@
+#include "BoardEval.h"
+#include <emmintrin.h>
+
+// The SSE2 kernel: 8 boards per register, one 16-bit lane each.
+
+namespace {
+
+// Counts the set bits of every 16-bit lane.
+inline __m128i CountBits(__m128i x) {
+    x = _mm_sub_epi16(x, _mm_and_si128(_mm_srli_epi16(x, 1), _mm_set1_epi16(0x5555)));
+    x = _mm_add_epi16(_mm_and_si128(x, _mm_set1_epi16(0x3333)),
+                      _mm_and_si128(_mm_srli_epi16(x, 2), _mm_set1_epi16(0x3333)));
+    x = _mm_and_si128(_mm_add_epi16(x, _mm_srli_epi16(x, 4)), _mm_set1_epi16(0x0F0F));
+    return _mm_and_si128(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), _mm_set1_epi16(0x1F));
+}
+
+// Weights four boards' features (32-bit lanes) in the scalar kernel's order.
+inline __m128 Score(__m128i aggregate_height, __m128i holes, __m128i transitions, __m128i max_height,
+                    const EvalWeights& weights) {
+    __m128 score = _mm_mul_ps(_mm_cvtepi32_ps(aggregate_height), _mm_set1_ps(weights.aggregate_height));
+    score = _mm_add_ps(score, _mm_mul_ps(_mm_cvtepi32_ps(holes), _mm_set1_ps(weights.holes)));
+    score = _mm_add_ps(score, _mm_mul_ps(_mm_cvtepi32_ps(transitions), _mm_set1_ps(weights.row_transitions)));
+    return _mm_add_ps(score, _mm_mul_ps(_mm_cvtepi32_ps(max_height), _mm_set1_ps(weights.max_height)));
+}
+
+} // namespace
+
+int EvaluateBatchSse2(const BoardBatch& batch, const EvalWeights& weights, float* scores) {
+    const int width = 8;
+    const int lanes = batch.count - batch.count % width;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i play_mask = _mm_set1_epi16(static_cast<short>(((1u << (LOGICAL_BOARD_WIDTH - 2)) - 1) << 1));
+    const __m128i pair_mask = _mm_set1_epi16(static_cast<short>((1u << (LOGICAL_BOARD_WIDTH - 1)) - 1));
+
+    for (int lane = 0; lane < lanes; lane += width) {
+        __m128i covered = zero, aggregate_height = zero, holes = zero, transitions = zero, empty_rows = zero;
+        for (int y = 0; y < BoardBatch::PLAY_HEIGHT; ++y) {
+            __m128i row = _mm_load_si128(reinterpret_cast<const __m128i*>(&batch.rows[y][lane]));
+            covered = _mm_or_si128(covered, _mm_and_si128(row, play_mask));
+            aggregate_height = _mm_add_epi16(aggregate_height, CountBits(covered));
+            holes = _mm_add_epi16(holes, CountBits(_mm_andnot_si128(row, covered)));
+            empty_rows = _mm_sub_epi16(empty_rows, _mm_cmpeq_epi16(covered, zero)); // cmpeq is -1 per match.
+            __m128i pairs = _mm_xor_si128(row, _mm_srli_epi16(row, 1));
+            transitions = _mm_add_epi16(transitions, CountBits(_mm_and_si128(pairs, pair_mask)));
+        }
+        __m128i max_height = _mm_sub_epi16(_mm_set1_epi16(BoardBatch::PLAY_HEIGHT), empty_rows);
+
+        // Every count is small and positive, so zero-extending to 32 bits is enough.
+        _mm_storeu_ps(scores + lane,
+                      Score(_mm_unpacklo_epi16(aggregate_height, zero), _mm_unpacklo_epi16(holes, zero),
+                            _mm_unpacklo_epi16(transitions, zero), _mm_unpacklo_epi16(max_height, zero), weights));
+        _mm_storeu_ps(scores + lane + 4,
+                      Score(_mm_unpackhi_epi16(aggregate_height, zero), _mm_unpackhi_epi16(holes, zero),
+                            _mm_unpackhi_epi16(transitions, zero), _mm_unpackhi_epi16(max_height, zero), weights));
+    }
+    return lanes;
+}
@@ -0,0 +1,95 @@
+#include "BoardView.h"
+#include <cstring>
+
+// This is the core visual engine. It draws every block and empty space on the grid.
+template <class Board>
+void DrawPlayfield(Renderer& renderer, const BasicGameState<Board>& state, int flash_phase) {
+    const Board& board = state.board;
+    const int width = board.Width();
+
+    // The row just above the visible ones is drawn too (like the ceiling on
+    // the classic board), so a piece that is spawning can be seen.
+    const int top = board.FirstVisibleRow() - 1;
+    const int floorY = board.Height() - 1 - top;
+
+    // The ghost: where the piece would land if it were hard dropped now.
+    const Position& pos = state.current_pos;
+    const Piece& piece = state.current_piece;
+    bool show_ghost = !state.is_game_over && !board.Collides(piece.Mask(), pos.x, pos.y);
+    Position ghost = show_ghost ? LandingPosition(board, piece, pos) : pos;
+
+    for (int y = top; y < board.Height() - 1; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const char* displayStr = "  ";
+            bool isPieceCell = false;
+
+            // 1. Check if the falling piece is currently over this (x, y) spot.
+            if (x >= pos.x && x < pos.x + 4 && y >= pos.y && y < pos.y + 4) {
+                if (piece.HasCell(x - pos.x, y - pos.y)) {
+                    displayStr = "[]";
+                    isPieceCell = true;
+                }
+            }
+
+            // 2. Or its ghost, drawn hollow so it can't be mistaken for a block.
+            if (!isPieceCell && show_ghost && x >= ghost.x && x < ghost.x + 4 && y >= ghost.y && y < ghost.y + 4) {
+                if (piece.HasCell(x - ghost.x, y - ghost.y)) {
+                    displayStr = "::";
+                    isPieceCell = true;
+                }
+            }
+
+            // 3. If no falling piece is here, check what is stored in the board data.
+            if (!isPieceCell) {
+                int cellValue = board.Color(x, y);
+
+                // Check for line-clearing animation (flashing).
+                if (state.is_clearing_lines && (state.lines_to_clear & (RowSet(1) << y))) {
+                    // Swap between "##" and " ." every 100ms to create a flash effect.
+                    displayStr = flash_phase == 0 ? "##" : " .";
+                }
+                // Draw walls and bottom edges.
+                else if (cellValue == WALL_CELL) {
+                    if (y == top) displayStr = "  "; // Keep top invisible so pieces can spawn.
+                    else if (x == 0) displayStr = "<!"; // Left wall.
+                    else if (x == width - 1) displayStr = "!>"; // Right wall.
+                }
+                // Draw an empty spot.
+                else if (cellValue == 0) {
+                    displayStr = " .";
+                }
+                // Draw a locked block that landed previously.
+                else {
+                    displayStr = "[]";
+                }
+            }
+            renderer.Put(x * 2, y - top, displayStr);
+        }
+    }
+    // Draw the fancy floor at the very bottom, as wide as the board.
+    // Boards are at most 61 cells wide, so each line fits in 2 * 64 characters.
+    char floor_line[2 * 64 + 1];
+    char edge_line[2 * 64 + 1];
+    int length = 0;
+    for (int x = 0; x < width; ++x, length += 2) {
+        const char* floor_cell = (x == 0) ? "<!" : (x == width - 1) ? "!>" : "==";
+        const char* edge_cell = (x == 0 || x == width - 1) ? "  " : "\\/";
+        std::memcpy(floor_line + length, floor_cell, 2);
+        std::memcpy(edge_line + length, edge_cell, 2);
+    }
+    floor_line[length] = '\0';
+    edge_line[length - 2] = '\0'; // No trailing blanks after the last "\/".
+    renderer.Put(0, floorY, floor_line);
+    renderer.Put(0, floorY + 1, edge_line);
+}
+
+template void DrawPlayfield(Renderer&, const BasicGameState<Bitboard>&, int);
+template void DrawPlayfield(Renderer&, const BasicGameState<TallBitboard>&, int);
+template void DrawPlayfield(Renderer&, const BasicGameState<WideBitboard>&, int);
+template void DrawPlayfield(Renderer&, const BasicGameState<DynamicBitboard>&, int);
+
+const char* HudModeTitle(GameMode mode) {
+    static const char* const TITLES[GAME_MODE_COUNT] = {"CLASSIC", "MARATHON", "SPRINT 40L", "ULTRA 2MIN"};
+    int index = static_cast<int>(mode);
+    return (index >= 0 && index < GAME_MODE_COUNT) ? TITLES[index] : "";
+}
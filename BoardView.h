@@ -0,0 +1,32 @@
+#ifndef TETRIS_BOARD_VIEW_H
+#define TETRIS_BOARD_VIEW_H
+
+#include "Engine.h"
+#include "Renderer.h"
+
+// Draws the playfield of 'state' (walls, locked blocks, the falling piece,
+// the line-clear flash and the floor) into the renderer's back buffer,
+// starting at the top-left corner. Rows in a buffer zone are left out.
+// 'flash_phase' (0 or 1) picks which half of the flash to show.
+// It only reads the state, so benchmarks can draw boards without a console.
+// Built for every board the engine is built for (BoardView.cpp).
+template <class Board>
+void DrawPlayfield(Renderer& renderer, const BasicGameState<Board>& state, int flash_phase);
+
+// How much screen DrawPlayfield covers: two characters per cell across, and
+// the visible rows plus the two lines of the floor down.
+template <class Board>
+inline int PlayfieldScreenWidth(const Board& board) {
+    return board.Width() * 2;
+}
+
+template <class Board>
+inline int PlayfieldScreenHeight(const Board& board) {
+    return board.Height() - board.FirstVisibleRow() + 2;
+}
+
+// The mode as the HUD names it, e.g. "SPRINT 40L". Shared by the game and
+// tetris_viewer so both title a run the same way.
+const char* HudModeTitle(GameMode mode);
+
+#endif
@@ -0,0 +1,283 @@
+#include "Bot.h"
+#include <cstdlib>
+#include "Profiler.h"
+
+namespace {
+
+// A piece's 4x4 box can hang up to 3 columns past the left edge, and
+// Bitboard::Collides gives up on anything at x >= 16.
+const int X_MIN = -3;
+const int X_SPAN = 19;
+const int NODE_COUNT = ROTATION_COUNT * GAME_BOARD_HEIGHT * X_SPAN;
+
+// More than any piece can ever have: 4 rotations x 10 columns plus tucks.
+const int MAX_PLACEMENTS = 128;
+
+// Every play cell of a row (no walls, nothing past the right wall).
+const RowMask PLAY_MASK = static_cast<RowMask>(~WALL_ROW_MASK);
+
+// Actions in the order the search tries them. Sideways moves come before
+// soft drops, so paths tend to line up first and drop last. The classic rules
+// only turn one way. SRS kicks differ by direction, so turning back can reach
+// spots turning forward can't; 180 turns are left out, two quarter turns get
+// to nearly all the same spots for a third fewer tests per node.
+const Action CLASSIC_SEARCH_ACTIONS[] = {Action::Rotate, Action::MoveLeft, Action::MoveRight, Action::SoftDrop};
+const Action SRS_SEARCH_ACTIONS[] = {Action::Rotate, Action::RotateCCW,
+                                     Action::MoveLeft, Action::MoveRight, Action::SoftDrop};
+
+// Quarter turns clockwise for each rotate action (0 = not a rotation).
+int TurnsFor(Action action) {
+    switch (action) {
+        case Action::Rotate:    return 1;
+        case Action::Rotate180: return 2;
+        case Action::RotateCCW: return 3;
+        default:                return 0;
+    }
+}
+
+int NodeIndex(int rotation, int x, int y) {
+    return (rotation * GAME_BOARD_HEIGHT + y) * X_SPAN + (x - X_MIN);
+}
+
+int NodeRotation(int index) { return index / (GAME_BOARD_HEIGHT * X_SPAN); }
+int NodeY(int index) { return (index / X_SPAN) % GAME_BOARD_HEIGHT; }
+int NodeX(int index) { return index % X_SPAN + X_MIN; }
+
+int CountBits(uint32_t bits) {
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1) ++count;
+    return count;
+}
+
+// The cells a resting piece covers, in a form where two different
+// (rotation, x, y) that cover the same cells compare equal.
+struct Footprint {
+    int top;
+    uint64_t rows;
+
+    bool operator==(const Footprint& other) const { return top == other.top && rows == other.rows; }
+};
+
+Footprint MakeFootprint(const PieceMask& mask, int x, int y) {
+    Footprint footprint = {-1, 0};
+    int packed = 0;
+    for (int py = 0; py < 4; ++py) {
+        uint32_t bits = mask.rows[py];
+        if (bits == 0 && footprint.top < 0) continue; // Skip empty rows above the piece.
+        if (footprint.top < 0) footprint.top = y + py;
+        bits = (x >= 0) ? (bits << x) : (bits >> -x);
+        footprint.rows |= static_cast<uint64_t>(bits & 0xFFFF) << (16 * packed++);
+    }
+    return footprint;
+}
+
+// A breadth-first search over every (rotation, x, y) a piece can reach from
+// its start, using the same moves (and wall kicks) the engine allows.
+// Big enough that it lives on the stack of whichever thread runs it.
+struct Search {
+    uint16_t parent[NODE_COUNT];
+    Action action[NODE_COUNT];
+    bool seen[NODE_COUNT];
+    uint16_t queue[NODE_COUNT];
+
+    // Nodes where the piece can't fall any further, one per distinct footprint.
+    uint16_t landings[MAX_PLACEMENTS];
+    Footprint footprints[MAX_PLACEMENTS];
+    int landing_count = 0;
+
+    void Run(const Bitboard& board, Piece piece, Position start, RotationSystem system) {
+        landing_count = 0;
+        if (board.Collides(piece.Mask(), start.x, start.y)) return;
+
+        for (bool& flag : seen) flag = false;
+        int head = 0;
+        int tail = 0;
+        int first = NodeIndex(piece.rotation, start.x, start.y);
+        seen[first] = true;
+        parent[first] = static_cast<uint16_t>(first);
+        action[first] = Action::None;
+        queue[tail++] = static_cast<uint16_t>(first);
+
+        bool is_srs = (system == RotationSystem::SRS);
+        const Action* actions = is_srs ? SRS_SEARCH_ACTIONS : CLASSIC_SEARCH_ACTIONS;
+        int action_count = is_srs ? sizeof(SRS_SEARCH_ACTIONS) / sizeof(Action)
+                                  : sizeof(CLASSIC_SEARCH_ACTIONS) / sizeof(Action);
+
+        while (head < tail) {
+            int index = queue[head++];
+            Piece current = {piece.type, static_cast<uint8_t>(NodeRotation(index))};
+            Position pos = {NodeX(index), NodeY(index)};
+            const PieceMask& mask = current.Mask();
+
+            for (int a = 0; a < action_count; ++a) {
+                Action move = actions[a];
+                Piece next_piece = current;
+                Position next = pos;
+                if (int turns = TurnsFor(move)) {
+                    if (RotateWithKicks(board, system, next_piece, next, turns) < 0) continue;
+                    // An SRS floor kick can lift a piece whose top rows are
+                    // empty above row 0. Those spots have no node.
+                    if (next.y < 0) continue;
+                } else {
+                    next.x += (move == Action::MoveLeft) ? -1 : (move == Action::MoveRight) ? 1 : 0;
+                    next.y += (move == Action::SoftDrop) ? 1 : 0;
+                    if (board.Collides(mask, next.x, next.y)) {
+                        if (move == Action::SoftDrop) AddLanding(index, mask, pos);
+                        continue;
+                    }
+                }
+
+                int next_index = NodeIndex(next_piece.rotation, next.x, next.y);
+                if (seen[next_index]) continue;
+                seen[next_index] = true;
+                parent[next_index] = static_cast<uint16_t>(index);
+                action[next_index] = move;
+                queue[tail++] = static_cast<uint16_t>(next_index);
+            }
+        }
+    }
+
+    void AddLanding(int index, const PieceMask& mask, Position pos) {
+        Footprint footprint = MakeFootprint(mask, pos.x, pos.y);
+        for (int i = 0; i < landing_count; ++i) {
+            if (footprints[i] == footprint) return; // Same cells, reached another way.
+        }
+        if (landing_count == MAX_PLACEMENTS) return;
+        footprints[landing_count] = footprint;
+        landings[landing_count++] = static_cast<uint16_t>(index);
+    }
+
+    // Writes the actions from the start to 'landing' into 'move', finishing
+    // with a hard drop. Returns false if the path doesn't fit.
+    bool BuildPath(int landing, BotMove& move) const {
+        int length = 0;
+        for (int index = landing; parent[index] != index; index = parent[index]) ++length;
+
+        // Soft drops right before the hard drop are pointless: it lands in the same spot.
+        int index = landing;
+        while (parent[index] != index && action[index] == Action::SoftDrop) {
+            index = parent[index];
+            --length;
+        }
+        if (length + 1 > BotMove::MAX_ACTIONS) return false;
+
+        move.action_count = length + 1;
+        move.actions[length] = Action::HardDrop;
+        for (int i = length - 1; i >= 0; --i) {
+            move.actions[i] = action[index];
+            index = parent[index];
+        }
+        return true;
+    }
+};
+
+// Worse than any board the heuristic can produce.
+const double LOSING_SCORE = -1e18;
+
+} // namespace
+
+Bot::Bot(int thread_count, const BotWeights& bot_weights)
+    : pool(thread_count), weights(bot_weights),
+      candidates(MAX_PLACEMENTS), scores(MAX_PLACEMENTS), counts(MAX_PLACEMENTS) {}
+
+int Bot::PlaceAndClear(Bitboard& board, Piece piece, Position pos) {
+    RowSet touched = board.Place(piece.Mask(), pos.x, pos.y, static_cast<uint8_t>(piece.Id()));
+    RowSet cleared = board.FullRows(touched);
+    if (cleared == 0) return 0;
+
+    board.RemoveRows(cleared);
+    int lines = 0;
+    for (; cleared != 0; cleared &= cleared - 1) lines++;
+    return lines;
+}
+
+int Bot::FindPlacements(const Bitboard& board, Piece piece, Position start, BotMove* out, int capacity,
+                        RotationSystem system) {
+    Search search;
+    search.Run(board, piece, start, system);
+
+    int count = 0;
+    for (int i = 0; i < search.landing_count && count < capacity; ++i) {
+        int landing = search.landings[i];
+        BotMove& move = out[count];
+        move.piece = {piece.type, static_cast<uint8_t>(NodeRotation(landing))};
+        move.pos = {NodeX(landing), NodeY(landing)};
+        move.score = 0.0;
+        if (search.BuildPath(landing, move)) count++;
+    }
+    return count;
+}
+
+double Bot::Evaluate(const Bitboard& board, int lines, const BotWeights& bot_weights) {
+    // The board keeps every column's height up to date.
+    int aggregate_height = 0;
+    int bumpiness = 0;
+    int highest_top = GAME_BOARD_HEIGHT - 1;
+    for (int x = 1; x < LOGICAL_BOARD_WIDTH - 1; ++x) {
+        aggregate_height += board.ColumnHeight(x);
+        if (x > 1) bumpiness += std::abs(board.ColumnHeight(x) - board.ColumnHeight(x - 1));
+        if (board.ColumnTop(x) < highest_top) highest_top = board.ColumnTop(x);
+    }
+
+    // A hole is an empty cell under its column's top. The heights add up
+    // every cell from the tops down, so the holes are whatever of that isn't a block.
+    int blocks = 0;
+    for (int y = highest_top; y < GAME_BOARD_HEIGHT - 1; ++y) {
+        blocks += CountBits(board.rows[y] & PLAY_MASK);
+    }
+    int holes = aggregate_height - blocks;
+
+    return bot_weights.lines * lines + bot_weights.aggregate_height * aggregate_height +
+           bot_weights.holes * holes + bot_weights.bumpiness * bumpiness;
+}
+
+bool Bot::FindBestMove(const GameState& state, BotMove& move) {
+    TETRIS_PROFILE_SCOPE("Bot::FindBestMove");
+    if (state.is_game_over) return false;
+
+    int count = FindPlacements(state.board, state.current_piece, state.current_pos,
+                               candidates.data(), MAX_PLACEMENTS, state.rotation_system);
+    if (count == 0) return false;
+
+    Piece next_piece = PeekPiece(state, 0);
+
+    // Each first placement is scored by the best follow-up for the next piece.
+    pool.ParallelFor(count, [&](int i) {
+        TETRIS_PROFILE_SCOPE("Bot candidate");
+        Bitboard board = state.board;
+        int lines = PlaceAndClear(board, candidates[i].piece, candidates[i].pos);
+
+        Search search;
+        search.Run(board, next_piece, SpawnPosition(board), state.rotation_system);
+        if (search.landing_count == 0) {
+            // The next piece can't even spawn: this move loses the game.
+            scores[i] = LOSING_SCORE;
+            counts[i] = 1;
+            return;
+        }
+
+        double best = LOSING_SCORE;
+        for (int j = 0; j < search.landing_count; ++j) {
+            int landing = search.landings[j];
+            Bitboard after = board;
+            Piece piece = {next_piece.type, static_cast<uint8_t>(NodeRotation(landing))};
+            int next_lines = PlaceAndClear(after, piece, {NodeX(landing), NodeY(landing)});
+
+            double score = Evaluate(after, lines + next_lines, weights);
+            if (score > best) best = score;
+        }
+        scores[i] = best;
+        counts[i] = static_cast<uint64_t>(search.landing_count);
+    });
+
+    // Ties go to the earliest candidate, so the choice never depends on threads.
+    int best = 0;
+    for (int i = 0; i < count; ++i) {
+        placements_evaluated += counts[i];
+        if (scores[i] > scores[best]) best = i;
+    }
+
+    move = candidates[best];
+    move.score = scores[best];
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef TETRIS_BOT_H
+#define TETRIS_BOT_H
+
+#include <cstdint>
+#include <vector>
+#include "Engine.h"
+#include "ThreadPool.h"
+
+// How much the bot cares about each feature of a board. Positive weights are
+// good, negative ones bad; the defaults are a well-known hand-tuned set.
+struct BotWeights {
+    double lines = 0.760666;             // Lines cleared by the placements.
+    double aggregate_height = -0.510066; // Sum of all column heights.
+    double holes = -0.35663;             // Empty cells with a block somewhere above them.
+    double bumpiness = -0.184483;        // Sum of height differences between neighbours.
+};
+
+// One way to put the current piece down, plus the actions that get it there.
+struct BotMove {
+    static const int MAX_ACTIONS = 64;
+
+    Piece piece;                  // The rotation it lands in.
+    Position pos;                 // Where it lands.
+    Action actions[MAX_ACTIONS];  // Always ends with a HardDrop.
+    int action_count = 0;
+    double score = 0.0;
+};
+
+// An autoplayer. For every spot the current piece can reach (moving, soft
+// dropping and rotating with the engine's own wall kicks, so tucks and kicks
+// count), it also tries every spot the next piece can reach afterwards and
+// keeps the pair with the best heuristic score. The first-piece candidates
+// are searched in parallel on a thread pool.
+class Bot {
+public:
+    // 0 threads = one per hardware core.
+    explicit Bot(int thread_count = 0, const BotWeights& weights = BotWeights());
+
+    BotWeights& Weights() { return weights; }
+
+    // Picks the best move for state.current_piece. Returns false when the
+    // game is over or the piece can't go anywhere.
+    bool FindBestMove(const GameState& state, BotMove& move);
+
+    // How many final boards have been scored since the bot was created.
+    uint64_t PlacementsEvaluated() const { return placements_evaluated; }
+
+    // Lists every distinct resting spot of 'piece' starting from 'start' on
+    // 'board' under 'system's rotation rules. Moves that end up covering the
+    // same cells count once. Returns how many were written to 'out' (at most
+    // 'capacity').
+    static int FindPlacements(const Bitboard& board, Piece piece, Position start,
+                              BotMove* out, int capacity,
+                              RotationSystem system = RotationSystem::Classic);
+
+    // Locks the piece into 'board' and removes any lines it completes.
+    // Returns how many lines that was.
+    static int PlaceAndClear(Bitboard& board, Piece piece, Position pos);
+
+    // Scores a board after 'lines' lines were cleared to reach it.
+    static double Evaluate(const Bitboard& board, int lines, const BotWeights& weights);
+
+private:
+    ThreadPool pool;
+    BotWeights weights;
+
+    // Per-search scratch space, kept between calls so searching doesn't allocate.
+    std::vector<BotMove> candidates;
+    std::vector<double> scores;
+    std::vector<uint64_t> counts;
+    uint64_t placements_evaluated = 0;
+};
+
+#endif
@@ -0,0 +1,509 @@
+#include "Broadcast.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+// --- The shared block ---
+
+namespace {
+
+const uint32_t BROADCAST_MAGIC = 0x42535254; // "TRSB"
+const uint32_t BROADCAST_VERSION = 2;
+
+// Which parts of the view a record carries.
+const uint8_t FIELD_ROWS = 1;
+const uint8_t FIELD_PIECE = 2;
+const uint8_t FIELD_HOLD = 4;
+const uint8_t FIELD_PREVIEW = 8;
+const uint8_t FIELD_STATS = 16;
+const uint8_t FIELD_STATUS = 32;
+const uint8_t FIELD_SPLITS = 64;
+const uint8_t ALL_FIELDS = 127;
+
+// The play rows; the ceiling and floor rows never change.
+const int FIRST_ROW = 1;
+const int LAST_ROW = GAME_BOARD_HEIGHT - 2;
+const int PACKED_ROW_SIZE = (BroadcastView::PLAY_WIDTH + 1) / 2;
+
+// The biggest record there is: a keyframe, with every field and every row.
+const size_t MAX_RECORD_SIZE = 1 + 3 + 2 + (1 + BroadcastView::MAX_PREVIEW) + 28 + 6 +
+                               (1 + 4 * BroadcastView::MAX_SPLITS) + 4 +
+                               (LAST_ROW - FIRST_ROW + 1) * PACKED_ROW_SIZE;
+const int RECORD_WORDS = static_cast<int>((MAX_RECORD_SIZE + 7) / 8);
+
+static_assert(GAME_BOARD_HEIGHT <= 32, "a record sends its changed rows as a 32-bit set");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "the shared block needs atomics that work across processes");
+
+} // namespace
+
+// One record (or the keyframe) behind a sequence lock. The stamp is 2n+1
+// while the writer fills in record n and 2n+2 once it's done; a reader copies
+// the words out and keeps them only if the stamp was even and didn't move.
+// The words are atomics too, so a reader racing the writer reads stale
+// bytes (and throws them away) rather than causing undefined behaviour.
+struct BroadcastSlot {
+    std::atomic<uint64_t> stamp;
+    std::atomic<uint64_t> sequence;   // Keyframe only: the record that comes after it.
+    std::atomic<uint32_t> size;
+    std::atomic<uint64_t> words[RECORD_WORDS];
+};
+
+struct BroadcastRing {
+    // Written once before is_live is set, then only read.
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t record_words;
+
+    std::atomic<uint32_t> is_live;    // 1 while the game is broadcasting.
+    std::atomic<uint64_t> published;  // Records 0 .. published-1 are complete.
+    BroadcastSlot keyframe;
+    BroadcastSlot slots[BroadcastPublisher::SLOT_COUNT];
+};
+
+namespace {
+
+void WriteSlot(BroadcastSlot& slot, uint64_t version, uint64_t sequence, const uint8_t* bytes, size_t size) {
+    slot.stamp.store(2 * version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.sequence.store(sequence, std::memory_order_relaxed);
+    slot.size.store(static_cast<uint32_t>(size), std::memory_order_relaxed);
+    for (size_t w = 0; w * 8 < size; ++w) {
+        uint64_t word = 0;
+        for (size_t b = 0; b < 8 && w * 8 + b < size; ++b) word |= static_cast<uint64_t>(bytes[w * 8 + b]) << (8 * b);
+        slot.words[w].store(word, std::memory_order_relaxed);
+    }
+
+    slot.stamp.store(2 * version + 2, std::memory_order_release);
+}
+
+// Copies a slot out. False if the writer was busy with it meanwhile.
+bool ReadSlot(const BroadcastSlot& slot, uint64_t& stamp, uint64_t& sequence, uint8_t* bytes, size_t& size) {
+    stamp = slot.stamp.load(std::memory_order_acquire);
+    if (stamp & 1) return false;
+
+    sequence = slot.sequence.load(std::memory_order_relaxed);
+    size = slot.size.load(std::memory_order_relaxed);
+    if (size > MAX_RECORD_SIZE) size = MAX_RECORD_SIZE; // Torn; the stamp check below throws it away.
+    for (size_t w = 0; w * 8 < size; ++w) {
+        uint64_t word = slot.words[w].load(std::memory_order_relaxed);
+        for (size_t b = 0; b < 8 && w * 8 + b < size; ++b) bytes[w * 8 + b] = static_cast<uint8_t>(word >> (8 * b));
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.stamp.load(std::memory_order_relaxed) == stamp;
+}
+
+// --- Records ---
+
+// Little-endian fields into a fixed buffer (records never outgrow MAX_RECORD_SIZE).
+struct RecordWriter {
+    uint8_t* out;
+    size_t size = 0;
+
+    void U8(uint32_t value) { out[size++] = static_cast<uint8_t>(value); }
+    void U16(uint32_t value) {
+        U8(value);
+        U8(value >> 8);
+    }
+    void U32(uint32_t value) {
+        U16(value);
+        U16(value >> 16);
+    }
+};
+
+// Reading past the end returns zeros and clears ok, like MessageReader.
+struct RecordReader {
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+    bool ok = true;
+
+    uint8_t U8() {
+        if (offset >= size) {
+            ok = false;
+            return 0;
+        }
+        return data[offset++];
+    }
+    uint16_t U16() {
+        uint16_t low = U8();
+        return static_cast<uint16_t>(low | (U8() << 8));
+    }
+    uint32_t U32() {
+        uint32_t low = U16();
+        return low | (static_cast<uint32_t>(U16()) << 16);
+    }
+};
+
+// Writes the parts of 'after' that differ from 'before' (everything, for a
+// keyframe, when 'before' is null). Returns the record's size, 0 if nothing
+// changed.
+size_t EncodeRecord(const BroadcastView* before, const BroadcastView& after, uint8_t* out) {
+    RowSet rows = 0;
+    for (int y = FIRST_ROW; y <= LAST_ROW; ++y) {
+        if (!before || std::memcmp(before->cells[y], after.cells[y], BroadcastView::PLAY_WIDTH) != 0) {
+            rows |= RowSet(1) << y;
+        }
+    }
+
+    uint8_t fields = rows != 0 ? FIELD_ROWS : 0;
+    if (!before) {
+        fields = ALL_FIELDS;
+    } else {
+        if (before->piece.type != after.piece.type || before->piece.rotation != after.piece.rotation ||
+            before->pos.x != after.pos.x || before->pos.y != after.pos.y) {
+            fields |= FIELD_PIECE;
+        }
+        if (before->held_type != after.held_type || before->can_hold != after.can_hold) fields |= FIELD_HOLD;
+        if (before->preview_count != after.preview_count ||
+            std::memcmp(before->preview, after.preview, sizeof(after.preview)) != 0) {
+            fields |= FIELD_PREVIEW;
+        }
+        if (before->score != after.score || before->lines != after.lines || before->level != after.level ||
+            before->high_score != after.high_score || before->mode != after.mode ||
+            before->combo != after.combo || before->time_ms != after.time_ms ||
+            before->best_time_ms != after.best_time_ms || before->pieces_per_second != after.pieces_per_second ||
+            before->keys_per_piece != after.keys_per_piece) {
+            fields |= FIELD_STATS;
+        }
+        if (before->split_count != after.split_count ||
+            std::memcmp(before->splits_ms, after.splits_ms, sizeof(after.splits_ms)) != 0) {
+            fields |= FIELD_SPLITS;
+        }
+        if (before->flags != after.flags || before->spin != after.spin ||
+            before->lines_to_clear != after.lines_to_clear) {
+            fields |= FIELD_STATUS;
+        }
+    }
+    if (fields == 0) return 0;
+
+    RecordWriter record{out};
+    record.U8(fields);
+    if (fields & FIELD_PIECE) {
+        record.U8(after.piece.type | (after.piece.rotation << 4));
+        record.U8(static_cast<uint8_t>(static_cast<int8_t>(after.pos.x)));
+        record.U8(static_cast<uint8_t>(static_cast<int8_t>(after.pos.y)));
+    }
+    if (fields & FIELD_HOLD) {
+        record.U8(static_cast<uint8_t>(after.held_type));
+        record.U8(after.can_hold ? 1 : 0);
+    }
+    if (fields & FIELD_PREVIEW) {
+        record.U8(after.preview_count);
+        for (uint8_t type : after.preview) record.U8(type);
+    }
+    if (fields & FIELD_STATS) {
+        record.U32(static_cast<uint32_t>(after.score));
+        record.U32(static_cast<uint32_t>(after.lines));
+        record.U16(static_cast<uint32_t>(after.level));
+        record.U32(static_cast<uint32_t>(after.high_score));
+        record.U8(static_cast<uint8_t>(after.mode));
+        record.U8(static_cast<uint8_t>(static_cast<int8_t>(std::min(after.combo, 127))));
+        record.U32(after.time_ms);
+        record.U32(after.best_time_ms);
+        record.U16(after.pieces_per_second);
+        record.U16(after.keys_per_piece);
+    }
+    if (fields & FIELD_SPLITS) {
+        record.U8(after.split_count);
+        int shown = std::min<int>(after.split_count, BroadcastView::MAX_SPLITS);
+        for (int i = 0; i < shown; ++i) record.U32(after.splits_ms[i]);
+    }
+    if (fields & FIELD_STATUS) {
+        record.U8(after.flags);
+        record.U8(static_cast<uint8_t>(after.spin));
+        record.U32(static_cast<uint32_t>(after.lines_to_clear));
+    }
+    if (fields & FIELD_ROWS) {
+        record.U32(static_cast<uint32_t>(rows));
+        for (int y = FIRST_ROW; y <= LAST_ROW; ++y) {
+            if (!(rows & (RowSet(1) << y))) continue;
+            // Two cells per byte: colors only go up to GARBAGE_CELL.
+            for (int x = 0; x < BroadcastView::PLAY_WIDTH; x += 2) {
+                uint8_t high = (x + 1 < BroadcastView::PLAY_WIDTH) ? after.cells[y][x + 1] : 0;
+                record.U8(after.cells[y][x] | (high << 4));
+            }
+        }
+    }
+    return record.size;
+}
+
+// The other way round. False (with 'view' partly updated) if the record is malformed.
+bool ApplyRecord(const uint8_t* data, size_t size, BroadcastView& view) {
+    RecordReader record{data, size};
+    uint8_t fields = record.U8();
+    if (fields & ~ALL_FIELDS) return false;
+
+    if (fields & FIELD_PIECE) {
+        uint8_t piece = record.U8();
+        view.piece.type = piece & 0x0F;
+        view.piece.rotation = (piece >> 4) & 0x03;
+        view.pos.x = static_cast<int8_t>(record.U8());
+        view.pos.y = static_cast<int8_t>(record.U8());
+        if (view.piece.type >= PIECE_TYPE_COUNT) return false;
+    }
+    if (fields & FIELD_HOLD) {
+        view.held_type = static_cast<int8_t>(record.U8());
+        view.can_hold = record.U8() != 0;
+        if (view.held_type >= PIECE_TYPE_COUNT) return false;
+    }
+    if (fields & FIELD_PREVIEW) {
+        view.preview_count = record.U8();
+        for (uint8_t& type : view.preview) {
+            type = record.U8();
+            if (type >= PIECE_TYPE_COUNT) return false;
+        }
+        if (view.preview_count > BroadcastView::MAX_PREVIEW) return false;
+    }
+    if (fields & FIELD_STATS) {
+        view.score = static_cast<int>(record.U32());
+        view.lines = static_cast<int>(record.U32());
+        view.level = record.U16();
+        view.high_score = static_cast<int>(record.U32());
+        uint8_t mode = record.U8();
+        if (mode >= GAME_MODE_COUNT) return false;
+        view.mode = static_cast<GameMode>(mode);
+        view.combo = static_cast<int8_t>(record.U8());
+        if (view.combo < -1) return false;
+        view.time_ms = record.U32();
+        view.best_time_ms = record.U32();
+        view.pieces_per_second = record.U16();
+        view.keys_per_piece = record.U16();
+    }
+    if (fields & FIELD_SPLITS) {
+        view.split_count = record.U8();
+        int shown = std::min<int>(view.split_count, BroadcastView::MAX_SPLITS);
+        for (int i = 0; i < BroadcastView::MAX_SPLITS; ++i) view.splits_ms[i] = (i < shown) ? record.U32() : 0;
+    }
+    if (fields & FIELD_STATUS) {
+        view.flags = record.U8();
+        uint8_t spin = record.U8();
+        if (spin > static_cast<uint8_t>(SpinType::Full)) return false;
+        view.spin = static_cast<SpinType>(spin);
+        view.lines_to_clear = record.U32();
+    }
+    if (fields & FIELD_ROWS) {
+        RowSet rows = record.U32();
+        const RowSet play_rows = ((RowSet(1) << (LAST_ROW + 1)) - 1) & ~((RowSet(1) << FIRST_ROW) - 1);
+        if (rows & ~play_rows) return false;
+        for (int y = FIRST_ROW; y <= LAST_ROW; ++y) {
+            if (!(rows & (RowSet(1) << y))) continue;
+            for (int x = 0; x < BroadcastView::PLAY_WIDTH; x += 2) {
+                uint8_t packed = record.U8();
+                view.cells[y][x] = packed & 0x0F;
+                if (x + 1 < BroadcastView::PLAY_WIDTH) view.cells[y][x + 1] = packed >> 4;
+            }
+        }
+    }
+    return record.ok && record.offset == size;
+}
+
+} // namespace
+
+// --- BroadcastView ---
+
+void BroadcastView::Reset() {
+    std::memset(cells, 0, sizeof(cells));
+    piece = Piece();
+    pos = Position{-8, -8}; // Off screen until there is a piece.
+    held_type = -1;
+    can_hold = true;
+    std::memset(preview, 0, sizeof(preview));
+    preview_count = 0;
+    score = 0;
+    lines = 0;
+    level = 1;
+    high_score = 0;
+    spin = SpinType::None;
+    flags = 0;
+    lines_to_clear = 0;
+    mode = GameMode::Classic;
+    combo = -1;
+    time_ms = 0;
+    best_time_ms = 0;
+    pieces_per_second = 0;
+    keys_per_piece = 0;
+    split_count = 0;
+    std::memset(splits_ms, 0, sizeof(splits_ms));
+}
+
+void BroadcastView::Capture(const GameState& state) {
+    for (int y = FIRST_ROW; y <= LAST_ROW; ++y) {
+        std::memcpy(cells[y], state.board.ColorRow(y) + 1, PLAY_WIDTH);
+    }
+    piece = state.current_piece;
+    pos = state.current_pos;
+    held_type = static_cast<int8_t>(state.held_type);
+    can_hold = state.can_hold;
+    for (int i = 0; i < MAX_PREVIEW; ++i) preview[i] = PeekPiece(state, i).type;
+    score = state.score;
+    lines = state.lines_cleared;
+    level = state.level;
+    spin = state.last_spin;
+    mode = state.mode;
+    combo = state.combo;
+
+    flags &= static_cast<uint8_t>(~(GAME_OVER | CLEARING | FLASH_ON | BACK_TO_BACK));
+    if (state.is_game_over) flags |= GAME_OVER;
+    if (state.back_to_back) flags |= BACK_TO_BACK;
+    if (state.is_clearing_lines) {
+        flags |= CLEARING;
+        if ((state.line_clear_elapsed_ms / 100) % 2) flags |= FLASH_ON; // The game's 100ms flash.
+    }
+    lines_to_clear = state.is_clearing_lines ? state.lines_to_clear : 0;
+}
+
+void BroadcastView::ToState(GameState& state) const {
+    state.board.Reset();
+    for (int y = FIRST_ROW; y <= LAST_ROW; ++y) {
+        for (int x = 0; x < PLAY_WIDTH; ++x) {
+            if (cells[y][x] == 0) continue;
+            state.board.rows[y] |= static_cast<RowMask>(1u << (x + 1));
+            state.board.colors[y][x + 1] = cells[y][x];
+        }
+    }
+    state.board.RebuildColumnTops();
+    state.current_piece = piece;
+    state.current_pos = pos;
+    state.held_type = held_type;
+    state.can_hold = can_hold;
+    state.is_game_over = (flags & GAME_OVER) != 0;
+    state.is_clearing_lines = (flags & CLEARING) != 0;
+    state.lines_to_clear = lines_to_clear;
+    state.score = score;
+    state.lines_cleared = lines;
+    state.level = level;
+    state.last_spin = spin;
+    state.mode = mode;
+    state.combo = combo;
+    state.back_to_back = (flags & BACK_TO_BACK) != 0;
+}
+
+// --- BroadcastPublisher ---
+
+bool BroadcastPublisher::Open(const std::string& name) {
+    Close();
+    if (!memory.Create(name, sizeof(BroadcastRing))) return false;
+
+    ring = new (memory.Data()) BroadcastRing();
+    ring->magic = BROADCAST_MAGIC;
+    ring->version = BROADCAST_VERSION;
+    ring->slot_count = SLOT_COUNT;
+    ring->record_words = RECORD_WORDS;
+
+    sent.Reset();
+    next_record = 0;
+    keyframes = 0;
+    WriteKeyframe(); // An empty picture, until the game publishes its first.
+    ring->is_live.store(1, std::memory_order_release);
+    return true;
+}
+
+void BroadcastPublisher::Close() {
+    if (!ring) return;
+    ring->is_live.store(0, std::memory_order_release);
+    memory.Close();
+    ring = nullptr;
+}
+
+void BroadcastPublisher::Publish(const BroadcastView& view) {
+    if (!ring) return;
+    uint8_t record[MAX_RECORD_SIZE];
+    size_t size = EncodeRecord(&sent, view, record);
+    if (size == 0) return;
+
+    WriteSlot(ring->slots[next_record % SLOT_COUNT], next_record, 0, record, size);
+    next_record++;
+    ring->published.store(next_record, std::memory_order_release);
+    sent = view;
+
+    if (next_record % KEYFRAME_INTERVAL == 0) WriteKeyframe();
+}
+
+void BroadcastPublisher::WriteKeyframe() {
+    uint8_t record[MAX_RECORD_SIZE];
+    size_t size = EncodeRecord(nullptr, sent, record);
+    WriteSlot(ring->keyframe, keyframes++, next_record, record, size);
+}
+
+// --- BroadcastViewer ---
+
+bool BroadcastViewer::Open(const std::string& name) {
+    Close();
+    if (!memory.OpenReadOnly(name, sizeof(BroadcastRing))) return false;
+
+    ring = static_cast<const BroadcastRing*>(memory.Data());
+    // A game still setting up (or built with other sizes) isn't ready for us.
+    if (!ring->is_live.load(std::memory_order_acquire) || ring->magic != BROADCAST_MAGIC ||
+        ring->version != BROADCAST_VERSION || ring->slot_count != BroadcastPublisher::SLOT_COUNT ||
+        ring->record_words != static_cast<uint32_t>(RECORD_WORDS)) {
+        Close();
+        return false;
+    }
+    needs_keyframe = true;
+    next_record = 0;
+    return true;
+}
+
+void BroadcastViewer::Close() {
+    memory.Close();
+    ring = nullptr;
+}
+
+bool BroadcastViewer::IsLive() const {
+    return ring && ring->is_live.load(std::memory_order_acquire) != 0;
+}
+
+bool BroadcastViewer::ReadKeyframe(BroadcastView& view) {
+    uint8_t record[MAX_RECORD_SIZE];
+    uint64_t stamp, sequence;
+    size_t size;
+    if (!ReadSlot(ring->keyframe, stamp, sequence, record, size) || stamp == 0) return false;
+
+    view.Reset();
+    if (!ApplyRecord(record, size, view)) return false;
+    next_record = sequence;
+    needs_keyframe = false;
+    return true;
+}
+
+int BroadcastViewer::Poll(BroadcastView& view) {
+    if (!ring) return 0;
+    int applied = 0;
+
+    // At most one resync per call; a viewer that keeps getting lapped tries
+    // again next time rather than spinning here.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (needs_keyframe) {
+            if (!ReadKeyframe(view)) return applied; // Being rewritten right now.
+            applied++;
+        }
+
+        uint64_t published = ring->published.load(std::memory_order_acquire);
+        bool lapped = published - next_record > static_cast<uint64_t>(BroadcastPublisher::SLOT_COUNT);
+        while (!lapped && next_record < published) {
+            uint8_t record[MAX_RECORD_SIZE];
+            uint64_t stamp, sequence;
+            size_t size;
+            const BroadcastSlot& slot = ring->slots[next_record % BroadcastPublisher::SLOT_COUNT];
+            // Anything but record next_record, finished, means the writer has
+            // already come round again and is reusing the slot.
+            if (!ReadSlot(slot, stamp, sequence, record, size) || stamp != 2 * next_record + 2 ||
+                !ApplyRecord(record, size, view)) {
+                lapped = true;
+                break;
+            }
+            next_record++;
+            applied++;
+        }
+        if (!lapped) return applied;
+
+        needs_keyframe = true;
+        resyncs++;
+    }
+    return applied;
+}
@@ -0,0 +1,151 @@
+#ifndef TETRIS_BROADCAST_H
+#define TETRIS_BROADCAST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Engine.h"
+#include "SharedMemory.h"
+
+// Spectating: a running game publishes what it draws into a block of shared
+// memory, and any number of read-only viewer processes (tetris_viewer) draw
+// it on their own screens.
+//
+// The block holds a ring of records with one writer and lock-free readers.
+// Each time the picture changes the game writes one record: the board rows
+// that changed (ten 4-bit cells each), the falling piece, the hold slot, the
+// preview and the HUD numbers, whichever of those changed. Every slot has
+// its own sequence lock, so the writer never waits for a reader and readers
+// never write anything the writer would see. Publishing costs the same with
+// no viewers or with a hundred.
+//
+// Every KEYFRAME_INTERVAL records the game also stores a keyframe (the whole
+// picture, behind a sequence lock of its own) and the number of the record
+// that comes after it. A viewer that joins late, or falls a whole ring
+// behind, starts again from the keyframe and catches up through the ring.
+
+// The shared block's layout (Broadcast.cpp).
+struct BroadcastRing;
+
+// Everything a spectator sees of one game.
+struct BroadcastView {
+    static const int PLAY_WIDTH = LOGICAL_BOARD_WIDTH - 2;
+    static const int MAX_PREVIEW = 6;
+
+    // Bits of 'flags'.
+    static const uint8_t PAUSED = 1;
+    static const uint8_t GAME_OVER = 2;
+    static const uint8_t CLEARING = 4;     // The lines in lines_to_clear are flashing...
+    static const uint8_t FLASH_ON = 8;     // ...and this is the second half of the flash.
+    static const uint8_t AUTOPLAY = 16;
+    static const uint8_t REPLAY = 32;
+    static const uint8_t BACK_TO_BACK = 64; // The last clear was a tetris or T-spin after another.
+    static const uint8_t CLOCK_RUNNING = 128;
+
+    // The newest splits a record carries: as many as the HUD shows.
+    static constexpr int MAX_SPLITS = 6;
+
+    uint8_t cells[GAME_BOARD_HEIGHT][PLAY_WIDTH]; // Color of every play cell (0 = empty).
+    Piece piece;
+    Position pos;
+    int8_t held_type;                  // -1 = the hold slot is empty.
+    bool can_hold;
+    uint8_t preview[MAX_PREVIEW];
+    uint8_t preview_count;             // 0 while the player has the preview hidden.
+    int score, lines, level, high_score;  // high_score is 0 in Sprint, which ranks by time.
+    SpinType spin;
+    uint8_t flags;
+    RowSet lines_to_clear;
+
+    // The run, as DrawStats and DrawRunStats show it.
+    GameMode mode;
+    int combo;                         // -1 = no combo running.
+    uint32_t time_ms;                  // The run clock (Ultra counts down).
+    uint32_t best_time_ms;             // Sprint only: the best time on the board (0 = none yet).
+    uint16_t pieces_per_second;        // In hundredths.
+    uint16_t keys_per_piece;           // In hundredths.
+    uint8_t split_count;               // Splits so far (every RunStats::SPLIT_LINES lines)...
+    uint32_t splits_ms[MAX_SPLITS];    // ...and the newest of them, oldest first.
+
+    void Reset();
+
+    // Copies the board, pieces, numbers, mode, combo and the GAME_OVER /
+    // CLEARING / FLASH_ON / BACK_TO_BACK flags of 'state'. What only the
+    // front-end knows (the best run, how many previews show, the run clock
+    // and splits, the other flags) is left as it was.
+    void Capture(const GameState& state);
+
+    // Rebuilds a GameState that looks like this view, so the normal
+    // DrawPlayfield can draw it. Only the fields drawing needs are filled in.
+    void ToState(GameState& state) const;
+};
+
+// The game's side. Not thread safe: one publisher per broadcast.
+class BroadcastPublisher {
+public:
+    static const int SLOT_COUNT = 512;
+    static const int KEYFRAME_INTERVAL = 64;
+
+    BroadcastPublisher() = default;
+    ~BroadcastPublisher() { Close(); }
+
+    BroadcastPublisher(const BroadcastPublisher&) = delete;
+    BroadcastPublisher& operator=(const BroadcastPublisher&) = delete;
+
+    // Starts broadcasting under 'name' (viewers open the same name).
+    bool Open(const std::string& name);
+
+    // Tells the viewers the game has gone and removes the name.
+    void Close();
+
+    bool IsOpen() const { return memory.IsOpen(); }
+
+    // Publishes whatever changed since the last call, or nothing if the
+    // picture is the same. Never blocks and never allocates.
+    void Publish(const BroadcastView& view);
+
+    uint64_t RecordsPublished() const { return next_record; }
+
+private:
+    void WriteKeyframe();
+
+    SharedMemory memory;
+    BroadcastRing* ring = nullptr;
+    BroadcastView sent;          // The picture as of the last record.
+    uint64_t next_record = 0;
+    uint64_t keyframes = 0;
+};
+
+// A spectator's side. Only reads the shared block, so a viewer that stalls
+// or crashes can't hold up the game or the other viewers.
+class BroadcastViewer {
+public:
+    // Maps the broadcast called 'name'. The first Poll starts from its keyframe.
+    bool Open(const std::string& name);
+    void Close();
+
+    bool IsOpen() const { return memory.IsOpen(); }
+
+    // False once the game has closed the broadcast (or if it isn't open).
+    bool IsLive() const;
+
+    // Brings 'view' up to date with every record published since the last
+    // call. Returns how many records (or keyframes) were applied, 0 if
+    // nothing new has been published.
+    int Poll(BroadcastView& view);
+
+    // How often this viewer fell a whole ring behind and started again
+    // from a keyframe.
+    uint64_t Resyncs() const { return resyncs; }
+
+private:
+    bool ReadKeyframe(BroadcastView& view);
+
+    SharedMemory memory;
+    const BroadcastRing* ring = nullptr;
+    uint64_t next_record = 0;
+    bool needs_keyframe = true;
+    uint64_t resyncs = 0;
+};
+
+#endif
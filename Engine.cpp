@@ -0,0 +1,563 @@
+#include "Engine.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "GameRules.h"
+#include "Profiler.h"
+
+// Calls function(rules) with the rule object of 'mode'. This switch is the
+// only place the mode is looked at while a game runs: everything 'function'
+// goes on to call is compiled for that one set of rules (see GameRules.h).
+template <class Function>
+static auto WithRules(GameMode mode, Function&& function) {
+    switch (mode) {
+        case GameMode::Marathon: return function(MarathonRules());
+        case GameMode::Sprint:   return function(SprintRules());
+        case GameMode::Ultra:    return function(UltraRules());
+        case GameMode::Classic:  break;
+    }
+    return function(ClassicRules());
+}
+
+static const char* const GAME_MODE_NAMES[GAME_MODE_COUNT] = {"classic", "marathon", "sprint", "ultra"};
+
+const char* GameModeName(GameMode mode) {
+    int index = static_cast<int>(mode);
+    return (index < GAME_MODE_COUNT) ? GAME_MODE_NAMES[index] : "unknown";
+}
+
+bool ParseGameMode(const char* name, GameMode& mode) {
+    for (int i = 0; i < GAME_MODE_COUNT; ++i) {
+        if (std::strcmp(name, GAME_MODE_NAMES[i]) == 0) {
+            mode = static_cast<GameMode>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// The rule-dependent steps below come in two flavors: the ones taking a
+// rule object do the work, and the ones in Engine.h look the rules up with
+// WithRules and call them.
+template <class Board, class Rules>
+static void LockPiece(BasicGameState<Board>& state, StepResult& result, Rules rules);
+template <class Board, class Rules>
+static void ShiftLinesDown(BasicGameState<Board>& state, StepResult& result, Rules rules);
+
+// Takes the next piece out of the randomizer's queue.
+template <class Board>
+static Piece DealPiece(BasicGameState<Board>& state) {
+    return Piece{state.randomizer.Next(), 0};
+}
+
+// Brings 'piece' out at the spawn point as the new falling piece, with
+// nothing carried over from the last one.
+template <class Board>
+static void SpawnPiece(BasicGameState<Board>& state, Piece piece) {
+    state.current_piece = piece;
+    state.current_pos = SpawnPosition(state.board);
+    state.last_move_was_rotation = false;
+    state.last_kick_was_long = false;
+    state.is_grounded = false;
+    state.lock_elapsed_ms = 0;
+    state.lock_resets = 0;
+    state.lowest_row = state.current_pos.y;
+}
+
+template <class Board>
+void ResetGameState(BasicGameState<Board>& state, uint64_t seed) {
+    // Empty the play area and set the wall bits (and the '9's in the color plane).
+    state.board.Reset();
+
+    // Reset all our flags and progress markers.
+    state.is_game_over = false;
+    state.is_goal_reached = false;
+    state.lines_to_clear = 0;
+    state.is_clearing_lines = false;
+    state.line_clear_elapsed_ms = 0;
+    state.score = 0;
+    state.level = 1;
+    state.lines_cleared = 0;
+    state.combo = -1;
+    state.back_to_back = false;
+    state.gravity_elapsed_ms = 0;
+    state.frame = 0;
+    state.last_spin = SpinType::None;
+    state.held_type = -1;
+    state.can_hold = true;
+
+    // Re-seed the randomizer and take the first piece; the rest wait in its queue.
+    // It starts at the top middle.
+    state.randomizer.Reset(seed);
+    SpawnPiece(state, DealPiece(state));
+}
+
+// This calculates how fast the piece should fall.
+// As your level goes up, the time between drops gets smaller (faster).
+int GetFallSpeedMS(int level) {
+    int speed = 500 * std::pow(0.8, level - 1);
+
+    // We set a "speed limit" (50ms) so the game doesn't become impossible.
+    return (speed < 50) ? 50 : speed;
+}
+
+// This function checks if a piece is allowed to be at a certain spot.
+// Walls are just pre-set bits in the board rows, so hitting a wall and hitting
+// another block are the same AND test.
+template <class Board>
+bool CheckCollision(const BasicGameState<Board>& state, const PieceMask& mask, int nextX, int nextY) {
+    TETRIS_PROFILE_COUNT(ProfileCounter::CollisionChecks, 1);
+    return state.board.Collides(mask, nextX, nextY);
+}
+
+// Called after the piece moved or turned. With a lock delay, this is where
+// the piece finds out whether it is resting on something, and where moving
+// it on the ground buys it more time.
+template <class Board>
+static void UpdateLockDelay(BasicGameState<Board>& state) {
+    if (state.lock_delay_ms <= 0) return;
+
+    // A new lowest row starts the count over.
+    if (state.current_pos.y > state.lowest_row) {
+        state.lowest_row = state.current_pos.y;
+        state.lock_resets = 0;
+        state.lock_elapsed_ms = 0;
+    }
+
+    bool was_grounded = state.is_grounded;
+    state.is_grounded = CheckCollision(state, state.current_piece.Mask(), state.current_pos.x, state.current_pos.y + 1);
+    if (was_grounded && state.lock_resets < MAX_LOCK_RESETS) {
+        state.lock_elapsed_ms = 0;
+        state.lock_resets++;
+    }
+}
+
+// Moves the piece left, right, or down if the path is clear.
+template <class Board, class Rules>
+static void MovePiece(BasicGameState<Board>& state, int deltaX, int deltaY, StepResult& result, Rules rules) {
+    if (!CheckCollision(state, state.current_piece.Mask(), state.current_pos.x + deltaX, state.current_pos.y + deltaY)) {
+        state.current_pos.x += deltaX;
+        state.current_pos.y += deltaY;
+        state.last_move_was_rotation = false;
+        UpdateLockDelay(state);
+    } else if (deltaY > 0) {
+        // If we were trying to move DOWN but hit something, the piece has landed.
+        // With a lock delay it rests there first and AdvanceGame locks it later.
+        if (state.lock_delay_ms > 0) {
+            state.is_grounded = true;
+        } else {
+            LockPiece(state, result, rules);
+        }
+    }
+}
+
+template <class Board>
+void MovePiece(BasicGameState<Board>& state, int deltaX, int deltaY, StepResult& result) {
+    WithRules(state.mode, [&](auto rules) { MovePiece(state, deltaX, deltaY, result, rules); });
+}
+
+// Hard Drop: Teleport the piece to the bottom instantly and stick it there.
+// The landing row comes from the column tops instead of a collision test per row.
+template <class Board, class Rules>
+static void HardDrop(BasicGameState<Board>& state, StepResult& result, Rules rules) {
+    Position landing = LandingPosition(state.board, state.current_piece, state.current_pos);
+    if (landing.y != state.current_pos.y) {
+        state.current_pos = landing;
+        state.last_move_was_rotation = false; // It fell into place, it wasn't turned in.
+    }
+    LockPiece(state, result, rules);
+}
+
+template <class Board>
+void HardDrop(BasicGameState<Board>& state, StepResult& result) {
+    WithRules(state.mode, [&](auto rules) { HardDrop(state, result, rules); });
+}
+
+// This function attempts to rotate the piece. If the rotation hits a wall,
+// it tries "kicking" (nudging) the piece to the left or right to make it fit.
+template <class Board>
+bool RotateWithWallKicks(const Board& board, Piece& piece, Position& pos, int turns) {
+    // The rotated shape comes straight out of the precomputed table.
+    Piece rotated = piece.Rotated(turns);
+    const PieceMask& rotatedMask = rotated.Mask();
+    bool isIPiece = (piece.type == PIECE_I);
+
+    // We try the original spot, then 1 block left, 1 block right,
+    // 2 blocks left, and 2 blocks right. This covers both the left and right walls.
+    static constexpr int standard_offsets[5][2] = {
+        {0, 0},  // Try original spot
+        {-1, 0}, // Nudge left (if hitting right wall)
+        {1, 0},  // Nudge right (if hitting left wall)
+        {-2, 0}, // Big nudge left
+        {2, 0}   // Big nudge right
+    };
+
+    // The 'I' piece is very long, so it needs bigger kicks to clear walls.
+    static constexpr int i_offsets[5][2] = {
+        {0, 0},
+        {-2, 0},
+        {2, 0},
+        {-1, 0},
+        {1, 0}
+    };
+
+    const int (*offsets)[2] = isIPiece ? i_offsets : standard_offsets;
+
+    // Loop through our "nudge" options to see if any spot is empty.
+    for (int i = 0; i < 5; ++i) {
+        int testX = pos.x + offsets[i][0];
+        int testY = pos.y + offsets[i][1];
+
+        if (!board.Collides(rotatedMask, testX, testY)) {
+            // Success! We found a spot that works.
+            piece = rotated;
+            pos.x = testX;
+            pos.y = testY;
+            return true;
+        }
+    }
+    return false; // If all 5 spots are blocked, the piece won't rotate.
+}
+
+// SRS: the same idea, but each turn has its own list of tests (including
+// upward and downward kicks), looked up by piece, rotation and direction.
+template <class Board>
+int RotateWithSrsKicks(const Board& board, Piece& piece, Position& pos, int turns) {
+    const KickList& kicks = SRS_KICK_TABLE.kicks[piece.type][piece.rotation][turns - 1];
+    Piece rotated = piece.Rotated(turns);
+    const PieceMask& rotatedMask = rotated.Mask();
+
+    for (int i = 0; i < kicks.count; ++i) {
+        int testX = pos.x + kicks.offsets[i][0];
+        int testY = pos.y + kicks.offsets[i][1];
+        if (!board.Collides(rotatedMask, testX, testY)) {
+            piece = rotated;
+            pos.x = testX;
+            pos.y = testY;
+            return i;
+        }
+    }
+    return -1;
+}
+
+template <class Board>
+bool TryRotationWithWallKicks(BasicGameState<Board>& state, int turns) {
+    TETRIS_PROFILE_COUNT(ProfileCounter::RotationsAttempted, 1);
+    if (state.rotation_system == RotationSystem::Classic) {
+        bool rotated = RotateWithWallKicks(state.board, state.current_piece, state.current_pos, turns);
+        if (rotated) {
+            state.last_move_was_rotation = true;
+            UpdateLockDelay(state);
+        }
+        return rotated;
+    }
+
+    const KickList& kicks = SRS_KICK_TABLE.kicks[state.current_piece.type][state.current_piece.rotation][turns - 1];
+    int kick = RotateWithSrsKicks(state.board, state.current_piece, state.current_pos, turns);
+    if (kick < 0) return false;
+    state.last_move_was_rotation = true;
+    state.last_kick_was_long = (kicks.long_kicks >> kick) & 1u;
+    UpdateLockDelay(state);
+    return true;
+}
+
+// The 3-corner rule: look at the four cells diagonal to the T's center.
+// Walls and the floor count as filled.
+template <class Board>
+SpinType DetectSpin(const BasicGameState<Board>& state) {
+    const Piece& piece = state.current_piece;
+    if (state.rotation_system != RotationSystem::SRS || piece.type != PIECE_T) return SpinType::None;
+    if (!state.last_move_was_rotation) return SpinType::None;
+
+    HalfCell center = SrsCenterX2(piece);
+    int cx = state.current_pos.x + center.x / 2;
+    int cy = state.current_pos.y + center.y / 2;
+    auto filled = [&](int x, int y) {
+        if (x < 0 || y < 0 || y >= state.board.Height()) return true;
+        return ((state.board.rows[y] >> x) & 1u) != 0;
+    };
+
+    // Corners in clockwise order from the top left, so the two the T points
+    // at in SRS state s are corners s and s + 1.
+    const int corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    bool is_filled[4];
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        is_filled[i] = filled(cx + corners[i][0], cy + corners[i][1]);
+        count += is_filled[i] ? 1 : 0;
+    }
+    if (count < 3) return SpinType::None;
+
+    int facing = SrsState(piece);
+    bool front_filled = is_filled[facing] && is_filled[(facing + 1) & 3];
+    return (front_filled || state.last_kick_was_long) ? SpinType::Full : SpinType::Mini;
+}
+
+// When a piece lands, it is "glued" to the board and the next one spawns.
+template <class Board, class Rules>
+static void LockPiece(BasicGameState<Board>& state, StepResult& result, Rules rules) {
+    state.last_spin = DetectSpin(state);
+
+    RowSet touched = state.board.Place(state.current_piece.Mask(), state.current_pos.x,
+                                         state.current_pos.y, static_cast<uint8_t>(state.current_piece.Id()));
+    result.pieces_locked++;
+
+    // The mode scores the lock (spins, combos, back-to-back) before the rows go.
+    int lines = 0;
+    for (RowSet full = state.board.FullRows(touched); full != 0; full &= full - 1) lines++;
+    Rules::ScoreLock(state, lines);
+
+    // Prepare the next piece before clearing, so an instant clear sees the new spawn.
+    SpawnPiece(state, DealPiece(state));
+    state.can_hold = true;
+
+    ClearLines(state, touched);
+    if (state.is_clearing_lines && state.line_clear_delay_ms <= 0) {
+        ShiftLinesDown(state, result, rules);
+    }
+
+    // Check if the new piece immediately hits something (Board is full).
+    if (CheckCollision(state, state.current_piece.Mask(), state.current_pos.x, state.current_pos.y)) {
+        state.is_game_over = true;
+    }
+}
+
+template <class Board>
+void LockPiece(BasicGameState<Board>& state, StepResult& result) {
+    WithRules(state.mode, [&](auto rules) { LockPiece(state, result, rules); });
+}
+
+template <class Board>
+bool HoldPiece(BasicGameState<Board>& state) {
+    if (!state.can_hold) return false;
+
+    // Pieces are just (type, rotation) pairs, so a swap moves one byte each way.
+    uint8_t current_type = state.current_piece.type;
+    Piece next = (state.held_type < 0) ? DealPiece(state) : Piece{static_cast<uint8_t>(state.held_type), 0};
+    state.held_type = current_type;
+    SpawnPiece(state, next);
+    state.can_hold = false;
+
+    if (CheckCollision(state, state.current_piece.Mask(), state.current_pos.x, state.current_pos.y)) {
+        state.is_game_over = true;
+    }
+    return true;
+}
+
+// Checks the rows the piece landed on to see if any are completely full.
+template <class Board>
+void ClearLines(BasicGameState<Board>& state, RowSet touched_rows) {
+    // A row is full when every play cell is set, so the whole mask is all ones.
+    state.lines_to_clear |= state.board.FullRows(touched_rows);
+
+    // Start the animation timer if we have lines to clear.
+    if (state.lines_to_clear != 0) {
+        state.is_clearing_lines = true;
+        state.line_clear_elapsed_ms = 0;
+    }
+}
+
+// Deletes the full lines and shifts all the blocks above them downward.
+template <class Board, class Rules>
+static void ShiftLinesDown(BasicGameState<Board>& state, StepResult& result, Rules) {
+    int count = 0;
+    for (RowSet bits = state.lines_to_clear; bits != 0; bits &= bits - 1) count++;
+
+    state.lines_cleared += count;
+    Rules::ScoreClear(state, count);
+    state.level = Rules::LevelFor(state.lines_cleared);
+    result.lines_cleared += count;
+
+    // The board compacts its rows in one pass.
+    state.board.RemoveRows(state.lines_to_clear);
+
+    state.lines_to_clear = 0;
+    state.is_clearing_lines = false;
+
+    // A mode with a line goal is over the moment it is reached.
+    if (Rules::LINE_GOAL > 0 && state.lines_cleared >= Rules::LINE_GOAL) {
+        state.is_goal_reached = true;
+        state.is_game_over = true;
+    }
+}
+
+template <class Board>
+void ShiftLinesDown(BasicGameState<Board>& state, StepResult& result) {
+    WithRules(state.mode, [&](auto rules) { ShiftLinesDown(state, result, rules); });
+}
+
+template <class Board>
+void AddGarbage(BasicGameState<Board>& state, int rows, int hole_column) {
+    if (state.is_game_over || rows <= 0) return;
+
+    int play_width = state.board.Width() - 2;
+    int hole_x = 1 + ((hole_column % play_width) + play_width) % play_width;
+    if (state.board.InsertGarbage(rows, hole_x)) {
+        state.is_game_over = true;
+        return;
+    }
+
+    // Rows waiting to be cleared moved up along with everything else.
+    state.lines_to_clear = (state.lines_to_clear >> rows) & ~RowSet(1);
+
+    // The stack rose under the falling piece: lift it by as much as it takes.
+    const PieceMask& mask = state.current_piece.Mask();
+    for (int lift = 0; lift <= rows; ++lift) {
+        if (!CheckCollision(state, mask, state.current_pos.x, state.current_pos.y - lift)) {
+            state.current_pos.y -= lift;
+            return;
+        }
+    }
+    state.is_game_over = true;
+}
+
+template <class Board, class Rules>
+static StepResult AdvanceGame(BasicGameState<Board>& state, int elapsed_ms, Rules rules);
+
+template <class Board, class Rules>
+static StepResult StepGame(BasicGameState<Board>& state, Action action, int elapsed_ms, Rules rules) {
+    StepResult result;
+    if (!state.is_game_over) {
+        switch (action) {
+            case Action::MoveLeft:  MovePiece(state, -1, 0, result, rules); break;
+            case Action::MoveRight: MovePiece(state, 1, 0, result, rules); break;
+            case Action::SoftDrop:  MovePiece(state, 0, 1, result, rules); break;
+            case Action::HardDrop:  HardDrop(state, result, rules); break;
+            case Action::Rotate:    TryRotationWithWallKicks(state, 1); break;
+            case Action::RotateCCW: TryRotationWithWallKicks(state, 3); break;
+            case Action::Rotate180: TryRotationWithWallKicks(state, 2); break;
+            case Action::Hold:      HoldPiece(state); break;
+            case Action::None:      break;
+        }
+    }
+
+    StepResult timed = AdvanceGame(state, elapsed_ms, rules);
+    result.pieces_locked += timed.pieces_locked;
+    result.lines_cleared += timed.lines_cleared;
+    return result;
+}
+
+template <class Board>
+StepResult StepGame(BasicGameState<Board>& state, Action action, int elapsed_ms) {
+    return WithRules(state.mode, [&](auto rules) { return StepGame(state, action, elapsed_ms, rules); });
+}
+
+// Game time left in a timed mode (only called when Rules has a limit).
+template <class Board, class Rules>
+static uint64_t MsUntilTimeLimit(const BasicGameState<Board>& state, Rules) {
+    const uint64_t limit = static_cast<uint64_t>(Rules::TIME_LIMIT_MS);
+    return (state.frame < limit) ? limit - state.frame : 0;
+}
+
+template <class Board, class Rules>
+static StepResult AdvanceGame(BasicGameState<Board>& state, int elapsed_ms, Rules rules) {
+    StepResult result;
+
+    // A timed mode runs up to its limit and not a millisecond past it.
+    bool reaches_time_limit = false;
+    if (Rules::TIME_LIMIT_MS > 0 && !state.is_game_over) {
+        uint64_t left = MsUntilTimeLimit(state, rules);
+        if (static_cast<uint64_t>(elapsed_ms) >= left) {
+            elapsed_ms = static_cast<int>(left);
+            reaches_time_limit = true;
+        }
+    }
+
+    while (elapsed_ms > 0 && !state.is_game_over) {
+        if (state.is_clearing_lines) {
+            // Wait for the animation delay to finish before dropping blocks.
+            int remaining = state.line_clear_delay_ms - state.line_clear_elapsed_ms;
+            if (elapsed_ms < remaining) {
+                state.line_clear_elapsed_ms += elapsed_ms;
+                state.frame += elapsed_ms;
+                break;
+            }
+            elapsed_ms -= remaining;
+            state.frame += remaining;
+            ShiftLinesDown(state, result, rules);
+        } else if (state.is_grounded) {
+            // Resting on the stack: the lock timer runs instead of gravity.
+            int remaining = state.lock_delay_ms - state.lock_elapsed_ms;
+            if (elapsed_ms < remaining) {
+                state.lock_elapsed_ms += elapsed_ms;
+                state.frame += elapsed_ms;
+                break;
+            }
+            elapsed_ms -= remaining;
+            state.frame += remaining;
+            state.is_grounded = false;
+            state.lock_elapsed_ms = 0;
+
+            // Garbage may have moved things around since it touched down.
+            if (CheckCollision(state, state.current_piece.Mask(), state.current_pos.x, state.current_pos.y + 1)) {
+                LockPiece(state, result, rules);
+            }
+        } else {
+            // Check if enough time has passed for gravity to pull the piece down.
+            int remaining = GetFallSpeedMS(state.level) - state.gravity_elapsed_ms;
+            if (elapsed_ms < remaining) {
+                state.gravity_elapsed_ms += elapsed_ms;
+                state.frame += elapsed_ms;
+                break;
+            }
+            elapsed_ms -= remaining;
+            state.frame += remaining;
+            state.gravity_elapsed_ms = 0;
+            MovePiece(state, 0, 1, result, rules);
+        }
+    }
+
+    if (reaches_time_limit && !state.is_game_over) {
+        state.is_goal_reached = true;
+        state.is_game_over = true;
+    }
+    return result;
+}
+
+template <class Board>
+StepResult AdvanceGame(BasicGameState<Board>& state, int elapsed_ms) {
+    return WithRules(state.mode, [&](auto rules) { return AdvanceGame(state, elapsed_ms, rules); });
+}
+
+template <class Board>
+int MsUntilNextEvent(const BasicGameState<Board>& state) {
+    if (state.is_game_over) return -1;
+    int wait;
+    if (state.is_clearing_lines) {
+        wait = state.line_clear_delay_ms - state.line_clear_elapsed_ms;
+    } else if (state.is_grounded) {
+        wait = state.lock_delay_ms - state.lock_elapsed_ms;
+    } else {
+        wait = GetFallSpeedMS(state.level) - state.gravity_elapsed_ms;
+    }
+    return WithRules(state.mode, [&](auto rules) {
+        using Rules = decltype(rules);
+        if (Rules::TIME_LIMIT_MS <= 0) return wait;
+        return static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(wait), MsUntilTimeLimit(state, rules)));
+    });
+}
+
+// The engine is compiled once per board below; every other file only sees the
+// declarations in Engine.h. A new board size needs a line here.
+#define TETRIS_INSTANTIATE_ENGINE(Board)                                                      \
+    template void ResetGameState(BasicGameState<Board>&, uint64_t);                          \
+    template bool CheckCollision(const BasicGameState<Board>&, const PieceMask&, int, int);  \
+    template void MovePiece(BasicGameState<Board>&, int, int, StepResult&);                  \
+    template void HardDrop(BasicGameState<Board>&, StepResult&);                             \
+    template bool TryRotationWithWallKicks(BasicGameState<Board>&, int);                     \
+    template bool RotateWithWallKicks(const Board&, Piece&, Position&, int);                 \
+    template int RotateWithSrsKicks(const Board&, Piece&, Position&, int);                   \
+    template SpinType DetectSpin(const BasicGameState<Board>&);                              \
+    template void LockPiece(BasicGameState<Board>&, StepResult&);                            \
+    template bool HoldPiece(BasicGameState<Board>&);                                         \
+    template void ClearLines(BasicGameState<Board>&, RowSet);                                \
+    template void ShiftLinesDown(BasicGameState<Board>&, StepResult&);                       \
+    template void AddGarbage(BasicGameState<Board>&, int, int);                              \
+    template StepResult StepGame(BasicGameState<Board>&, Action, int);                       \
+    template StepResult AdvanceGame(BasicGameState<Board>&, int);                            \
+    template int MsUntilNextEvent(const BasicGameState<Board>&);
+
+TETRIS_INSTANTIATE_ENGINE(Bitboard)
+TETRIS_INSTANTIATE_ENGINE(TallBitboard)
+TETRIS_INSTANTIATE_ENGINE(WideBitboard)
+TETRIS_INSTANTIATE_ENGINE(DynamicBitboard)
@@ -0,0 +1,247 @@
+#ifndef TETRIS_ENGINE_H
+#define TETRIS_ENGINE_H
+
+#include <cstdint>
+#include "Bitboard.h"
+#include "Randomizer.h"
+#include "Tetromino.h"
+
+// The rules of the game with no console, clock or keyboard attached.
+// Everything lives in a plain GameState struct, and the only way to change it
+// is through the functions below. A front-end turns keys into Actions and
+// real time into elapsed milliseconds; a simulation can do the same as fast
+// as the CPU allows.
+
+// A simple structure to keep track of where a piece is on the grid.
+struct Position {
+    int x;
+    int y;
+};
+
+// Every new piece starts here: the top middle of the board, or just above
+// the visible rows on a board with a buffer zone.
+template <class Board>
+inline Position SpawnPosition(const Board& board) {
+    int buffer_rows = board.BufferRows();
+    return Position{board.Width() / 2 - 2, (buffer_rows >= 2) ? buffer_rows - 2 : 0};
+}
+
+// Everything a player (or a bot) can ask the game to do.
+// The numbers are stored in replay files, so new actions go at the end.
+enum class Action : uint8_t {
+    None,
+    MoveLeft,
+    MoveRight,
+    SoftDrop,
+    HardDrop,
+    Rotate,     // A quarter turn clockwise.
+    RotateCCW,  // A quarter turn counter-clockwise.
+    Rotate180,
+    Hold        // Swap the falling piece with the one in the hold slot.
+};
+
+// How pieces turn, and where they may be kicked to when a turn is blocked.
+// The classic rules only turn clockwise and nudge sideways; SRS is the
+// Super Rotation System from the modern guideline, with floor kicks and T-spins.
+enum class RotationSystem : uint8_t {
+    Classic,
+    SRS
+};
+
+// What the last locked T counted as (SRS only). A T that was turned into
+// place with three of the four corners around its center filled is a
+// T-spin; if one of the two corners it points at is open it is only a
+// "mini", unless the turn needed the long one-column, two-row kick.
+enum class SpinType : uint8_t {
+    None,
+    Mini,
+    Full
+};
+
+// Which rules score the game, level it up and end it (GameRules.h). Stored
+// in replays and save states, so new modes go at the end.
+enum class GameMode : uint8_t {
+    Classic,   // The original: 100 x lines x level, a level every 10 lines, endless.
+    Marathon,  // Guideline scoring with combos and back-to-back, done at 150 lines.
+    Sprint,    // Clear 40 lines as fast as possible.
+    Ultra      // As many points as possible in 2 minutes.
+};
+const int GAME_MODE_COUNT = 4;
+
+// "classic", "marathon", "sprint" or "ultra", and back.
+const char* GameModeName(GameMode mode);
+bool ParseGameMode(const char* name, GameMode& mode);
+
+// How many times moving or turning a piece that rests on the stack may
+// restart its lock delay. Reaching a new lowest row gives them all back.
+const int MAX_LOCK_RESETS = 15;
+
+// What happened during a call to StepGame / AdvanceGame.
+struct StepResult {
+    int pieces_locked = 0;
+    int lines_cleared = 0;
+};
+
+// The complete state of one game on a 'Board' (see Bitboard.h).
+template <class Board>
+struct BasicGameState {
+    // --- Game World Data ---
+    Board board;                 // Row bitmasks for the rules + a color plane for drawing.
+    Piece current_piece;         // The piece the player is controlling.
+    Position current_pos;        // The current (x, y) location of that piece.
+    bool is_game_over = false;   // Set to true when the stack reaches the top...
+    bool is_goal_reached = false; // ...or when the mode's goal is met (it is game over then too).
+
+    // --- Line Clearing & Animation ---
+    RowSet lines_to_clear = 0;        // Bit y is set while row y is waiting to be removed.
+    bool is_clearing_lines = false;   // True while the "flash" delay is running.
+    int line_clear_elapsed_ms = 0;    // How long the current flash has been running.
+    int line_clear_delay_ms = 300;    // How long the clear animation lasts (0 = instant).
+
+    // --- Scoring & Leveling ---
+    GameMode mode = GameMode::Classic; // Kept by ResetGameState, like the other settings.
+    int score = 0;
+    int level = 1;
+    int lines_cleared = 0;
+    int combo = -1;              // Clearing locks in a row, minus one (-1 = the last lock cleared nothing).
+    bool back_to_back = false;   // The last clear was a tetris or a T-spin (guideline modes).
+
+    // --- Rotation & Spins ---
+    RotationSystem rotation_system = RotationSystem::Classic; // Kept by ResetGameState, like the delay.
+    bool last_move_was_rotation = false; // Any move or drop after a turn clears it.
+    bool last_kick_was_long = false;     // That turn used the long kick (see SpinType).
+    SpinType last_spin = SpinType::None; // What the most recent lock counted as.
+
+    // --- Hold ---
+    int held_type = -1;          // The piece type in the hold slot (-1 = empty).
+    bool can_hold = true;        // One hold per piece: cleared by a hold, set again on lock.
+
+    // --- Lock Delay ---
+    // With lock_delay_ms > 0 a piece that touches down rests for that long
+    // before it locks, and moving or turning it on the ground restarts the
+    // wait (up to MAX_LOCK_RESETS times). 0 locks at once, the classic rules.
+    int lock_delay_ms = 0;       // Kept by ResetGameState, like the other settings.
+    bool is_grounded = false;    // Resting on something, with the lock timer running.
+    int lock_elapsed_ms = 0;     // How long it has been resting.
+    int lock_resets = 0;         // Restarts used up on this piece.
+    int lowest_row = 0;          // The lowest row this piece has reached.
+
+    // --- Timing ---
+    int gravity_elapsed_ms = 0;  // Time since the piece last moved down due to gravity.
+    uint64_t frame = 0;          // Game time since the start, in ms. Replays key off this.
+
+    // --- Randomness ---
+    // Deals the pieces and holds the queue of upcoming ones (the "Preview").
+    // Same seed = same pieces.
+    Randomizer randomizer;
+};
+
+// The engine is built for these boards (Engine.cpp). GameState, on the
+// classic 10x20 board, is what the console game, replays and bots use.
+using GameState = BasicGameState<Bitboard>;
+using TallGameState = BasicGameState<TallBitboard>;
+using WideGameState = BasicGameState<WideBitboard>;
+using DynamicGameState = BasicGameState<DynamicBitboard>; // Set state.board before ResetGameState.
+
+// Starts a brand new game: empty board, fresh pieces, zero score.
+// The same seed always produces the same sequence of pieces. The randomizer
+// keeps whatever mode (pure random / 7-bag) it was last given.
+template <class Board>
+void ResetGameState(BasicGameState<Board>& state, uint64_t seed);
+
+// An upcoming piece: 0 is the "Next Piece", 1 the one after, and so on
+// (up to Randomizer::QUEUE_SIZE - 1).
+template <class Board>
+inline Piece PeekPiece(const BasicGameState<Board>& state, int index) {
+    return Piece{state.randomizer.Peek(index), 0};
+}
+
+// Where 'piece' at 'pos' ends up if it is hard dropped: the spot the ghost
+// piece is drawn at. Comes straight from the board's column tops unless the
+// piece is tucked under an overhang, so bots can ask it for every rotation
+// and column without stepping down the rows.
+template <class Board>
+inline Position LandingPosition(const Board& board, Piece piece, Position pos) {
+    return Position{pos.x, board.LandingRow(piece.Mask(), piece.Profile(), pos.x, pos.y)};
+}
+
+// How many milliseconds a piece waits before gravity pulls it down a row.
+int GetFallSpeedMS(int level);
+
+// --- Rules (Engine.cpp) ---
+template <class Board>
+bool CheckCollision(const BasicGameState<Board>& state, const PieceMask& mask, int nextX, int nextY);
+template <class Board>
+void MovePiece(BasicGameState<Board>& state, int deltaX, int deltaY, StepResult& result);
+template <class Board>
+void HardDrop(BasicGameState<Board>& state, StepResult& result);
+
+// Turns the current piece 'turns' (1 to 3) quarters clockwise (2 = 180, 3 = one
+// quarter counter-clockwise) with the state's rotation system.
+template <class Board>
+bool TryRotationWithWallKicks(BasicGameState<Board>& state, int turns = 1);
+
+// The classic wall-kick rules on their own: turns 'piece' at 'pos' on
+// 'board', nudging it sideways if needed. Updates both and returns true on
+// success; leaves them alone if every spot is blocked.
+template <class Board>
+bool RotateWithWallKicks(const Board& board, Piece& piece, Position& pos, int turns = 1);
+
+// The same for SRS, driven by SRS_KICK_TABLE (Tetromino.h). Returns which
+// kick test worked, or -1 if none did.
+template <class Board>
+int RotateWithSrsKicks(const Board& board, Piece& piece, Position& pos, int turns);
+
+// Either of the above, picked by 'system'. Returns the kick test that worked
+// (always 0 for the classic rules) or -1. Bots use this to search moves on
+// copies of the board.
+template <class Board>
+inline int RotateWithKicks(const Board& board, RotationSystem system, Piece& piece, Position& pos, int turns) {
+    if (system == RotationSystem::SRS) return RotateWithSrsKicks(board, piece, pos, turns);
+    return RotateWithWallKicks(board, piece, pos, turns) ? 0 : -1;
+}
+
+// Checks whether the T about to lock at the current spot is a T-spin
+// (SRS only; always SpinType::None otherwise).
+template <class Board>
+SpinType DetectSpin(const BasicGameState<Board>& state);
+template <class Board>
+void LockPiece(BasicGameState<Board>& state, StepResult& result);
+
+// Puts the falling piece in the hold slot and brings out the one that was
+// there (or the next piece, the first time). Once per piece; returns false
+// if this piece was already swapped in from the hold.
+template <class Board>
+bool HoldPiece(BasicGameState<Board>& state);
+
+// Marks which of 'touched_rows' (bit y = row y, normally the rows the piece
+// just locked into) are full and starts the clear. Rows the piece didn't
+// touch can't have filled up, so nothing else is looked at.
+template <class Board>
+void ClearLines(BasicGameState<Board>& state, RowSet touched_rows);
+template <class Board>
+void ShiftLinesDown(BasicGameState<Board>& state, StepResult& result);
+
+// Versus mode: pushes 'rows' garbage rows in under the stack, each with its
+// gap in play column 'hole_column' (0 = left-most). The falling piece is
+// nudged up out of the way if it can be; if blocks are pushed out of the
+// top, or the piece can't get clear, the game is over.
+template <class Board>
+void AddGarbage(BasicGameState<Board>& state, int rows, int hole_column);
+
+// Applies one action and then lets 'elapsed_ms' of game time pass, under
+// the rules of state.mode (looked up once per call; see GameRules.h).
+template <class Board>
+StepResult StepGame(BasicGameState<Board>& state, Action action, int elapsed_ms = 0);
+
+// Runs gravity and the line-clear delay for 'elapsed_ms' milliseconds.
+template <class Board>
+StepResult AdvanceGame(BasicGameState<Board>& state, int elapsed_ms);
+
+// How long until the game changes on its own (next gravity drop, the end of
+// the lock delay, of the line-clear delay or of a timed mode). -1 once the
+// game is over.
+template <class Board>
+int MsUntilNextEvent(const BasicGameState<Board>& state);
+
+#endif
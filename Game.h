@@ -9,105 +9,157 @@
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
-
-// Using a vector of strings to represent the 4x4 grid of a piece.
-// 'X' is a solid block, and '.' is empty space.
-using ShapeMatrix = std::vector<std::string>;
-
-// Keeping the shapes here so they don't clutter up our logic functions.
-// These are the "Blueprints" for every piece in the game.
-const std::vector<ShapeMatrix> TETROMINO_TEMPLATES = {
-    {"....", "XXXX", "....", "...."}, // I
-    {"....", ".X..", ".XXX", "...."}, // J
-    {"....", "..X.", ".XXX", "...."}, // L
-    {"....", ".XX.", ".XX.", "...."}, // O
-    {"....", "..XX", ".XX.", "...."}, // S
-    {"....", ".XXX", "..X.", "...."}, // T
-    {"....", ".XX.", "..XX", "...."}  // Z
-};
-
-// These constants define the size of our game world.
-const int LOGICAL_BOARD_WIDTH = 12; // 10 columns for play + 2 for side walls.
-const int GAME_BOARD_HEIGHT = 22;   // 20 rows for play + 1 top wall + 1 bottom wall.
-
-// A simple structure to hold a piece's shape and its color/type ID.
-struct Piece {
-    ShapeMatrix shape;
-    int id;
-};
-
-// A simple structure to keep track of where a piece is on the grid.
-struct Position {
-    int x;
-    int y;
-};
-
+#include <memory>
+#include "Bot.h"
+#include "Broadcast.h"
+#include "Engine.h"
+#include "Leaderboard.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "Replay.h"
+#include "Scheduler.h"
+#include "Terminal.h"
+
+// The console front-end. All of the rules live in the engine (Engine.h);
+// this class only turns key presses into Actions, feeds the engine real time
+// and draws whatever the GameState looks like.
 class Game {
 public:
     // This sets up everything when you first start the program.
-    Game();
+    // With a replay path, the game plays that recording back at 1x instead.
+    // With a broadcast name, spectators can watch with tetris_viewer.
+    // New games are played in 'mode' (see GameRules.h).
+    explicit Game(const std::string& replay_path = "", const std::string& broadcast_name = "",
+                  GameMode mode = GameMode::Classic);
 
     // This is the main engine that keeps the game running.
     void Run();
 
 private:
     // --- Game World Data ---
-    std::vector<int> board;      // The 2D grid stored as a 1D list for speed.
-    Piece current_piece;         // The piece the player is controlling.
-    Position current_pos;        // The current (x, y) location of that piece.
-    Piece next_piece;            // The "Preview" piece shown on the side.
+    GameState state;             // Board, pieces, score: everything the rules touch.
 
-    // --- Game State Flags ---
+    // --- Front-End Flags ---
     bool show_next_piece = true; // Can be toggled to hide/show the preview.
-    bool is_paused = false;      // Stops the game logic when true.
-    bool is_game_over = false;   // Set to true when the stack reaches the top.
-
-    // --- Line Clearing & Animation ---
-    std::vector<int> lines_to_clear;     // List of rows that are currently full.
-    bool is_clearing_lines = false;      // True when we are playing the "flash" effect.
-    long long line_clear_start_time = 0; // Helps us time the animation delay.
-    const int LINE_CLEAR_DELAY_MS = 300; // How long the clear animation lasts.
-
-    // --- Scoring & Leveling ---
-    int score = 0;
-    int level = 1;
-    int lines_cleared = 0;
+    int preview_count = 5;       // How many upcoming pieces the preview shows (1 to MAX_PREVIEW).
+    static const int MAX_PREVIEW = 6;
+    static const int PREVIEW_COLUMN = 34; // Where the preview sits, counted from the HUD's left edge.
+    bool is_paused = false;      // Stops feeding time to the engine when true (use SetPaused).
+    bool is_running = true;      // Cleared by the quit key to leave Run().
 
     // --- Timing ---
-    // This tracks the last time the piece moved down due to gravity.
-    std::chrono::time_point<std::chrono::system_clock> time_point_start;
-
-    // --- Movement & Physics (Game_Logic.cpp) ---
-    int GetFallSpeedMS() const;
-    bool CheckCollision(const ShapeMatrix& shape, int nextX, int nextY) const;
-    void MovePiece(int deltaX, int deltaY);
-    void LockPiece();
-    bool TryRotationWithWallKicks();
-    ShapeMatrix RotatePiece(const ShapeMatrix& current_shape);
-    void ClearLines();
-    void ShiftLinesDown();
-
-    // --- High-Score (Game_Logic.cpp) ---
-    int high_score = 0;              // To store the record
-    const std::string HIGH_SCORE_FILE = "highscore.txt";
-
-    void LoadHighScore();            // Read from disk
-    void SaveHighScore();            // Write to disk
-    void UpdateHighScore();          // Logic to check if a new record is set
+    // Turns steady_clock time into whole 1ms engine steps (see Scheduler.h).
+    FixedStepClock logic_clock;
+
+    // This run's time, splits, pieces per second and keys per piece. Runs
+    // on steady_clock alongside the engine and stops with it.
+    RunStats run_stats;
+
+    // Input-to-present latency: when the oldest not-yet-shown key press arrived.
+    LatencyStats input_latency;
+    FixedStepClock::Clock::time_point input_time;
+    bool has_pending_input = false;
+
+    // --- Engine Glue (Game_Logic.cpp) ---
+    void Step(Action action, int elapsed_ms); // Runs the engine and reacts to what happened.
+    void AdvanceClock(int elapsed_ms);        // Feeds real time (and replay events) to the engine.
+
+    // --- Autoplay (Game_Logic.cpp) ---
+    std::unique_ptr<Bot> bot;        // Created the first time autoplay is switched on.
+    bool is_autoplaying = false;
+    uint64_t next_bot_frame = 0;     // The game frame the bot may place its next piece at.
+    const int BOT_MOVE_MS = 50;      // 20 pieces a second: fast, but still watchable.
+
+    // --- Rules For Live Games (Game_Logic.cpp) ---
+    const int LOCK_DELAY_MS = 500;   // How long a landed piece can still be slid and turned.
+    GameMode game_mode;              // From --mode, or the mode of the replay being watched.
+
+    void ToggleAutoplay();
+    void RunBot();                   // Plays the current piece if it is the bot's turn.
+
+    // --- Replays (Game_Logic.cpp) ---
+    ReplayWriter replay_writer;      // Records every game as it is played.
+    ReplayReader replay_reader;      // The recording being played back, if any.
+    bool is_replaying = false;
+    const std::string LAST_REPLAY_FILE = "last_game.replay";
+
+    void StartNewGame();             // Fresh seed, fresh recording.
+    void FinishRecording();          // Seal the recording and write it to disk.
+
+    // --- Leaderboard (Game_Logic.cpp) ---
+    // Saved by a background thread, so a new record never stalls the game.
+    Leaderboard leaderboard;
+    LeaderboardEntry current_entry;  // This game's line on the leaderboard.
+    bool was_autoplayed = false;     // Games the bot helped with don't count.
+    const std::string LEADERBOARD_FILE = "leaderboard.txt"; // Classic; the other modes get leaderboard_<mode>.txt.
+    const std::string HIGH_SCORE_FILE = "highscore.txt"; // The old single-number file, read once.
+
+    void SubmitScore();              // Updates this game's leaderboard entry.
+    std::string LeaderboardFile() const;
+
+    // --- Profiling (Game_Render.cpp) ---
+    // The P key swaps the control guide for live timings (see Profiler.h).
+    // The numbers are refreshed twice a second, not every frame, so the
+    // overlay itself doesn't force a redraw on every wake-up.
+    struct ProfileOverlay {
+        ProfileSummary frame, input, logic, draw_board, draw_stats;
+        double collisions_per_second = 0.0;
+        double rotations_per_second = 0.0;
+        double bytes_per_second = 0.0;
+    };
+    bool show_profiler = false;
+    ProfileOverlay profile_overlay;
+    int profile_version = 0;         // Bumped on every refresh, so the HUD redraws.
+    FixedStepClock::Clock::time_point last_profile_refresh;
+    uint64_t last_counter_totals[static_cast<int>(ProfileCounter::Count)] = {};
+    const int PROFILE_REFRESH_MS = 500;
+    const std::string PROFILE_TRACE_FILE = "tetris_trace.json";
+
+    void RefreshProfileOverlay(FixedStepClock::Clock::time_point now);
+    int MsUntilProfileRefresh() const;
+    void DrawProfiler(int x, int y);
+
+    // --- Broadcast (Game_Render.cpp) ---
+    // Every new picture also goes out to any spectators (see Broadcast.h).
+    BroadcastPublisher broadcaster;
+    BroadcastView broadcast_view;
+
+    void PublishBroadcast();
 
     // --- Input & Control (Game_Input.cpp) ---
-    void ProcessInput();
+    void ProcessInput(FixedStepClock::Clock::time_point wake_time); // Handles every waiting key.
+    void HandleKey(char key);
     void ResetGame();
+    void SetPaused(bool paused);     // Pauses (or resumes) the engine and the run clock together.
 
     // --- Initialization (Game_Init.cpp) ---
     void SetupConsole();
-    void InitializeTetrominos();
-    void ResetBoardWithWalls();
+    uint64_t MakeSeed();
 
     // --- Visuals (Game_Render.cpp) ---
-    void SetCursorPosition(int x, int y);
+    // Everything the picture depends on. If it matches the last frame, we skip drawing.
+    struct ViewKey {
+        int piece, x, y, preview, hold;
+        int board_version, lines_to_clear, flash;
+        int score, level, lines, spin, high_score, flags;
+        int time_tenths, pieces_per_second, keys_per_piece, splits, combo;
+        int profile_version;
+    };
+
+    Terminal terminal;               // Talks to the actual console window.
+    Renderer renderer;               // Back/front buffers; only sends what changed.
+    ViewKey last_view = {};
+    bool has_drawn = false;
+    int board_version = 0;           // Bumped whenever a piece locks or lines clear.
+
+    void Render();
+    int NextWakeMS() const;
+    ViewKey CurrentView() const;
+    int FlashPhase() const;
+    int64_t ShownTimeNs() const;     // The clock on the HUD: time so far, or time left in Ultra.
     void DrawBoard();
     void DrawStats();
+    void DrawRunStats(int x);
 };
 
-#endif
\ No newline at end of file
+#endif
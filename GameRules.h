@@ -0,0 +1,106 @@
+#ifndef TETRIS_GAME_RULES_H
+#define TETRIS_GAME_RULES_H
+
+#include <algorithm>
+#include "Engine.h"
+
+// The game modes as rule objects. The engine (Engine.cpp) is compiled once
+// for each of them: StepGame looks at state.mode once per call, and from
+// there every scoring, leveling and end-of-game decision is a direct call
+// into one of these structs, inlined with its constants folded in. There
+// are no virtual calls and no mode checks on the hot path.
+//
+// A rule object has:
+//   LINE_GOAL              Lines that finish the game (0 = endless).
+//   TIME_LIMIT_MS          Game time that finishes the game (0 = none).
+//   ScoreLock(state, n)    A piece just locked and will clear n rows (0-4);
+//                          state.last_spin says whether it was a T-spin.
+//   ScoreClear(state, n)   Those n rows were removed (after the flash).
+//   LevelFor(lines)        The level once 'lines' lines have been cleared.
+// A new mode is a new struct here, a GameMode value and a case in
+// WithRules (Engine.cpp).
+
+// Guideline points for a T-spin, by how many lines it cleared.
+const int T_SPIN_POINTS[3][4] = {
+    {0, 0, 0, 0},           // Not a spin.
+    {100, 200, 400, 400},   // Mini (a mini can't clear three lines).
+    {400, 800, 1200, 1600}  // Full.
+};
+
+// Guideline points for a plain single, double, triple and tetris.
+const int LINE_POINTS[5] = {0, 100, 300, 500, 800};
+
+// The original game: 100 points a line times the level, a new level every
+// 10 lines and no end. T-spins (SRS only) pay their guideline points.
+struct ClassicRules {
+    static constexpr int LINE_GOAL = 0;
+    static constexpr int TIME_LIMIT_MS = 0;
+
+    // The normal 100 a line comes from ScoreClear, so a spin only adds the difference.
+    template <class State>
+    static void ScoreLock(State& state, int lines) {
+        if (state.last_spin == SpinType::None) return;
+        state.score += (T_SPIN_POINTS[static_cast<int>(state.last_spin)][lines] - 100 * lines) * state.level;
+    }
+
+    template <class State>
+    static void ScoreClear(State& state, int lines) {
+        state.score += 100 * lines * state.level;
+    }
+
+    static int LevelFor(int lines) { return lines / 10 + 1; }
+};
+
+// Guideline scoring, paid the moment a piece locks: a single, double,
+// triple or tetris is 100 / 300 / 500 / 800 times the level, T-spins as in
+// T_SPIN_POINTS. A tetris or a T-spin clear right after another one (with
+// no plain clear in between) is back-to-back and pays half as much again,
+// and every clearing lock after the first in an unbroken run adds
+// 50 x combo x level.
+struct GuidelineScoring {
+    template <class State>
+    static void ScoreLock(State& state, int lines) {
+        int spin = static_cast<int>(state.last_spin);
+        int points = (spin == 0) ? LINE_POINTS[lines] : T_SPIN_POINTS[spin][lines];
+        if (lines == 0) {
+            state.combo = -1; // A lock that clears nothing breaks the combo, not back-to-back.
+        } else {
+            bool is_difficult = (lines == 4) || (spin != 0);
+            if (is_difficult && state.back_to_back) points += points / 2;
+            state.back_to_back = is_difficult;
+            state.combo++;
+            points += 50 * state.combo;
+        }
+        state.score += points * state.level;
+    }
+
+    template <class State>
+    static void ScoreClear(State&, int) {}
+};
+
+// Marathon: up a level every 10 lines to level 15, done at 150 lines.
+struct MarathonRules : GuidelineScoring {
+    static constexpr int LINE_GOAL = 150;
+    static constexpr int TIME_LIMIT_MS = 0;
+    static constexpr int MAX_LEVEL = 15;
+
+    static int LevelFor(int lines) { return std::min(lines / 10 + 1, MAX_LEVEL); }
+};
+
+// Sprint: 40 lines against the clock at level 1 speed.
+struct SprintRules : GuidelineScoring {
+    static constexpr int LINE_GOAL = 40;
+    static constexpr int TIME_LIMIT_MS = 0;
+
+    static int LevelFor(int) { return 1; }
+};
+
+// Ultra: the best score in 2 minutes of game time at level 1 speed.
+struct UltraRules : GuidelineScoring {
+    static constexpr int LINE_GOAL = 0;
+    static constexpr int TIME_LIMIT_MS = 2 * 60 * 1000;
+
+    static int LevelFor(int) { return 1; }
+};
+
+#endif
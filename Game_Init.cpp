@@ -1,68 +1,46 @@
 #include "Game.h"
-#include <windows.h>
+#include <cstdio>
 
-// This helper function tells the computer exactly where to draw on the screen.
-// Instead of clearing the whole screen (which makes it flicker), we just
-// move the invisible "pencil" to a specific X and Y spot.
-void Game::SetCursorPosition(int x, int y) {
-    COORD coord;
-    coord.X = x;
-    coord.Y = y;
-    SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), coord);
-}
-
-// This prepares the command prompt window for the game.
+// This prepares the console window for the game: no cursor, a clean screen,
+// and ANSI escape sequences turned on for the renderer.
 void Game::SetupConsole() {
-    HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
-    CONSOLE_CURSOR_INFO cursorInfo;
-
-    // We hide the blinking underscore (the cursor) so it doesn't distract the player.
-    GetConsoleCursorInfo(consoleHandle, &cursorInfo);
-    cursorInfo.bVisible = FALSE;
-    SetConsoleCursorInfo(consoleHandle, &cursorInfo);
-
-    // Wipe any old text and set the window title.
-    system("cls");
-    SetConsoleTitleA("Tetris Game (C++)");
-}
-
-// --- THE DATA ---
-// This is where we define the shapes of the 7 classic Tetris pieces.
-void Game::InitializeTetrominos() {
-    // Pick the first piece that starts falling.
-    int initial_index = rand() % TETROMINO_TEMPLATES.size();
-    current_piece.shape = TETROMINO_TEMPLATES[initial_index];
-    current_piece.id = initial_index + 1;
+    terminal.Setup();
 
-    // Pick the "Next Piece" shown in the preview window.
-    int next_index = rand() % TETROMINO_TEMPLATES.size();
-    next_piece.shape = TETROMINO_TEMPLATES[next_index];
-    next_piece.id = next_index + 1;
-
-    // Start at the top middle.
-    current_pos.x = LOGICAL_BOARD_WIDTH / 2 - 2;
-    current_pos.y = 0;
+    // The screen was just wiped, so the next frame has to repaint everything.
+    renderer.Invalidate();
+    has_drawn = false;
 }
 
-void Game::ResetBoardWithWalls() {
-    // First, make the whole board empty (0).
-    board.assign(LOGICAL_BOARD_WIDTH * GAME_BOARD_HEIGHT, 0);
-
-    // Now, place the '9's to create the frame.
-    for (int y = 0; y < GAME_BOARD_HEIGHT; ++y) {
-        for (int x = 0; x < LOGICAL_BOARD_WIDTH; ++x) {
-            // Logic: If it's the first/last row OR first/last column, it's a wall.
-            if (y == 0 || y == GAME_BOARD_HEIGHT - 1 || x == 0 || x == LOGICAL_BOARD_WIDTH - 1) {
-                board[y * LOGICAL_BOARD_WIDTH + x] = 9;
-            }
-        }
-    }
+// Every new game gets its own seed taken from the clock.
+// This makes sure the game is random every time you play; without it, the
+// "random" pieces would fall in the exact same order every time.
+uint64_t Game::MakeSeed() {
+    return static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
 }
 
 // This is the "Birth" of the game object. It runs once when the game starts.
-Game::Game() {
-    LoadHighScore();
+Game::Game(const std::string& replay_path, const std::string& broadcast_name, GameMode mode) : game_mode(mode) {
+    // A recording brings its own mode, and the HUD's best run has to come
+    // from that mode's leaderboard, so it is loaded before the board is opened.
+    bool has_replay = !replay_path.empty() && replay_reader.LoadFromFile(replay_path);
+    if (has_replay) game_mode = replay_reader.Header().mode;
+
+    // Only the classic board carries the old high score over.
+    leaderboard.Open(LeaderboardFile(), (game_mode == GameMode::Classic) ? HIGH_SCORE_FILE : "");
+
+    // Said before the console is taken over, while it can still be read.
+    broadcast_view.Reset();
+    if (!broadcast_name.empty() && !broadcaster.Open(broadcast_name)) {
+        std::fprintf(stderr, "could not start the broadcast '%s'\n", broadcast_name.c_str());
+    }
     SetupConsole();
-    InitializeTetrominos();
-    ResetBoardWithWalls();
+
+    // Either load a recording to watch, or start (and record) a normal game.
+    if (has_replay) {
+        is_replaying = true;
+        replay_reader.Start(state);
+        run_stats.Start(FixedStepClock::Clock::now());
+    } else {
+        StartNewGame(); // Empty board with walls, first pieces picked.
+    }
 }
\ No newline at end of file
@@ -1,88 +1,122 @@
-#include <cmath>
 #include "Game.h"
-#include <conio.h>
-#include <windows.h>
 
-// This function listens for when you press a key and decides what to do.
-void Game::ProcessInput() {
-    /* _kbhit() checks if a key has been pressed so the game doesn't
-       stop and wait for you; it just keeps running. */
-    if (_kbhit()) {
-        char key = _getch(); // Get the actual character pressed.
-
-        // If the game is over, we only care about the '5' key (Reset).
-        if (is_game_over) {
-            if (key == '5') ResetGame();
-            return;
+// This function handles every key that is waiting, without ever blocking.
+// 'wake_time' is when the loop woke up, i.e. roughly when the keys arrived.
+void Game::ProcessInput(FixedStepClock::Clock::time_point wake_time) {
+    TETRIS_PROFILE_SCOPE("ProcessInput");
+    int key;
+    while ((key = terminal.ReadKey()) != -1) {
+        // Remember when the first key of this batch arrived, so Render can
+        // measure how long it took to show up on screen.
+        if (!has_pending_input) {
+            has_pending_input = true;
+            input_time = wake_time;
         }
+        HandleKey(static_cast<char>(key));
+    }
+}
 
-        // If the game is paused, we only care about '0' (Resume) or '5' (Reset).
-        if (is_paused) {
-            if (key == '0') is_paused = false;
-            if (key == '5') ResetGame();
-            return;
-        }
+// This function decides what a single key press does.
+void Game::HandleKey(char key) {
+    // 'Q' quits from anywhere.
+    if (key == 'q' || key == 'Q') {
+        is_running = false;
+        return;
+    }
 
-        // --- Controls ---
-        switch (key) {
-            case '7': case 'a': case 'A':
-                MovePiece(-1, 0); // Move Left.
-                break;
-            case '9': case 'd': case 'D':
-                MovePiece(1, 0);  // Move Right.
-                break;
-            case '4': case 's': case 'S':
-                MovePiece(0, 1);  // Move Down (Soft Drop).
-                break;
-            case ' ':
-                // Hard Drop: Teleport the piece to the bottom instantly.
-                while (!CheckCollision(current_piece.shape, current_pos.x, current_pos.y + 1)) {
-                    current_pos.y += 1;
-                }
-                LockPiece(); // Stick it to the board immediately.
-                break;
-            case '8': case 'w': case 'W':
-                TryRotationWithWallKicks(); // Spin the piece.
-                break;
-            case '5':
-                ResetGame(); // Start over.
-                break;
-            case '1':
-                show_next_piece = !show_next_piece; // Hide or show the preview.
-                break;
-            case '0':
-                is_paused = !is_paused; // Pause the action.
-                break;
-        }
+    // 'P' shows or hides the profiler, whatever the game is doing.
+    if (key == 'p' || key == 'P') {
+        show_profiler = !show_profiler;
+        return;
     }
-}
 
-// This calculates how fast the piece should fall.
-// As your level goes up, the time between drops gets smaller (faster).
-int Game::GetFallSpeedMS() const {
-    int speed = 500 * std::pow(0.8, level - 1);
+    // If the game is over, we only care about the '5' key (Reset).
+    if (state.is_game_over) {
+        if (key == '5') ResetGame();
+        return;
+    }
 
-    // We set a "speed limit" (50ms) so the game doesn't become impossible.
-    return (speed < 50) ? 50 : speed;
+    // If the game is paused, we only care about '0' (Resume) or '5' (Reset).
+    if (is_paused) {
+        if (key == '0') SetPaused(false);
+        if (key == '5') ResetGame();
+        return;
+    }
+
+    // While watching a replay the recording does the playing; only the
+    // pause, preview and reset keys still work.
+    if (is_replaying && key != '0' && key != '1' && key != '2' && key != '5') {
+        return;
+    }
+
+    // --- Controls ---
+    switch (key) {
+        case '7': case 'a': case 'A':
+            Step(Action::MoveLeft, 0);  // Move Left.
+            break;
+        case '9': case 'd': case 'D':
+            Step(Action::MoveRight, 0); // Move Right.
+            break;
+        case '4': case 's': case 'S':
+            Step(Action::SoftDrop, 0);  // Move Down (Soft Drop).
+            break;
+        case ' ':
+            Step(Action::HardDrop, 0);  // Teleport to the bottom and lock.
+            break;
+        case '8': case 'w': case 'W':
+            Step(Action::Rotate, 0);    // Spin the piece clockwise.
+            break;
+        case 'z': case 'Z':
+            Step(Action::RotateCCW, 0); // Spin it the other way.
+            break;
+        case 'x': case 'X':
+            Step(Action::Rotate180, 0); // Turn it upside down in one go.
+            break;
+        case 'c': case 'C':
+            Step(Action::Hold, 0);      // Save the piece for later.
+            break;
+        case 'b': case 'B':
+            ToggleAutoplay(); // Let the bot play (or take back control).
+            break;
+        case '5':
+            ResetGame(); // Start over.
+            break;
+        case '1':
+            show_next_piece = !show_next_piece; // Hide or show the preview.
+            break;
+        case '2':
+            preview_count = preview_count % MAX_PREVIEW + 1; // Show 1, 2, ... 6 pieces ahead.
+            break;
+        case '0':
+            SetPaused(!is_paused); // Pause the action.
+            break;
+    }
 }
 
 // This function wipes everything clean to start a fresh game.
 void Game::ResetGame() {
-    // Use our helper to clear the board and rebuild the walls.
-    ResetBoardWithWalls();
+    // Keep the recording of the game we are leaving.
+    FinishRecording();
 
-    // Reset all our flags and progress markers.
-    is_game_over = false;
-    is_paused = false;
-    is_clearing_lines = false;
-    score = 0;
-    level = 1;
-    lines_cleared = 0;
+    // The engine clears the board, rebuilds the walls and picks new pieces.
+    StartNewGame();
+    SetPaused(false);
+    next_bot_frame = state.frame;
 
-    // Pick new random pieces and reset the gravity clock.
-    InitializeTetrominos();
-    time_point_start = std::chrono::system_clock::now();
+    // Reset the gravity clock.
+    logic_clock.Reset(FixedStepClock::Clock::now());
 
     // Refresh the console settings.
     SetupConsole();
-}
\ No newline at end of file
+}
+
+// The run clock stops with the game, so time spent paused isn't counted.
+void Game::SetPaused(bool paused) {
+    is_paused = paused;
+    auto now = FixedStepClock::Clock::now();
+    if (paused) {
+        run_stats.Pause(now);
+    } else {
+        run_stats.Resume(now);
+    }
+}
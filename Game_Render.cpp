@@ -1,163 +1,436 @@
 #include "Game.h"
-#include <windows.h>
-#include <conio.h>
+#include "BoardView.h"
+#include "GameRules.h"
+#include <cstdio>
+#include <cstring>
 
 // This function draws the "Heads-Up Display" (HUD) on the right side of the board.
 void Game::DrawStats() {
     /* Calculating the starting X position based on the board width so the
      text always stays to the right of the game. */
-    int startX = (LOGICAL_BOARD_WIDTH * 2) + 4;
+    int startX = PlayfieldScreenWidth(state.board) + 4;
+    char text[64];
 
-    // Draw High Score at the very top of the HUD
-    SetCursorPosition(startX, 0);
-    std::cout << "BEST SCORE: " << high_score << "          ";
+    // Draw the best run at the very top of the HUD: a time in Sprint, a score otherwise.
+    if (game_mode == GameMode::Sprint) {
+        char best[16] = "-";
+        if (leaderboard.Count() > 0) FormatRunTime(leaderboard.Entry(0).time_ns, best, sizeof(best));
+        std::snprintf(text, sizeof(text), "BEST TIME: %s", best);
+    } else {
+        std::snprintf(text, sizeof(text), "BEST SCORE: %d", leaderboard.HighScore());
+    }
+    renderer.Put(startX, 0, text);
 
     // Draw the player's progress and current score.
-    SetCursorPosition(startX, 1); std::cout << "LINES CLEARED: " << lines_cleared << "     ";
-    SetCursorPosition(startX, 3); std::cout << "LEVEL: " << level << "             ";
-    SetCursorPosition(startX, 5); std::cout << "SCORE: " << score << "             ";
-    SetCursorPosition(startX, 7); std::cout << "NEXT PIECE:          ";
-
-    // Draw the "Next Piece" preview box.
-    for (int y = 0; y < 4; ++y) {
-        SetCursorPosition(startX, 8 + y);
-        if (show_next_piece) {
+    if (state.mode == GameMode::Sprint) {
+        std::snprintf(text, sizeof(text), "LINES CLEARED: %d / %d", state.lines_cleared, SprintRules::LINE_GOAL);
+    } else {
+        std::snprintf(text, sizeof(text), "LINES CLEARED: %d", state.lines_cleared);
+    }
+    renderer.Put(startX, 1, text);
+    std::snprintf(text, sizeof(text), "LEVEL: %d", state.level);
+    renderer.Put(startX, 3, text);
+    std::snprintf(text, sizeof(text), "SCORE: %d", state.score);
+    renderer.Put(startX, 5, text);
+
+    // Call out a T-spin until the next piece locks.
+    if (state.last_spin == SpinType::Full) renderer.Put(startX + 16, 5, "T-SPIN!");
+    if (state.last_spin == SpinType::Mini) renderer.Put(startX + 16, 5, "T-SPIN MINI");
+
+    // The guideline modes also call out combos and back-to-back clears.
+    if (state.combo > 0) {
+        std::snprintf(text, sizeof(text), "COMBO x%d", state.combo);
+        renderer.Put(startX, 6, text);
+    }
+    if (state.back_to_back) renderer.Put(startX + 16, 6, "BACK-TO-BACK");
+
+    DrawRunStats(startX);
+
+    // Draw the hold slot. Once it has been used for this piece the piece is
+    // drawn hollow, since it can't be swapped back until the next one.
+    renderer.Put(startX, 7, "HOLD:");
+    if (state.held_type >= 0) {
+        Piece held = {static_cast<uint8_t>(state.held_type), 0};
+        const char* cell = state.can_hold ? "[]" : "::";
+        for (int y = 0; y < 4; ++y) {
             for (int x = 0; x < 4; ++x) {
-                if (next_piece.shape[y][x] == 'X') std::cout << "[]"; // Draw piece block.
-                else std::cout << "  "; // Draw empty space within preview.
+                if (held.HasCell(x, y)) renderer.Put(startX + x * 2, 8 + y, cell);
             }
-            std::cout << "    ";
-        } else {
-            // If the player toggled the preview off, draw blank spaces to hide it.
-            std::cout << "                ";
         }
     }
 
-    // Draw the control guide at the bottom right.
+    // Draw the preview column, straight from the randomizer's queue. Every
+    // piece's template only uses the middle two rows of its grid, so the
+    // pieces are drawn 2 rows tall with a blank row between them.
+    // If the player toggled the preview off, the column simply stays blank.
+    int previewX = startX + PREVIEW_COLUMN;
+    renderer.Put(previewX, 0, "NEXT:");
+    if (show_next_piece) {
+        for (int i = 0; i < preview_count; ++i) {
+            Piece next_piece = PeekPiece(state, i);
+            for (int y = 0; y < 2; ++y) {
+                for (int x = 0; x < 4; ++x) {
+                    if (next_piece.HasCell(x, y + 1)) renderer.Put(previewX + x * 2, 1 + i * 3 + y, "[]");
+                }
+            }
+        }
+    }
+
+    // Draw the control guide at the bottom right. It never changes, so after
+    // the first frame the diff never sends it again.
     int controlsY = 14;
-    SetCursorPosition(startX, controlsY);     std::cout << "A(7): LEFT D(9): RIGHT";
-    SetCursorPosition(startX, controlsY + 1); std::cout << "W(8): ROTATE";
-    SetCursorPosition(startX, controlsY + 3); std::cout << "S(4): SOFT DROP 5: RESET";
-    SetCursorPosition(startX, controlsY + 4); std::cout << "1: SHOW NEXT";
-    SetCursorPosition(startX, controlsY + 5); std::cout << "0: PAUSE / RESUME";
-    SetCursorPosition(startX, controlsY + 6); std::cout << "SPACE - HARD DROP";
+    if (show_profiler) {
+        DrawProfiler(startX, controlsY);
+        renderer.Put(startX, controlsY + 8, "P: PROFILER (ON)");
+        return;
+    }
+    renderer.Put(startX, controlsY,     "A(7): LEFT D(9): RIGHT");
+    renderer.Put(startX, controlsY + 1, "W(8): ROTATE");
+    renderer.Put(startX, controlsY + 2, "Z: ROT LEFT X: 180 C: HOLD");
+    renderer.Put(startX, controlsY + 3, "S(4): SOFT DROP 5: RESET");
+    renderer.Put(startX, controlsY + 4, "1: SHOW NEXT 2: HOW MANY");
+    renderer.Put(startX, controlsY + 5, "0: PAUSE / RESUME");
+    renderer.Put(startX, controlsY + 6, "SPACE - HARD DROP");
+    renderer.Put(startX, controlsY + 7, is_autoplaying ? "B: AUTOPLAY (ON)" : "B: AUTOPLAY");
+    renderer.Put(startX, controlsY + 8, show_profiler ? "P: PROFILER (ON)" : "P: PROFILER");
+}
+
+// The mode, the clock, pieces per second, keys per piece and the splits.
+void Game::DrawRunStats(int x) {
+    char text[64];
+    char time[16];
+    auto now = FixedStepClock::Clock::now();
+
+    FormatRunTime(ShownTimeNs(), time, sizeof(time), run_stats.IsRunning() ? 1 : 3);
+    std::snprintf(text, sizeof(text), "%s %s %s", HudModeTitle(state.mode),
+                  state.mode == GameMode::Ultra ? "LEFT:" : "TIME:", time);
+    renderer.Put(x, 2, text);
+    std::snprintf(text, sizeof(text), "PPS: %.2f  KPP: %.2f", run_stats.PiecesPerSecond(now), run_stats.KeysPerPiece());
+    renderer.Put(x, 4, text);
+
+    // Every 10 lines, newest at the bottom, as many as fit beside the hold slot.
+    const int SHOWN_SPLITS = 6;
+    int split_x = x + 12;
+    if (run_stats.SplitCount() > 0) renderer.Put(split_x, 7, "SPLITS:");
+    int first = std::max(0, run_stats.SplitCount() - SHOWN_SPLITS);
+    for (int i = first; i < run_stats.SplitCount(); ++i) {
+        FormatRunTime(run_stats.SplitNs(i), time, sizeof(time));
+        std::snprintf(text, sizeof(text), "%3d %s", (i + 1) * RunStats::SPLIT_LINES, time);
+        renderer.Put(split_x, 8 + i - first, text);
+    }
+}
+
+// The profiler overlay, drawn over the control guide while it is switched on.
+void Game::DrawProfiler(int x, int y) {
+    char text[64];
+    if (!profiler::IS_ENABLED) {
+        renderer.Put(x, y, "PROFILER NOT BUILT IN");
+        renderer.Put(x, y + 1, "(TETRIS_PROFILING=ON)");
+        return;
+    }
+
+    const ProfileOverlay& overlay = profile_overlay;
+    struct Row {
+        const char* label;
+        const ProfileSummary& summary;
+    };
+    const Row rows[] = {
+        {"FRAME", overlay.frame},    {"INPUT", overlay.input},       {"LOGIC", overlay.logic},
+        {"BOARD", overlay.draw_board}, {"STATS", overlay.draw_stats},
+    };
+
+    renderer.Put(x, y, "PROFILER        p50     p99 ms");
+    for (int i = 0; i < 5; ++i) {
+        std::snprintf(text, sizeof(text), "%-8s %8.3f %8.3f", rows[i].label, rows[i].summary.p50_ms,
+                      rows[i].summary.p99_ms);
+        renderer.Put(x, y + 1 + i, text);
+    }
+    std::snprintf(text, sizeof(text), "CHECKS/S %.0f ROTS/S %.0f", overlay.collisions_per_second,
+                  overlay.rotations_per_second);
+    renderer.Put(x, y + 6, text);
+    std::snprintf(text, sizeof(text), "TERMINAL %.0f B/S", overlay.bytes_per_second);
+    renderer.Put(x, y + 7, text);
+}
+
+// Pulls fresh numbers out of this thread's profiler ring.
+void Game::RefreshProfileOverlay(FixedStepClock::Clock::time_point now) {
+    double seconds = std::chrono::duration<double>(now - last_profile_refresh).count();
+    last_profile_refresh = now;
+    profile_version++;
+
+    profile_overlay.frame = profiler::Summarize("Frame");
+    profile_overlay.input = profiler::Summarize("ProcessInput");
+    profile_overlay.logic = profiler::Summarize("Logic");
+    profile_overlay.draw_board = profiler::Summarize("DrawBoard");
+    profile_overlay.draw_stats = profiler::Summarize("DrawStats");
+
+    double* rates[] = {&profile_overlay.collisions_per_second, &profile_overlay.rotations_per_second,
+                       &profile_overlay.bytes_per_second};
+    for (int i = 0; i < static_cast<int>(ProfileCounter::Count); ++i) {
+        uint64_t total = profiler::CounterTotal(static_cast<ProfileCounter>(i));
+        *rates[i] = seconds > 0.0 ? (total - last_counter_totals[i]) / seconds : 0.0;
+        last_counter_totals[i] = total;
+    }
 }
 
-// This is the core visual engine. It draws every block and empty space on the grid.
+// Draws the playfield, then whichever overlay the front-end needs on top.
 void Game::DrawBoard() {
+    DrawPlayfield(renderer, state, FlashPhase());
+
     // --- GAME OVER OVERLAY ---
-    if (is_game_over) {
-        // Move to the middle of the board
-        int centerX = LOGICAL_BOARD_WIDTH / 2;
-        int centerY = GAME_BOARD_HEIGHT / 2;
-
-        SetCursorPosition(2, centerY - 1); std::cout << "====================";
-        SetCursorPosition(2, centerY);     std::cout << " --- GAME OVER! --- ";
-        SetCursorPosition(2, centerY + 1); std::cout << "  Final Score: " << score << "    "; // <--- Spaces erase the []
-        SetCursorPosition(2, centerY + 2); std::cout << "  Press 5 to Reset  ";
-        SetCursorPosition(2, centerY + 3); std::cout << "====================";
-        return; // EXIT the function here so it doesn't draw the board over the message
-    }
-
-    // --- 2. PAUSE OVERLAY ---
-    if (is_paused) {
-        int centerY = GAME_BOARD_HEIGHT / 2;
-        SetCursorPosition(2, centerY - 1); std::cout << "********************";
-        SetCursorPosition(2, centerY);     std::cout << "   --- PAUSED ---   ";
-        SetCursorPosition(2, centerY + 1); std::cout << "  Press 0 to Resume ";
-        SetCursorPosition(2, centerY + 2); std::cout << "********************";
-        return;
+    int centerY = PlayfieldScreenHeight(state.board) / 2;
+    if (state.is_game_over) {
+        char text[32];
+        if (state.is_goal_reached && state.mode == GameMode::Sprint) {
+            char time[16];
+            FormatRunTime(run_stats.ElapsedNs(FixedStepClock::Clock::now()), time, sizeof(time));
+            std::snprintf(text, sizeof(text), "  Time: %-11s ", time);
+        } else {
+            std::snprintf(text, sizeof(text), "  Final Score: %-5d", state.score);
+        }
+        renderer.Put(2, centerY - 1, "====================");
+        renderer.Put(2, centerY,     state.is_goal_reached ? " --- FINISHED! ---  " : " --- GAME OVER! --- ");
+        renderer.Put(2, centerY + 1, text);
+        renderer.Put(2, centerY + 2, "  Press 5 to Reset  ");
+        renderer.Put(2, centerY + 3, "====================");
+    }
+    // --- PAUSE OVERLAY ---
+    else if (is_paused) {
+        renderer.Put(2, centerY - 1, "********************");
+        renderer.Put(2, centerY,     "   --- PAUSED ---   ");
+        renderer.Put(2, centerY + 1, "  Press 0 to Resume ");
+        renderer.Put(2, centerY + 2, "********************");
     }
+}
 
-    // This moves the "cursor" to the top-left (0,0) and redraw everything.
-    // This is much faster than clearing the screen and prevents flickering.
-    SetCursorPosition(0, 0);
+// Ultra counts down the engine's own clock, so the HUD shows exactly the
+// time the rules have left; every other mode counts the run time up.
+int64_t Game::ShownTimeNs() const {
+    if (state.mode == GameMode::Ultra) {
+        uint64_t limit = static_cast<uint64_t>(UltraRules::TIME_LIMIT_MS);
+        return static_cast<int64_t>(limit > state.frame ? limit - state.frame : 0) * 1000000;
+    }
+    return run_stats.ElapsedNs(FixedStepClock::Clock::now());
+}
 
-    for (int y = 0; y < GAME_BOARD_HEIGHT - 1; ++y) {
-        for (int x = 0; x < LOGICAL_BOARD_WIDTH; ++x) {
-            std::string displayStr = "  ";
-            bool isPieceCell = false;
+// Which half of the 100ms on/off flash we are in (0 or 1).
+int Game::FlashPhase() const {
+    return (state.line_clear_elapsed_ms / 100) % 2;
+}
 
-            // 1. Check if the falling piece is currently over this (x, y) spot.
-            if (x >= current_pos.x && x < current_pos.x + 4 && y >= current_pos.y && y < current_pos.y + 4) {
-                if (current_piece.shape[y - current_pos.y][x - current_pos.x] == 'X') {
-                    displayStr = "[]";
-                    isPieceCell = true;
-                }
-            }
+// Everything the screen depends on, packed so two frames can be compared cheaply.
+Game::ViewKey Game::CurrentView() const {
+    ViewKey view = {};
+    view.piece = state.current_piece.type * 4 + state.current_piece.rotation;
+    view.x = state.current_pos.x;
+    view.y = state.current_pos.y;
+    view.preview = -1;
+    if (show_next_piece) {
+        view.preview = preview_count;
+        for (int i = 0; i < preview_count; ++i) view.preview |= PeekPiece(state, i).type << (3 + 3 * i);
+    }
+    view.hold = (state.held_type + 1) * 2 + (state.can_hold ? 1 : 0);
+    view.board_version = board_version;
+    view.lines_to_clear = static_cast<int>(state.lines_to_clear);
+    view.flash = state.is_clearing_lines ? FlashPhase() : -1;
+    view.score = state.score;
+    view.level = state.level;
+    view.lines = state.lines_cleared;
+    view.spin = static_cast<int>(state.last_spin);
+    view.high_score = leaderboard.HighScore();
+    if (game_mode == GameMode::Sprint && leaderboard.Count() > 0) {
+        view.high_score = static_cast<int>(leaderboard.Entry(0).time_ns / 1000000);
+    }
+    view.time_tenths = static_cast<int>(ShownTimeNs() / 100000000);
+    view.pieces_per_second = static_cast<int>(run_stats.PiecesPerSecond(FixedStepClock::Clock::now()) * 100);
+    view.keys_per_piece = static_cast<int>(run_stats.KeysPerPiece() * 100);
+    view.splits = run_stats.SplitCount();
+    view.combo = state.combo * 2 + (state.back_to_back ? 1 : 0);
+    view.flags = (is_paused ? 1 : 0) | (state.is_game_over ? 2 : 0) | (is_autoplaying ? 4 : 0) |
+                 (show_profiler ? 8 : 0);
+    view.profile_version = show_profiler ? profile_version : 0;
+    return view;
+}
 
-            // 2. If no falling piece is here, check what is stored in the board data.
-            if (!isPieceCell) {
-                int cellValue = board[y * LOGICAL_BOARD_WIDTH + x];
+// Hands the new picture to the spectators. Only called when the picture
+// changed, so an idle game publishes nothing.
+void Game::PublishBroadcast() {
+    if (!broadcaster.IsOpen()) return;
+    TETRIS_PROFILE_SCOPE("Broadcast");
 
-                // Check for line-clearing animation (flashing).
-                if (is_clearing_lines && std::find(lines_to_clear.begin(), lines_to_clear.end(), y) != lines_to_clear.end()) {
-                    long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                        std::chrono::system_clock::now().time_since_epoch()).count() - line_clear_start_time;
-                    // Swap between "##" and " ." every 100ms to create a flash effect.
-                    displayStr = ((elapsed / 100) % 2 == 0) ? "##" : " .";
-                }
-                // Draw walls and bottom edges.
-                else if (cellValue == 9) {
-                    if (y == 0) displayStr = "  "; // Keep top invisible so pieces can spawn.
-                    else if (x == 0) displayStr = "<!"; // Left wall.
-                    else if (x == LOGICAL_BOARD_WIDTH - 1) displayStr = "!>"; // Right wall.
-                }
-                // Draw an empty spot.
-                else if (cellValue == 0) {
-                    displayStr = " .";
-                }
-                // Draw a locked block that landed previously.
-                else {
-                    displayStr = "[]";
-                }
-            }
-            std::cout << displayStr;
+    broadcast_view.Capture(state);
+    broadcast_view.preview_count = static_cast<uint8_t>(show_next_piece ? preview_count : 0);
+
+    // The best run the way the HUD shows it: a time in Sprint, a score otherwise.
+    bool is_sprint = (game_mode == GameMode::Sprint);
+    broadcast_view.high_score = is_sprint ? 0 : leaderboard.HighScore();
+    broadcast_view.best_time_ms = (is_sprint && leaderboard.Count() > 0)
+                                      ? static_cast<uint32_t>(leaderboard.Entry(0).time_ns / 1000000)
+                                      : 0;
+
+    // The run clock, rates and the newest splits, as DrawRunStats draws them.
+    auto now = FixedStepClock::Clock::now();
+    broadcast_view.time_ms = static_cast<uint32_t>(ShownTimeNs() / 1000000);
+    broadcast_view.pieces_per_second =
+        static_cast<uint16_t>(std::min(run_stats.PiecesPerSecond(now) * 100, 65535.0));
+    broadcast_view.keys_per_piece = static_cast<uint16_t>(std::min(run_stats.KeysPerPiece() * 100, 65535.0));
+    int split_count = std::min(run_stats.SplitCount(), 255);
+    int first_split = std::max(0, split_count - BroadcastView::MAX_SPLITS);
+    broadcast_view.split_count = static_cast<uint8_t>(split_count);
+    for (int i = 0; i < BroadcastView::MAX_SPLITS; ++i) {
+        int split = first_split + i;
+        broadcast_view.splits_ms[i] =
+            (split < split_count) ? static_cast<uint32_t>(run_stats.SplitNs(split) / 1000000) : 0;
+    }
+
+    const uint8_t front_end_flags =
+        BroadcastView::PAUSED | BroadcastView::AUTOPLAY | BroadcastView::REPLAY | BroadcastView::CLOCK_RUNNING;
+    broadcast_view.flags &= static_cast<uint8_t>(~front_end_flags);
+    if (is_paused) broadcast_view.flags |= BroadcastView::PAUSED;
+    if (is_autoplaying) broadcast_view.flags |= BroadcastView::AUTOPLAY;
+    if (is_replaying) broadcast_view.flags |= BroadcastView::REPLAY;
+    if (run_stats.IsRunning()) broadcast_view.flags |= BroadcastView::CLOCK_RUNNING;
+    broadcaster.Publish(broadcast_view);
+}
+
+// Draws a new frame only if something on screen would change, and sends just
+// the changed cells in one write.
+void Game::Render() {
+    ViewKey view = CurrentView();
+    if (!has_drawn || std::memcmp(&view, &last_view, sizeof(view)) != 0) {
+        last_view = view;
+        has_drawn = true;
+        PublishBroadcast();
+
+        renderer.BeginFrame();
+        {
+            TETRIS_PROFILE_SCOPE("DrawBoard");
+            DrawBoard();
+        }
+        {
+            TETRIS_PROFILE_SCOPE("DrawStats");
+            DrawStats();
+        }
+
+        TETRIS_PROFILE_SCOPE("Present");
+        const std::string& frame = renderer.Present();
+        if (!frame.empty()) {
+            terminal.Write(frame.data(), frame.size());
+            TETRIS_PROFILE_COUNT(ProfileCounter::TerminalBytes, frame.size());
         }
-        std::cout << "\n";
     }
-    // Draw the fancy floor at the very bottom.
-    std::cout << "<!====================!>\n  \\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\n";
+    // Otherwise it's the same picture as last time: no work, no bytes.
+
+    // Whatever the keys did is on screen now.
+    if (has_pending_input) {
+        input_latency.Record(FixedStepClock::Clock::now() - input_time);
+        has_pending_input = false;
+    }
 }
 
-// This is the heart of the game. It loops forever, handling time and drawing.
+// How long the loop may sleep before the picture or the game changes on its own.
+int Game::NextWakeMS() const {
+    int profile_wait = MsUntilProfileRefresh();
+    if (is_paused || state.is_game_over) return profile_wait; // Nothing moves until a key is pressed.
+
+    int wait = MsUntilNextEvent(state);
+
+    // The line-clear flash toggles every 100ms.
+    if (state.is_clearing_lines) {
+        wait = std::min(wait, 100 - state.line_clear_elapsed_ms % 100);
+    }
+
+    // The bot wakes up for its next placement. It can't place anything while
+    // lines are clearing, so until then the end of the flash is what counts.
+    if (is_autoplaying && !is_replaying && !state.is_clearing_lines) {
+        uint64_t until_bot = (next_bot_frame > state.frame) ? next_bot_frame - state.frame : 0;
+        wait = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(wait), until_bot));
+    }
+
+    // The HUD clock ticks in tenths of a second.
+    if (run_stats.IsRunning()) {
+        int64_t shown_ns = ShownTimeNs();
+        int64_t tenth_ns = 100000000;
+        int64_t into_tenth = shown_ns % tenth_ns;
+        int64_t until_tick = (state.mode == GameMode::Ultra) ? into_tenth : tenth_ns - into_tenth;
+        wait = std::min(wait, static_cast<int>(until_tick / 1000000) + 1);
+    }
+
+    // A replay also wakes up for its next recorded action.
+    uint64_t event_frame;
+    if (is_replaying && replay_reader.PeekFrame(event_frame)) {
+        uint64_t until_event = (event_frame > state.frame) ? event_frame - state.frame : 0;
+        wait = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(wait), until_event));
+    }
+
+    // Part of the next step may already be sitting in the accumulator.
+    int wake_ms = logic_clock.MsUntil(std::max(wait, 0));
+    return (profile_wait < 0) ? wake_ms : std::min(wake_ms, profile_wait);
+}
+
+// The profiler overlay wants fresh numbers twice a second, even while paused.
+// -1 when it isn't showing.
+int Game::MsUntilProfileRefresh() const {
+    if (!show_profiler) return -1;
+    auto since_refresh = std::chrono::duration_cast<std::chrono::milliseconds>(
+        FixedStepClock::Clock::now() - last_profile_refresh);
+    return std::max(0, PROFILE_REFRESH_MS - static_cast<int>(since_refresh.count()));
+}
+
+// This is the heart of the game. It loops until you quit, handling time and drawing.
 void Game::Run() {
-    time_point_start = std::chrono::system_clock::now();
+    logic_clock.Reset(FixedStepClock::Clock::now());
+    last_profile_refresh = FixedStepClock::Clock::now();
 
-    while (true) {
-        ProcessInput(); // Check for keys first.
+    // The first picture, before anything has happened.
+    Render();
 
-        auto now = std::chrono::system_clock::now();
+    while (is_running) {
+        // Sleep until a key arrives, the next gravity tick or the end of the
+        // line-clear animation, whichever comes first. No fixed polling, so an
+        // idle game uses no CPU.
+        terminal.WaitForInput(NextWakeMS());
 
-        if (!is_game_over) {
-            // Case A: Here currently playing the "line clear" animation.
-            if (is_clearing_lines) {
-                long long currentTime = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-                // Wait for the animation delay to finish before dropping blocks.
-                if (currentTime - line_clear_start_time >= LINE_CLEAR_DELAY_MS) {
-                    ShiftLinesDown();
-                }
-            }
-            // Case B: Normal gameplay (not paused).
-            else if (!is_paused) {
-                // Check if enough time has passed for gravity to pull the piece down.
-                if (std::chrono::duration_cast<std::chrono::milliseconds>(now - time_point_start).count() >= GetFallSpeedMS()) {
-                    MovePiece(0, 1);
-                    time_point_start = now; // Reset gravity timer.
-                }
-            }
-            // Case C: Game is paused.
-            else {
-                // Keep the gravity timer "resetting" so the piece doesn't fall immediately after unpausing.
-                time_point_start = now;
+        // A "frame" is everything one wake-up does, up to the screen update.
+        TETRIS_PROFILE_SCOPE("Frame");
+
+        // Read the clock once per wake-up.
+        auto now = FixedStepClock::Clock::now();
+
+        if (!is_paused) {
+            // Hand the engine every whole step that passed since last time.
+            // It runs gravity and the line-clear delay from that on its own.
+            int steps = logic_clock.TakeSteps(now);
+            if (steps > 0) {
+                AdvanceClock(steps);
             }
+        } else {
+            // Drop the paused time so the piece doesn't fall immediately after unpausing.
+            logic_clock.Skip(now);
         }
 
-        // Refresh the screen.
-        DrawBoard();
-        DrawStats();
+        // Keys are applied after time catches up, at the frame they arrived.
+        ProcessInput(now);
+
+        // In autoplay the bot takes its turn once time has caught up.
+        RunBot();
 
-        // A tiny sleep to stop the game from using 100% of the CPU power.
-        Sleep(10);
+        if (show_profiler && MsUntilProfileRefresh() == 0) {
+            RefreshProfileOverlay(now);
+        }
+
+        // Refresh the screen (only if something changed).
+        Render();
+        profiler::SampleCounters();
     }
-}
\ No newline at end of file
+
+    // Keep the recording of an unfinished game and give the console back.
+    FinishRecording();
+    terminal.Restore();
+
+    // Now that the screen is ours again, say how responsive the game was.
+    input_latency.Print(stdout, "input-to-present latency");
+    if (profiler::WriteChromeTrace(PROFILE_TRACE_FILE)) {
+        std::printf("profile trace written to %s (open it in chrome://tracing)\n", PROFILE_TRACE_FILE.c_str());
+    }
+}
@@ -0,0 +1,159 @@
+#include "Leaderboard.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "AtomicFile.h"
+
+namespace {
+
+const char* const FILE_HEADER =
+    "# tetris leaderboard v2: score lines level date seed mode time_ns pps kpp splits split_ns...";
+
+// Higher scores first, or in a sprint the faster time; on a tie the game
+// that got there first stays ahead.
+bool RanksAbove(const LeaderboardEntry& a, const LeaderboardEntry& b) {
+    if (a.mode == GameMode::Sprint) return a.time_ns < b.time_ns;
+    return a.score > b.score;
+}
+
+} // namespace
+
+Leaderboard::~Leaderboard() {
+    if (!writer.joinable()) return;
+
+    stop_writer.store(true, std::memory_order_release);
+    writer_wake.notify_one();
+    writer.join();
+
+    // Whatever the queue couldn't take is written here, on the way out.
+    if (has_unsent_changes) WriteFileAtomically(file_path, Format(table));
+}
+
+void Leaderboard::Open(const std::string& path, const std::string& legacy_path) {
+    file_path = path;
+    table = Table();
+
+    if (!Load(path, table)) {
+        // No leaderboard yet: bring the old single high score over.
+        std::ifstream legacy(legacy_path);
+        int old_score = 0;
+        if (legacy >> old_score && old_score > 0) {
+            table.entries[0].score = old_score;
+            table.count = 1;
+            Publish();
+        }
+    }
+
+    if (!writer.joinable()) writer = std::thread(&Leaderboard::WriterLoop, this);
+}
+
+void Leaderboard::Submit(const LeaderboardEntry& entry) {
+    Table updated = table;
+
+    // Take the game's old entry out first; it is re-inserted at its new rank.
+    int count = 0;
+    for (int i = 0; i < updated.count; ++i) {
+        if (updated.entries[i].seed != entry.seed) updated.entries[count++] = updated.entries[i];
+    }
+
+    int rank = 0;
+    while (rank < count && !RanksAbove(entry, updated.entries[rank])) ++rank;
+
+    if (rank < CAPACITY) {
+        if (count == CAPACITY) --count; // The last place falls off the board.
+        for (int i = count; i > rank; --i) updated.entries[i] = updated.entries[i - 1];
+        updated.entries[rank] = entry;
+        ++count;
+    }
+    updated.count = count;
+
+    bool changed = updated.count != table.count;
+    for (int i = 0; !changed && i < count; ++i) {
+        const LeaderboardEntry& a = updated.entries[i];
+        const LeaderboardEntry& b = table.entries[i];
+        changed = a.score != b.score || a.lines != b.lines || a.level != b.level || a.seed != b.seed ||
+                  a.time_ns != b.time_ns || a.split_count != b.split_count;
+    }
+
+    table = updated;
+    if (changed || has_unsent_changes) Publish();
+}
+
+void Leaderboard::Publish() {
+    has_unsent_changes = !pending.Push(table);
+    writer_wake.notify_one();
+}
+
+// The background thread: waits for tables to show up, skips straight to the
+// newest one (older copies are already out of date) and saves it.
+void Leaderboard::WriterLoop() {
+    while (true) {
+        bool stopping = stop_writer.load(std::memory_order_acquire);
+
+        Table latest;
+        bool has_table = false;
+        while (pending.Pop(latest)) has_table = true;
+        if (has_table) WriteFileAtomically(file_path, Format(latest));
+
+        if (stopping) return;
+
+        std::unique_lock<std::mutex> lock(writer_mutex);
+        writer_wake.wait_for(lock, std::chrono::milliseconds(WRITER_POLL_MS));
+    }
+}
+
+bool Leaderboard::Load(const std::string& path, Table& out) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (out.count < CAPACITY && std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        LeaderboardEntry entry;
+        if (fields >> entry.score >> entry.lines >> entry.level >> entry.date >> entry.seed) {
+            // Version 1 lines stop here.
+            std::string mode_name;
+            if (fields >> mode_name && ParseGameMode(mode_name.c_str(), entry.mode) &&
+                fields >> entry.time_ns >> entry.pieces_per_second >> entry.keys_per_piece >> entry.split_count) {
+                entry.split_count = std::max(0, std::min(entry.split_count, LeaderboardEntry::MAX_SPLITS));
+                for (int i = 0; i < entry.split_count; ++i) {
+                    if (!(fields >> entry.splits_ns[i])) entry.split_count = i;
+                }
+            }
+
+            // Keep the table sorted even if someone edited the file by hand.
+            int rank = out.count;
+            while (rank > 0 && RanksAbove(entry, out.entries[rank - 1])) {
+                out.entries[rank] = out.entries[rank - 1];
+                --rank;
+            }
+            out.entries[rank] = entry;
+            out.count++;
+        }
+    }
+    return true;
+}
+
+std::string Leaderboard::Format(const Table& table) {
+    std::string text = FILE_HEADER;
+    text += '\n';
+    for (int i = 0; i < table.count; ++i) {
+        const LeaderboardEntry& entry = table.entries[i];
+        char line[160];
+        std::snprintf(line, sizeof(line), "%d %d %d %" PRId64 " %" PRIu64 " %s %" PRId64 " %.3f %.3f %d",
+                      entry.score, entry.lines, entry.level, entry.date, entry.seed, GameModeName(entry.mode),
+                      entry.time_ns, entry.pieces_per_second, entry.keys_per_piece, entry.split_count);
+        text += line;
+        for (int split = 0; split < entry.split_count; ++split) {
+            std::snprintf(line, sizeof(line), " %" PRId64, entry.splits_ns[split]);
+            text += line;
+        }
+        text += '\n';
+    }
+    return text;
+}
@@ -0,0 +1,92 @@
+#ifndef TETRIS_LEADERBOARD_H
+#define TETRIS_LEADERBOARD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Engine.h"
+#include "SpscQueue.h"
+
+// One finished (or still running) game on the leaderboard.
+struct LeaderboardEntry {
+    static constexpr int MAX_SPLITS = 16;
+
+    int score = 0;
+    int lines = 0;
+    int level = 1;
+    int64_t date = 0;   // When the game started, in seconds since 1970 (0 = unknown).
+    uint64_t seed = 0;  // The game's randomizer seed, so it can be identified (and replayed).
+
+    // How the run went (see RunStats). Entries from before modes existed
+    // are Classic with no time.
+    GameMode mode = GameMode::Classic;
+    int64_t time_ns = 0;
+    double pieces_per_second = 0.0;
+    double keys_per_piece = 0.0;
+    int split_count = 0;
+    int64_t splits_ns[MAX_SPLITS] = {}; // When every 10th line was reached.
+};
+
+// The best CAPACITY games, highest score first (fastest first in Sprint),
+// kept in a small text file. Each mode has a file of its own.
+//
+// The game thread never touches the disk after Open(): Submit() only updates
+// the in-memory table and drops a copy of it into a lock-free queue. A
+// background writer thread picks up the newest copy and saves it with
+// WriteFileAtomically (temp file + fsync + rename), so a crash mid-save
+// leaves the previous leaderboard intact instead of an empty or torn file.
+class Leaderboard {
+public:
+    static const int CAPACITY = 10;
+
+    Leaderboard() = default;
+    ~Leaderboard(); // Stops the writer, saving anything it hadn't got to yet.
+
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    // Loads 'path' and starts the writer thread. If there is no leaderboard
+    // yet, the old single number in 'legacy_path' (highscore.txt) becomes its
+    // first entry so nobody loses their record.
+    void Open(const std::string& path, const std::string& legacy_path);
+
+    // Adds or updates the entry for a game (matched by seed) and schedules a
+    // save if the table changed. Never blocks.
+    void Submit(const LeaderboardEntry& entry);
+
+    int HighScore() const { return table.count > 0 ? table.entries[0].score : 0; }
+    int Count() const { return table.count; }
+    const LeaderboardEntry& Entry(int rank) const { return table.entries[rank]; }
+
+private:
+    // A plain copy of the whole table: this is what travels to the writer.
+    struct Table {
+        LeaderboardEntry entries[CAPACITY];
+        int count = 0;
+    };
+
+    static bool Load(const std::string& path, Table& out);
+    static std::string Format(const Table& table);
+
+    void Publish();     // Queues the current table for the writer.
+    void WriterLoop();
+
+    std::string file_path;
+    Table table;
+    bool has_unsent_changes = false; // The queue was full last time; try again on the next Submit.
+
+    SpscQueue<Table, 8> pending;
+    std::thread writer;
+    std::atomic<bool> stop_writer{false};
+
+    // Only the writer ever locks this; Submit just pokes the condition
+    // variable. A missed poke costs at most one WRITER_POLL_MS of delay.
+    std::mutex writer_mutex;
+    std::condition_variable writer_wake;
+    static constexpr int WRITER_POLL_MS = 100;
+};
+
+#endif
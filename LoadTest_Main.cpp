@@ -0,0 +1,358 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <vector>
+#include "NetProtocol.h"
+#include "NetSocket.h"
+#include "Scheduler.h"
+
+// Puts a running tetris_server under load over loopback: many bot-ish
+// players in many matches, all driven from one epoll loop. Reports how many
+// matches one server core can carry, how long the server's ticks take, and
+// the input latency players see (input sent -> first delta that includes it).
+//
+// Usage: tetris_loadtest [--connect=ADDRESS] [--matches=100] [--seconds=10] [--inputs-per-sec=8]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// How many inputs can be waiting for their acknowledgement at once.
+const uint32_t SEND_RING = 256;
+
+struct Client {
+    int fd = -1;
+    std::vector<uint8_t> in;
+    int player = -1;
+    bool in_match = false;
+    PlayerView views[VersusMatch::PLAYER_COUNT];
+    uint32_t tick = 0;
+
+    uint32_t inputs_sent = 0;
+    uint32_t inputs_acked = 0;
+    Clock::time_point sent_at[SEND_RING];
+    Clock::time_point next_input;
+    int moves_before_drop = 0;
+    uint64_t rng = 0;
+};
+
+struct Totals {
+    uint64_t matches_finished = 0;
+    uint64_t protocol_errors = 0;
+    uint64_t send_failures = 0;
+    uint64_t deltas = 0;
+    LatencyStats input_latency;
+};
+
+uint64_t NextRandom(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+bool SendAll(int fd, const std::vector<uint8_t>& bytes) {
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        ssize_t sent = ::send(fd, bytes.data() + offset, bytes.size() - offset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            offset += static_cast<size_t>(sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd writable = {fd, POLLOUT, 0};
+            ::poll(&writable, 1, 100);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SendJoin(Client& client, Totals& totals) {
+    std::vector<uint8_t> bytes;
+    { MessageWriter message(bytes, MessageType::Join); }
+    if (!SendAll(client.fd, bytes)) totals.send_failures++;
+}
+
+// Something like a fast player: a few moves, then a hard drop.
+void SendInput(Client& client, Clock::time_point now, Totals& totals) {
+    Action action;
+    if (client.moves_before_drop <= 0) {
+        action = Action::HardDrop;
+        client.moves_before_drop = 1 + static_cast<int>(NextRandom(client.rng) % 5);
+    } else {
+        static const Action MOVES[] = {Action::MoveLeft, Action::MoveRight, Action::Rotate, Action::SoftDrop};
+        action = MOVES[NextRandom(client.rng) % 4];
+        client.moves_before_drop--;
+    }
+
+    if (client.inputs_sent - client.inputs_acked >= SEND_RING) return; // Server is far behind; wait.
+
+    std::vector<uint8_t> bytes;
+    {
+        MessageWriter message(bytes, MessageType::Input);
+        message.U8(static_cast<uint8_t>(action));
+    }
+    if (!SendAll(client.fd, bytes)) {
+        totals.send_failures++;
+        return;
+    }
+    client.sent_at[client.inputs_sent % SEND_RING] = now;
+    client.inputs_sent++;
+}
+
+void HandleMessage(Client& client, const Message& message, Totals& totals, bool measuring) {
+    switch (message.type) {
+        case MessageType::MatchStart: {
+            MessageReader reader(message.payload, message.payload_size);
+            reader.U64(); // Seed: the server's board is the only one that matters here.
+            client.player = reader.U8();
+            client.in_match = true;
+            client.inputs_sent = 0;
+            client.inputs_acked = 0;
+            for (PlayerView& view : client.views) view.Reset();
+            break;
+        }
+        case MessageType::Delta: {
+            if (!ApplyDelta(message.payload, message.payload_size, client.views, client.tick)) {
+                totals.protocol_errors++;
+                break;
+            }
+            totals.deltas++;
+            if (client.player < 0) break;
+
+            uint32_t acked = client.views[client.player].inputs_applied;
+            Clock::time_point now = Clock::now();
+            for (; client.inputs_acked < acked && client.inputs_acked < client.inputs_sent; ++client.inputs_acked) {
+                if (measuring) totals.input_latency.Record(now - client.sent_at[client.inputs_acked % SEND_RING]);
+            }
+            break;
+        }
+        case MessageType::MatchEnd:
+            client.in_match = false;
+            client.player = -1;
+            if (measuring) totals.matches_finished++;
+            SendJoin(client, totals); // Straight into the next one.
+            break;
+        default:
+            totals.protocol_errors++;
+            break;
+    }
+}
+
+// Reads everything waiting on the socket and handles each whole message.
+bool ReadClient(Client& client, Totals& totals, bool measuring) {
+    uint8_t buffer[8192];
+    while (true) {
+        ssize_t received = ::recv(client.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            client.in.insert(client.in.end(), buffer, buffer + received);
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false;
+    }
+
+    size_t offset = 0;
+    Message message;
+    int used;
+    while ((used = ParseMessage(client.in.data() + offset, client.in.size() - offset, message)) > 0) {
+        HandleMessage(client, message, totals, measuring);
+        offset += static_cast<size_t>(used);
+    }
+    if (used < 0) {
+        totals.protocol_errors++;
+        return false;
+    }
+    client.in.erase(client.in.begin(), client.in.begin() + static_cast<std::ptrdiff_t>(offset));
+    return true;
+}
+
+// Asks the server for its numbers on a side connection and waits for the answer.
+bool RequestStats(int fd, bool reset, ServerStats& stats) {
+    std::vector<uint8_t> bytes;
+    {
+        MessageWriter message(bytes, MessageType::Stats);
+        message.U8(reset ? 1 : 0);
+    }
+    if (!SendAll(fd, bytes)) return false;
+
+    std::vector<uint8_t> in;
+    Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+    while (Clock::now() < deadline) {
+        pollfd readable = {fd, POLLIN, 0};
+        ::poll(&readable, 1, 100);
+
+        uint8_t buffer[1024];
+        ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received == 0) return false;
+        if (received > 0) in.insert(in.end(), buffer, buffer + received);
+
+        Message message;
+        if (ParseMessage(in.data(), in.size(), message) > 0) {
+            return message.type == MessageType::StatsReply &&
+                   ReadStatsReply(message.payload, message.payload_size, stats);
+        }
+    }
+    return false;
+}
+
+// Lots of clients means lots of sockets: use every file descriptor we may.
+void RaiseFileLimit() {
+    rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string address = "127.0.0.1:7777";
+    int match_count = 100;
+    double seconds = 10.0;
+    double inputs_per_second = 8.0;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--connect=", 10) == 0) address = arg + 10;
+        else if (std::strncmp(arg, "--matches=", 10) == 0) match_count = std::atoi(arg + 10);
+        else if (std::strncmp(arg, "--seconds=", 10) == 0) seconds = std::atof(arg + 10);
+        else if (std::strncmp(arg, "--inputs-per-sec=", 17) == 0) inputs_per_second = std::atof(arg + 17);
+        else {
+            std::fprintf(stderr, "usage: %s [--connect=ADDRESS] [--matches=N] [--seconds=S] [--inputs-per-sec=K]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+    if (match_count < 1 || seconds <= 0.0 || inputs_per_second <= 0.0) return 2;
+    RaiseFileLimit();
+
+    int stats_fd = ConnectTo(address);
+    if (stats_fd < 0) return 1;
+
+    int epoll_fd = ::epoll_create1(0);
+    std::vector<Client> clients(static_cast<size_t>(match_count) * 2);
+    Totals totals;
+    auto input_gap = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / inputs_per_second));
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        Client& client = clients[i];
+        client.fd = ConnectTo(address);
+        if (client.fd < 0) return 1;
+        client.rng = 0x2545F4914F6CDD1Dull * (i + 1);
+        for (PlayerView& view : client.views) view.Reset();
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client.fd, &event);
+        SendJoin(client, totals);
+    }
+
+    // Inputs go out on a 5ms timer, each client on its own schedule.
+    const uint64_t TIMER_TAG = ~uint64_t(0);
+    int timer_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    itimerspec interval = {};
+    interval.it_interval.tv_nsec = 5000000L;
+    interval.it_value = interval.it_interval;
+    ::timerfd_settime(timer_fd, 0, &interval, nullptr);
+    epoll_event timer_event = {};
+    timer_event.events = EPOLLIN;
+    timer_event.data.u64 = TIMER_TAG;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &timer_event);
+
+    // Runs the clients until 'until'. With 'until_matched', stops early once everyone is playing.
+    auto run = [&](Clock::time_point until, bool measuring, bool until_matched) {
+        epoll_event events[512];
+        while (Clock::now() < until) {
+            if (until_matched) {
+                bool all_matched = true;
+                for (const Client& client : clients) all_matched = all_matched && client.in_match;
+                if (all_matched) return;
+            }
+
+            int count = ::epoll_wait(epoll_fd, events, 512, 50);
+            Clock::time_point now = Clock::now();
+            for (int i = 0; i < count; ++i) {
+                if (events[i].data.u64 == TIMER_TAG) {
+                    uint64_t expirations;
+                    if (::read(timer_fd, &expirations, sizeof(expirations)) < 0) continue;
+                    for (size_t c = 0; c < clients.size(); ++c) {
+                        Client& client = clients[c];
+                        if (!client.in_match || client.fd < 0 || now < client.next_input) continue;
+                        SendInput(client, now, totals);
+                        // Spread the clients out so they don't all fire on the same timer tick.
+                        client.next_input = now + input_gap + std::chrono::milliseconds(NextRandom(client.rng) % 5);
+                    }
+                    continue;
+                }
+
+                Client& client = clients[events[i].data.u64];
+                if (!ReadClient(client, totals, measuring)) {
+                    std::fprintf(stderr, "server closed client %llu\n", static_cast<unsigned long long>(events[i].data.u64));
+                    ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client.fd, nullptr);
+                    ::close(client.fd);
+                    client.fd = -1;
+                    client.in_match = false;
+                }
+            }
+        }
+    };
+
+    // Warm up until every client is in a match, then measure a clean window.
+    run(Clock::now() + std::chrono::seconds(5), false, true);
+
+    ServerStats start_stats;
+    if (!RequestStats(stats_fd, true, start_stats)) {
+        std::fprintf(stderr, "no stats from the server (is it running at %s?)\n", address.c_str());
+        return 1;
+    }
+    Clock::time_point window_start = Clock::now();
+    run(window_start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds)), true, false);
+
+    ServerStats stats;
+    if (!RequestStats(stats_fd, false, stats)) {
+        std::fprintf(stderr, "no stats from the server at the end of the run\n");
+        return 1;
+    }
+
+    double wall_seconds = stats.wall_us / 1e6;
+    double cpu_seconds = stats.cpu_us / 1e6;
+    double core_share = wall_seconds > 0 ? cpu_seconds / wall_seconds : 0.0;
+
+    std::printf("matches:          %d concurrent (%zu clients), %llu finished and restarted\n", match_count,
+                clients.size(), static_cast<unsigned long long>(totals.matches_finished));
+    std::printf("seconds:          %.2f\n", wall_seconds);
+    std::printf("server ticks:     %llu\n", static_cast<unsigned long long>(stats.ticks));
+    std::printf("server cpu:       %.3f s (%.1f%% of one core)\n", cpu_seconds, core_share * 100.0);
+    std::printf("matches per core: %.0f\n", core_share > 0 ? match_count / core_share : 0.0);
+    std::printf("tick time:        p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n", stats.tick_p50_ns / 1e6,
+                stats.tick_p90_ns / 1e6, stats.tick_p99_ns / 1e6, stats.tick_max_ns / 1e6);
+    totals.input_latency.Print(stdout, "input latency   ");
+    std::printf("bandwidth:        %.0f bytes/s (%.0f per match per second), %llu deltas received\n",
+                wall_seconds > 0 ? stats.bytes_sent / wall_seconds : 0.0,
+                wall_seconds > 0 ? stats.bytes_sent / wall_seconds / match_count : 0.0,
+                static_cast<unsigned long long>(totals.deltas));
+    std::printf("errors:           %llu protocol, %llu send\n", static_cast<unsigned long long>(totals.protocol_errors),
+                static_cast<unsigned long long>(totals.send_failures));
+
+    for (Client& client : clients) {
+        if (client.fd >= 0) ::close(client.fd);
+    }
+    ::close(stats_fd);
+    ::close(timer_fd);
+    ::close(epoll_fd);
+    return totals.protocol_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,429 @@
+#include "MatchServer.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "NetSocket.h"
+
+namespace {
+
+// What an epoll event belongs to: a client connection is just its index,
+// everything else is tagged in the high bits.
+const uint64_t LISTENER_TAG = uint64_t(1) << 32;
+const uint64_t TIMER_TAG = uint64_t(2) << 32;
+
+// Never run more than this many ticks' worth of time in one go after a
+// stall, so one slow tick can't snowball.
+const int MAX_CATCH_UP_TICKS = 10;
+
+uint64_t CpuMicroseconds() {
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           static_cast<uint64_t>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+} // namespace
+
+MatchServer::MatchServer(const ServerConfig& server_config)
+    : config(server_config),
+      next_seed(static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count())) {
+    ResetWindow();
+}
+
+MatchServer::~MatchServer() {
+    for (Connection& connection : connections) {
+        if (connection.fd >= 0) ::close(connection.fd);
+    }
+    for (int fd : listen_fds) ::close(fd);
+    if (timer_fd >= 0) ::close(timer_fd);
+    if (epoll_fd >= 0) ::close(epoll_fd);
+
+    // Don't leave socket files behind.
+    for (const std::string& address : config.addresses) {
+        if (address.compare(0, 5, "unix:") == 0) ::unlink(address.c_str() + 5);
+    }
+}
+
+bool MatchServer::Open() {
+    epoll_fd = ::epoll_create1(0);
+    if (epoll_fd < 0) return false;
+
+    for (const std::string& address : config.addresses) {
+        int fd = ListenOn(address);
+        if (fd < 0) return false;
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = LISTENER_TAG | listen_fds.size();
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        listen_fds.push_back(fd);
+    }
+
+    // The tick is a timer in the same epoll set, so one epoll_wait covers everything.
+    timer_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (timer_fd < 0) return false;
+    itimerspec interval = {};
+    interval.it_interval.tv_sec = config.tick_ms / 1000;
+    interval.it_interval.tv_nsec = (config.tick_ms % 1000) * 1000000L;
+    interval.it_value = interval.it_interval;
+    ::timerfd_settime(timer_fd, 0, &interval, nullptr);
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = TIMER_TAG;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
+
+    scratch.reserve(MAX_MESSAGE_SIZE);
+    ResetWindow();
+    return true;
+}
+
+void MatchServer::Run(const volatile std::sig_atomic_t& stop) {
+    epoll_event events[256];
+    while (!stop) {
+        // The timeout only matters for noticing 'stop'; the tick timer wakes us otherwise.
+        int count = ::epoll_wait(epoll_fd, events, 256, 250);
+        if (count < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < count; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == TIMER_TAG) {
+                uint64_t expirations = 0;
+                if (::read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations) && expirations > 0) {
+                    int catch_up = expirations < MAX_CATCH_UP_TICKS ? static_cast<int>(expirations) : MAX_CATCH_UP_TICKS;
+                    Tick(catch_up * config.tick_ms);
+                }
+            } else if (tag & LISTENER_TAG) {
+                Accept(listen_fds[tag & 0xFFFFFFFFu]);
+            } else {
+                int index = static_cast<int>(tag);
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) Drop(index);
+                if (events[i].events & EPOLLIN) HandleReadable(index);
+                if (events[i].events & EPOLLOUT) HandleWritable(index);
+            }
+        }
+        ReapClosed();
+    }
+}
+
+void MatchServer::Accept(int listen_fd) {
+    int fd;
+    while ((fd = AcceptFrom(listen_fd)) >= 0) {
+        int index;
+        if (!free_connections.empty()) {
+            index = free_connections.back();
+            free_connections.pop_back();
+        } else {
+            index = static_cast<int>(connections.size());
+            connections.emplace_back();
+        }
+
+        Connection& connection = connections[index];
+        connection = Connection();
+        connection.fd = fd;
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = static_cast<uint64_t>(index);
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void MatchServer::HandleReadable(int index) {
+    Connection& connection = connections[index];
+    if (connection.is_closing) return;
+
+    uint8_t buffer[4096];
+    while (true) {
+        ssize_t received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            connection.in.insert(connection.in.end(), buffer, buffer + received);
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (received < 0 && errno == EINTR) continue;
+        Drop(index); // 0 = the client hung up; anything else is an error.
+        return;
+    }
+
+    // Handle every whole message; keep a partial one for next time.
+    size_t offset = 0;
+    while (!connections[index].is_closing) {
+        Connection& current = connections[index];
+        Message message;
+        int used = ParseMessage(current.in.data() + offset, current.in.size() - offset, message);
+        if (used == 0) break;
+        if (used < 0 || !HandleMessage(index, message)) {
+            Drop(index);
+            return;
+        }
+        offset += static_cast<size_t>(used);
+    }
+    Connection& current = connections[index];
+    current.in.erase(current.in.begin(), current.in.begin() + static_cast<std::ptrdiff_t>(offset));
+}
+
+bool MatchServer::HandleMessage(int index, const Message& message) {
+    Connection& connection = connections[index];
+    switch (message.type) {
+        case MessageType::Join:
+            Join(index);
+            return true;
+
+        case MessageType::Input:
+            // Inputs outside a match (e.g. sent just before it ended) mean nothing.
+            if (connection.match < 0) return true;
+            for (size_t i = 0; i < message.payload_size; ++i) {
+                uint8_t action = message.payload[i];
+                if (action > static_cast<uint8_t>(Action::Hold)) return false;
+                if (connection.queued_count < MAX_QUEUED_INPUTS) {
+                    connection.queued[connection.queued_count++] = static_cast<Action>(action);
+                } else {
+                    connection.inputs_applied++; // Dropped, but still acknowledged.
+                }
+            }
+            return true;
+
+        case MessageType::Stats: {
+            MessageReader reader(message.payload, message.payload_size);
+            bool reset = reader.U8() != 0;
+            scratch.clear();
+            WriteStatsReply(Stats(), scratch);
+            Send(index, scratch.data(), scratch.size());
+            if (reset) ResetWindow();
+            return true;
+        }
+
+        default:
+            return false; // Clients never send server messages.
+    }
+}
+
+// Pairs this connection with whoever has been waiting, or makes it wait.
+void MatchServer::Join(int index) {
+    Connection& connection = connections[index];
+    if (connection.match >= 0) return;
+    if (waiting < 0 || waiting == index) {
+        waiting = index;
+        return;
+    }
+
+    int match_index;
+    if (!free_matches.empty()) {
+        match_index = free_matches.back();
+        free_matches.pop_back();
+    } else {
+        match_index = static_cast<int>(matches.size());
+        matches.emplace_back();
+    }
+
+    Match& match = matches[match_index];
+    uint64_t seed = (next_seed += 0x9E3779B97F4A7C15ull);
+    match.game.Start(seed);
+    match.encoder.Reset();
+    match.tick = 0;
+    match.in_use = true;
+    match.connections[0] = waiting;
+    match.connections[1] = index;
+    waiting = -1;
+    active_matches++;
+    matches_started++;
+
+    for (int player = 0; player < VersusMatch::PLAYER_COUNT; ++player) {
+        Connection& member = connections[match.connections[player]];
+        member.match = match_index;
+        member.player = player;
+        member.queued_count = 0;
+        member.inputs_applied = 0;
+
+        scratch.clear();
+        {
+            MessageWriter message(scratch, MessageType::MatchStart);
+            message.U64(seed);
+            message.U8(player);
+        }
+        Send(match.connections[player], scratch.data(), scratch.size());
+    }
+}
+
+void MatchServer::Tick(int elapsed_ms) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (int m = 0; m < static_cast<int>(matches.size()); ++m) {
+        Match& match = matches[m];
+        if (!match.in_use) continue;
+
+        uint32_t acks[VersusMatch::PLAYER_COUNT];
+        for (int player = 0; player < VersusMatch::PLAYER_COUNT; ++player) {
+            Connection& connection = connections[match.connections[player]];
+            for (int i = 0; i < connection.queued_count; ++i) {
+                match.game.Apply(player, connection.queued[i]);
+            }
+            connection.inputs_applied += static_cast<uint32_t>(connection.queued_count);
+            connection.queued_count = 0;
+            acks[player] = connection.inputs_applied;
+        }
+        match.game.Advance(elapsed_ms);
+        match.tick++;
+
+        scratch.clear();
+        if (match.encoder.Encode(match.tick, match.game, acks, scratch)) {
+            for (int connection : match.connections) Send(connection, scratch.data(), scratch.size());
+        }
+        if (match.game.IsOver()) EndMatch(m);
+    }
+
+    ticks++;
+    tick_times.Record(std::chrono::steady_clock::now() - start);
+}
+
+void MatchServer::EndMatch(int match_index) {
+    Match& match = matches[match_index];
+    int winner = match.game.Winner();
+
+    scratch.clear();
+    {
+        MessageWriter message(scratch, MessageType::MatchEnd);
+        message.U8(winner == VersusMatch::NO_WINNER ? DRAW_WINNER : static_cast<uint8_t>(winner));
+    }
+    for (int index : match.connections) {
+        Send(index, scratch.data(), scratch.size());
+        connections[index].match = -1;
+        connections[index].queued_count = 0;
+    }
+
+    match.in_use = false;
+    free_matches.push_back(match_index);
+    active_matches--;
+}
+
+// Sends straight away when nothing is queued in front of it; whatever the
+// socket won't take waits in the connection's output buffer for EPOLLOUT.
+void MatchServer::Send(int index, const uint8_t* data, size_t size) {
+    Connection& connection = connections[index];
+    if (connection.is_closing) return;
+    bytes_sent += size;
+
+    if (connection.out_offset == connection.out.size()) {
+        connection.out.clear();
+        connection.out_offset = 0;
+        while (size > 0) {
+            ssize_t sent = ::send(connection.fd, data, size, MSG_NOSIGNAL);
+            if (sent > 0) {
+                data += sent;
+                size -= static_cast<size_t>(sent);
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                Drop(index);
+                return;
+            }
+        }
+        if (size == 0) return;
+    }
+
+    connection.out.insert(connection.out.end(), data, data + size);
+    if (connection.out.size() - connection.out_offset > MAX_PENDING_OUTPUT) {
+        Drop(index); // It isn't reading; don't let it eat the server's memory.
+        return;
+    }
+    WatchWrites(connection, true);
+}
+
+void MatchServer::HandleWritable(int index) {
+    Connection& connection = connections[index];
+    if (!connection.is_closing) Flush(connection);
+}
+
+void MatchServer::Flush(Connection& connection) {
+    while (connection.out_offset < connection.out.size()) {
+        ssize_t sent = ::send(connection.fd, connection.out.data() + connection.out_offset,
+                              connection.out.size() - connection.out_offset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.out_offset += static_cast<size_t>(sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            Drop(static_cast<int>(&connection - connections.data()));
+            return;
+        }
+    }
+    connection.out.clear();
+    connection.out_offset = 0;
+    WatchWrites(connection, false);
+}
+
+void MatchServer::WatchWrites(Connection& connection, bool enable) {
+    if (connection.wants_write == enable) return;
+    connection.wants_write = enable;
+
+    epoll_event event = {};
+    event.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.u64 = static_cast<uint64_t>(&connection - connections.data());
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+// Closing right away could free a slot that a later event in the same
+// epoll batch still points at, so connections are only marked here.
+void MatchServer::Drop(int index) {
+    Connection& connection = connections[index];
+    if (connection.is_closing) return;
+    connection.is_closing = true;
+    closing.push_back(index);
+}
+
+void MatchServer::ReapClosed() {
+    // Ending a match can drop the opponent too, so keep going until it settles.
+    for (size_t i = 0; i < closing.size(); ++i) {
+        int index = closing[i];
+        Connection& connection = connections[index];
+
+        if (connection.match >= 0) {
+            Match& match = matches[connection.match];
+            match.game.Forfeit(connection.player);
+            EndMatch(connection.match);
+        }
+        if (waiting == index) waiting = -1;
+
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr);
+        ::close(connection.fd);
+        connection = Connection();
+        free_connections.push_back(index);
+    }
+    closing.clear();
+}
+
+ServerStats MatchServer::Stats() const {
+    LatencyStats::Summary summary = tick_times.Summarize();
+    auto wall = std::chrono::steady_clock::now() - window_start;
+
+    ServerStats stats;
+    stats.ticks = ticks;
+    stats.active_matches = active_matches;
+    stats.matches_started = matches_started;
+    stats.cpu_us = CpuMicroseconds() - window_cpu_us;
+    stats.wall_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(wall).count());
+    stats.bytes_sent = bytes_sent;
+    stats.tick_p50_ns = static_cast<uint64_t>(summary.p50_ns);
+    stats.tick_p90_ns = static_cast<uint64_t>(summary.p90_ns);
+    stats.tick_p99_ns = static_cast<uint64_t>(summary.p99_ns);
+    stats.tick_max_ns = static_cast<uint64_t>(summary.max_ns);
+    return stats;
+}
+
+void MatchServer::ResetWindow() {
+    ticks = 0;
+    bytes_sent = 0;
+    matches_started = 0;
+    tick_times.Clear();
+    window_start = std::chrono::steady_clock::now();
+    window_cpu_us = CpuMicroseconds();
+}
@@ -0,0 +1,112 @@
+#ifndef TETRIS_MATCH_SERVER_H
+#define TETRIS_MATCH_SERVER_H
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "NetProtocol.h"
+#include "Scheduler.h"
+#include "Versus.h"
+
+struct ServerConfig {
+    std::vector<std::string> addresses;  // See NetSocket.h: "unix:/path" or "host:port".
+    int tick_ms = 16;                    // How often every match moves forward and sends its delta.
+};
+
+// The versus match server. One thread runs everything: a single epoll loop
+// watches the listening sockets, every client socket and a tick timer, so
+// thousands of matches cost no threads and no locks.
+//
+// Each match has one authoritative VersusMatch. Clients only send inputs;
+// those queue up on their connection until the next tick, when they are
+// applied in order, time moves forward by one tick, and both players get a
+// delta of whatever changed. Linux only (epoll, timerfd).
+class MatchServer {
+public:
+    explicit MatchServer(const ServerConfig& config);
+    ~MatchServer();
+
+    MatchServer(const MatchServer&) = delete;
+    MatchServer& operator=(const MatchServer&) = delete;
+
+    // Opens the sockets and the timer. Returns false if any of them failed.
+    bool Open();
+
+    // Serves until 'stop' becomes non-zero (e.g. from a signal handler).
+    void Run(const volatile std::sig_atomic_t& stop);
+
+    // Load numbers since the last window reset.
+    ServerStats Stats() const;
+
+private:
+    // Inputs past this many per tick are dropped: nobody presses keys that fast.
+    static const int MAX_QUEUED_INPUTS = 32;
+
+    // A client that lets this much unsent data pile up is cut off.
+    static const size_t MAX_PENDING_OUTPUT = 256 * 1024;
+
+    struct Connection {
+        int fd = -1;
+        std::vector<uint8_t> in;    // Bytes received but not yet a whole message.
+        std::vector<uint8_t> out;   // Bytes the socket hasn't taken yet.
+        size_t out_offset = 0;
+        bool wants_write = false;   // Waiting for EPOLLOUT.
+        bool is_closing = false;    // Closed at the end of this loop iteration.
+        int match = -1;
+        int player = 0;
+        Action queued[MAX_QUEUED_INPUTS];
+        int queued_count = 0;
+        uint32_t inputs_applied = 0; // Inputs used (or dropped) since the match started.
+    };
+
+    struct Match {
+        VersusMatch game;
+        DeltaEncoder encoder;
+        int connections[VersusMatch::PLAYER_COUNT] = {-1, -1};
+        uint32_t tick = 0;
+        bool in_use = false;
+    };
+
+    void Accept(int listen_fd);
+    void HandleReadable(int index);
+    void HandleWritable(int index);
+    bool HandleMessage(int index, const Message& message);
+    void Join(int index);
+    void Tick(int elapsed_ms);
+    void EndMatch(int match_index);
+
+    void Send(int index, const uint8_t* data, size_t size);
+    void Flush(Connection& connection);
+    void WatchWrites(Connection& connection, bool enable);
+    void Drop(int index);
+    void ReapClosed();
+    void ResetWindow();
+
+    ServerConfig config;
+    int epoll_fd = -1;
+    int timer_fd = -1;
+    std::vector<int> listen_fds;
+
+    std::vector<Connection> connections;
+    std::vector<int> free_connections;
+    std::vector<int> closing;
+    std::vector<Match> matches;
+    std::vector<int> free_matches;
+    int waiting = -1;                 // The connection waiting for an opponent, if any.
+    uint64_t next_seed;
+
+    std::vector<uint8_t> scratch;     // One tick's delta, sent to both players.
+
+    // --- Load numbers (see ServerStats) ---
+    uint32_t active_matches = 0;
+    uint64_t matches_started = 0;
+    uint64_t ticks = 0;
+    uint64_t bytes_sent = 0;
+    LatencyStats tick_times;
+    std::chrono::steady_clock::time_point window_start;
+    uint64_t window_cpu_us = 0;
+};
+
+#endif
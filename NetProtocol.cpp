@@ -0,0 +1,276 @@
+#include "NetProtocol.h"
+#include <cstring>
+
+namespace {
+
+// Which fields a player's record in a Delta carries, in this order.
+enum DeltaField : uint8_t {
+    FIELD_PIECE = 1,      // uint8 type | rotation << 4, int8 x, int8 y, uint8 next type
+    FIELD_STATS = 2,      // uint32 score, uint16 lines, uint8 level
+    FIELD_GARBAGE = 4,    // uint8 pending garbage rows (capped at 255)
+    FIELD_ACK = 8,        // uint32 inputs applied
+    FIELD_ROWS = 16,      // uint32 changed rows (bit y = row y), then 5 bytes per row
+    FIELD_GAME_OVER = 32  // (no data) this player has topped out
+};
+
+bool SamePiece(const PlayerView& a, const PlayerView& b) {
+    return a.has_piece == b.has_piece && a.piece.type == b.piece.type && a.piece.rotation == b.piece.rotation &&
+           a.pos.x == b.pos.x && a.pos.y == b.pos.y && a.next_type == b.next_type;
+}
+
+} // namespace
+
+MessageWriter::MessageWriter(std::vector<uint8_t>& out, MessageType type) : out(out), start(out.size()) {
+    U16(0); // Patched in the destructor.
+    U8(static_cast<uint8_t>(type));
+}
+
+MessageWriter::~MessageWriter() {
+    size_t size = out.size() - start - 2;
+    out[start] = static_cast<uint8_t>(size);
+    out[start + 1] = static_cast<uint8_t>(size >> 8);
+}
+
+void MessageWriter::U16(uint32_t value) {
+    U8(value);
+    U8(value >> 8);
+}
+
+void MessageWriter::U32(uint32_t value) {
+    U16(value);
+    U16(value >> 16);
+}
+
+void MessageWriter::U64(uint64_t value) {
+    U32(static_cast<uint32_t>(value));
+    U32(static_cast<uint32_t>(value >> 32));
+}
+
+uint8_t MessageReader::U8() {
+    if (offset >= size) {
+        ok = false;
+        return 0;
+    }
+    return data[offset++];
+}
+
+uint16_t MessageReader::U16() {
+    uint16_t low = U8();
+    return static_cast<uint16_t>(low | (U8() << 8));
+}
+
+uint32_t MessageReader::U32() {
+    uint32_t low = U16();
+    return low | (static_cast<uint32_t>(U16()) << 16);
+}
+
+uint64_t MessageReader::U64() {
+    uint64_t low = U32();
+    return low | (static_cast<uint64_t>(U32()) << 32);
+}
+
+int ParseMessage(const uint8_t* data, size_t size, Message& message) {
+    if (size < MESSAGE_HEADER_SIZE) return 0;
+
+    size_t body = data[0] | (data[1] << 8);
+    if (body == 0 || body + 2 > MAX_MESSAGE_SIZE) return -1;
+    if (size < body + 2) return 0;
+
+    message.type = static_cast<MessageType>(data[2]);
+    message.payload = data + MESSAGE_HEADER_SIZE;
+    message.payload_size = body - 1;
+    return static_cast<int>(body + 2);
+}
+
+void PlayerView::Reset() {
+    std::memset(cells, 0, sizeof(cells));
+    piece = Piece();
+    pos = Position{0, 0};
+    next_type = 0;
+    score = 0;
+    lines = 0;
+    level = 1;
+    pending_garbage = 0;
+    inputs_applied = 0;
+    has_piece = false;
+    is_game_over = false;
+}
+
+void PlayerView::ToState(GameState& state) const {
+    state.board.Reset();
+    for (int y = 1; y < GAME_BOARD_HEIGHT - 1; ++y) {
+        for (int x = 0; x < PLAY_WIDTH; ++x) {
+            if (cells[y][x] == 0) continue;
+            state.board.rows[y] |= static_cast<RowMask>(1u << (x + 1));
+            state.board.colors[y][x + 1] = cells[y][x];
+        }
+    }
+    state.board.RebuildColumnTops();
+    state.current_piece = piece;
+    state.current_pos = has_piece ? pos : Position{-8, -8}; // Off screen until we know.
+    state.is_game_over = is_game_over;
+    state.is_clearing_lines = false;
+    state.lines_to_clear = 0;
+    state.score = score;
+    state.lines_cleared = lines;
+    state.level = level;
+}
+
+void DeltaEncoder::Reset() {
+    for (PlayerView& view : sent) view.Reset();
+}
+
+bool DeltaEncoder::Encode(uint32_t tick, const VersusMatch& match,
+                          const uint32_t inputs_applied[VersusMatch::PLAYER_COUNT], std::vector<uint8_t>& out) {
+    // First work out what changed, into a view of "now".
+    PlayerView now[VersusMatch::PLAYER_COUNT];
+    uint8_t flags[VersusMatch::PLAYER_COUNT] = {};
+    RowSet changed_rows[VersusMatch::PLAYER_COUNT] = {};
+    int record_count = 0;
+
+    for (int p = 0; p < VersusMatch::PLAYER_COUNT; ++p) {
+        const GameState& state = match.State(p);
+        const PlayerView& last = sent[p];
+        PlayerView& view = now[p];
+        view = last;
+
+        view.piece = state.current_piece;
+        view.pos = state.current_pos;
+        view.next_type = PeekPiece(state, 0).type;
+        view.has_piece = true;
+        view.score = state.score;
+        view.lines = state.lines_cleared;
+        view.level = state.level;
+        view.pending_garbage = match.PendingGarbage(p) < 255 ? match.PendingGarbage(p) : 255;
+        view.inputs_applied = inputs_applied[p];
+        view.is_game_over = state.is_game_over;
+
+        for (int y = 1; y < GAME_BOARD_HEIGHT - 1; ++y) {
+            const uint8_t* colors = state.board.ColorRow(y) + 1;
+            if (std::memcmp(view.cells[y], colors, PlayerView::PLAY_WIDTH) != 0) {
+                std::memcpy(view.cells[y], colors, PlayerView::PLAY_WIDTH);
+                changed_rows[p] |= RowSet(1) << y;
+            }
+        }
+
+        if (!SamePiece(view, last)) flags[p] |= FIELD_PIECE;
+        if (view.score != last.score || view.lines != last.lines || view.level != last.level) flags[p] |= FIELD_STATS;
+        if (view.pending_garbage != last.pending_garbage) flags[p] |= FIELD_GARBAGE;
+        if (view.inputs_applied != last.inputs_applied) flags[p] |= FIELD_ACK;
+        if (changed_rows[p] != 0) flags[p] |= FIELD_ROWS;
+        if (view.is_game_over && !last.is_game_over) flags[p] |= FIELD_GAME_OVER;
+        if (flags[p] != 0) record_count++;
+    }
+    if (record_count == 0) return false;
+
+    MessageWriter message(out, MessageType::Delta);
+    message.U32(tick);
+    message.U8(record_count);
+    for (int p = 0; p < VersusMatch::PLAYER_COUNT; ++p) {
+        if (flags[p] == 0) continue;
+        const PlayerView& view = now[p];
+        message.U8(p);
+        message.U8(flags[p]);
+
+        if (flags[p] & FIELD_PIECE) {
+            message.U8(view.piece.type | (view.piece.rotation << 4));
+            message.U8(static_cast<uint8_t>(static_cast<int8_t>(view.pos.x)));
+            message.U8(static_cast<uint8_t>(static_cast<int8_t>(view.pos.y)));
+            message.U8(view.next_type);
+        }
+        if (flags[p] & FIELD_STATS) {
+            message.U32(static_cast<uint32_t>(view.score));
+            message.U16(static_cast<uint32_t>(view.lines));
+            message.U8(static_cast<uint32_t>(view.level));
+        }
+        if (flags[p] & FIELD_GARBAGE) message.U8(static_cast<uint32_t>(view.pending_garbage));
+        if (flags[p] & FIELD_ACK) message.U32(view.inputs_applied);
+        if (flags[p] & FIELD_ROWS) {
+            message.U32(static_cast<uint32_t>(changed_rows[p]));
+            for (int y = 1; y < GAME_BOARD_HEIGHT - 1; ++y) {
+                if (!(changed_rows[p] & (RowSet(1) << y))) continue;
+                // Two cells per byte: colors only go up to GARBAGE_CELL.
+                for (int x = 0; x < PlayerView::PLAY_WIDTH; x += 2) {
+                    uint8_t high = (x + 1 < PlayerView::PLAY_WIDTH) ? view.cells[y][x + 1] : 0;
+                    message.U8(view.cells[y][x] | (high << 4));
+                }
+            }
+        }
+        sent[p] = view;
+    }
+    return true;
+}
+
+bool ApplyDelta(const uint8_t* payload, size_t size, PlayerView views[VersusMatch::PLAYER_COUNT], uint32_t& tick) {
+    MessageReader reader(payload, size);
+    tick = reader.U32();
+    int record_count = reader.U8();
+
+    for (int i = 0; i < record_count && reader.Ok(); ++i) {
+        int p = reader.U8();
+        uint8_t flags = reader.U8();
+        if (p >= VersusMatch::PLAYER_COUNT) return false;
+        PlayerView& view = views[p];
+
+        if (flags & FIELD_PIECE) {
+            uint8_t piece = reader.U8();
+            view.piece.type = piece & 0x0F;
+            view.piece.rotation = (piece >> 4) & 0x03;
+            view.pos.x = static_cast<int8_t>(reader.U8());
+            view.pos.y = static_cast<int8_t>(reader.U8());
+            view.next_type = reader.U8();
+            view.has_piece = view.piece.type < PIECE_TYPE_COUNT && view.next_type < PIECE_TYPE_COUNT;
+            if (!view.has_piece) return false;
+        }
+        if (flags & FIELD_STATS) {
+            view.score = static_cast<int>(reader.U32());
+            view.lines = reader.U16();
+            view.level = reader.U8();
+        }
+        if (flags & FIELD_GARBAGE) view.pending_garbage = reader.U8();
+        if (flags & FIELD_ACK) view.inputs_applied = reader.U32();
+        if (flags & FIELD_ROWS) {
+            RowSet rows = reader.U32();
+            if (rows & ~(((RowSet(1) << (GAME_BOARD_HEIGHT - 1)) - 1) & ~RowSet(1))) return false;
+            for (int y = 1; y < GAME_BOARD_HEIGHT - 1; ++y) {
+                if (!(rows & (RowSet(1) << y))) continue;
+                for (int x = 0; x < PlayerView::PLAY_WIDTH; x += 2) {
+                    uint8_t packed = reader.U8();
+                    view.cells[y][x] = packed & 0x0F;
+                    if (x + 1 < PlayerView::PLAY_WIDTH) view.cells[y][x + 1] = packed >> 4;
+                }
+            }
+        }
+        if (flags & FIELD_GAME_OVER) view.is_game_over = true;
+    }
+    return reader.Ok() && reader.Remaining() == 0;
+}
+
+void WriteStatsReply(const ServerStats& stats, std::vector<uint8_t>& out) {
+    MessageWriter message(out, MessageType::StatsReply);
+    message.U64(stats.ticks);
+    message.U32(stats.active_matches);
+    message.U64(stats.matches_started);
+    message.U64(stats.cpu_us);
+    message.U64(stats.wall_us);
+    message.U64(stats.bytes_sent);
+    message.U64(stats.tick_p50_ns);
+    message.U64(stats.tick_p90_ns);
+    message.U64(stats.tick_p99_ns);
+    message.U64(stats.tick_max_ns);
+}
+
+bool ReadStatsReply(const uint8_t* payload, size_t size, ServerStats& stats) {
+    MessageReader reader(payload, size);
+    stats.ticks = reader.U64();
+    stats.active_matches = reader.U32();
+    stats.matches_started = reader.U64();
+    stats.cpu_us = reader.U64();
+    stats.wall_us = reader.U64();
+    stats.bytes_sent = reader.U64();
+    stats.tick_p50_ns = reader.U64();
+    stats.tick_p90_ns = reader.U64();
+    stats.tick_p99_ns = reader.U64();
+    stats.tick_max_ns = reader.U64();
+    return reader.Ok();
+}
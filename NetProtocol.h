@@ -0,0 +1,144 @@
+#ifndef TETRIS_NET_PROTOCOL_H
+#define TETRIS_NET_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Versus.h"
+
+// The versus wire format, shared by the server and its clients. It is plain
+// bytes in, bytes out with no sockets in sight, so it builds everywhere.
+//
+// Every message is little-endian and starts with a 3 byte header:
+//   uint16 size  - how many bytes follow (the type byte plus the payload)
+//   uint8  type  - a MessageType
+// Clients only ever send their inputs; the server owns the games and sends
+// back small "deltas" holding just what changed since the previous tick.
+enum class MessageType : uint8_t {
+    // Client -> server
+    Join = 1,        // (empty) Put me in the next match.
+    Input = 2,       // uint8 actions[], in the order they were pressed.
+    Stats = 3,       // uint8 reset: ask for the server's load numbers (and start a fresh window).
+
+    // Server -> client
+    MatchStart = 16, // uint64 seed, uint8 your player index.
+    Delta = 17,      // What changed on either board (see DeltaEncoder).
+    MatchEnd = 18,   // uint8 winner: 0 or 1, or 255 for a draw.
+    StatsReply = 19  // A ServerStats.
+};
+
+const size_t MESSAGE_HEADER_SIZE = 3;
+const size_t MAX_MESSAGE_SIZE = 1024; // Anything bigger is a broken (or hostile) peer.
+const uint8_t DRAW_WINNER = 255;
+
+// Appends one message to 'out'. The size is filled in by the destructor, so
+// scope a writer around the fields of one message.
+class MessageWriter {
+public:
+    MessageWriter(std::vector<uint8_t>& out, MessageType type);
+    ~MessageWriter();
+
+    void U8(uint32_t value) { out.push_back(static_cast<uint8_t>(value)); }
+    void U16(uint32_t value);
+    void U32(uint32_t value);
+    void U64(uint64_t value);
+
+private:
+    std::vector<uint8_t>& out;
+    size_t start;
+};
+
+// Reads fields back out of a payload. Reading past the end returns zeros and
+// clears Ok(), so a short message can be checked once at the end.
+class MessageReader {
+public:
+    MessageReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    uint8_t U8();
+    uint16_t U16();
+    uint32_t U32();
+    uint64_t U64();
+
+    bool Ok() const { return ok; }
+    size_t Remaining() const { return size - offset; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+    bool ok = true;
+};
+
+struct Message {
+    MessageType type;
+    const uint8_t* payload;
+    size_t payload_size;
+};
+
+// Looks for a whole message at the front of 'data'. Returns how many bytes it
+// took, 0 if more bytes are needed first, or -1 if the stream is garbage.
+int ParseMessage(const uint8_t* data, size_t size, Message& message);
+
+// What a client knows about one player: enough to draw their side.
+struct PlayerView {
+    static const int PLAY_WIDTH = LOGICAL_BOARD_WIDTH - 2;
+
+    uint8_t cells[GAME_BOARD_HEIGHT][PLAY_WIDTH]; // Color of every play cell (0 = empty).
+    Piece piece;
+    Position pos;
+    uint8_t next_type;
+    int score, lines, level;
+    int pending_garbage;
+    uint32_t inputs_applied;   // How many of this player's inputs the server has used.
+    bool has_piece;            // False until the first delta arrives.
+    bool is_game_over;
+
+    void Reset();
+
+    // Rebuilds a GameState that looks like this view, so the normal
+    // DrawPlayfield can draw it. Only the fields drawing needs are filled in.
+    void ToState(GameState& state) const;
+};
+
+// The server's side of the deltas: remembers what it last sent for each
+// player and encodes only the difference. A board row that changed costs
+// 5 bytes (ten 4-bit cells); a tick where only one piece fell costs 14.
+class DeltaEncoder {
+public:
+    DeltaEncoder() { Reset(); }
+
+    // Forget everything sent, e.g. for a new match. Clients reset their views too.
+    void Reset();
+
+    // Appends a Delta message for tick 'tick' to 'out', or nothing (and
+    // returns false) if neither player changed.
+    bool Encode(uint32_t tick, const VersusMatch& match, const uint32_t inputs_applied[VersusMatch::PLAYER_COUNT],
+                std::vector<uint8_t>& out);
+
+private:
+    PlayerView sent[VersusMatch::PLAYER_COUNT];
+};
+
+// The client's side: applies a Delta payload to 'views'. Returns false if the
+// payload was malformed.
+bool ApplyDelta(const uint8_t* payload, size_t size, PlayerView views[VersusMatch::PLAYER_COUNT], uint32_t& tick);
+
+// The server's load numbers, for the load tester. Times are over the window
+// since the last Stats request that asked for a reset.
+struct ServerStats {
+    uint64_t ticks = 0;
+    uint32_t active_matches = 0;
+    uint64_t matches_started = 0;
+    uint64_t cpu_us = 0;          // CPU time the server used (user + system).
+    uint64_t wall_us = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t tick_p50_ns = 0;     // How long one tick of every match took.
+    uint64_t tick_p90_ns = 0;
+    uint64_t tick_p99_ns = 0;
+    uint64_t tick_max_ns = 0;
+};
+
+void WriteStatsReply(const ServerStats& stats, std::vector<uint8_t>& out);
+bool ReadStatsReply(const uint8_t* payload, size_t size, ServerStats& stats);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef TETRIS_NET_SOCKET_H
+#define TETRIS_NET_SOCKET_H
+
+#include <string>
+
+// Tiny helpers for the versus server and its clients (POSIX only).
+// An address is either "unix:/path/to/socket" or "host:port" for TCP.
+// Failures print why to stderr and return -1.
+
+// A non-blocking socket listening on 'address'. A stale Unix socket file
+// left behind by a crashed server is replaced.
+int ListenOn(const std::string& address);
+
+// A socket connected to 'address' (connecting blocks), switched to
+// non-blocking once it is up. TCP sockets get Nagle turned off so small
+// input messages go out at once.
+int ConnectTo(const std::string& address);
+
+// Accepts one pending connection from a listening socket, non-blocking and
+// with Nagle turned off. -1 when there are no more waiting.
+int AcceptFrom(int listen_fd);
+
+bool SetNonBlocking(int fd);
+
+#endif
@@ -0,0 +1,128 @@
+#include "NetSocket.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const char UNIX_PREFIX[] = "unix:";
+
+bool IsUnixAddress(const std::string& address) {
+    return address.compare(0, sizeof(UNIX_PREFIX) - 1, UNIX_PREFIX) == 0;
+}
+
+bool MakeUnixAddress(const std::string& address, sockaddr_un& out) {
+    std::string path = address.substr(sizeof(UNIX_PREFIX) - 1);
+    if (path.empty() || path.size() >= sizeof(out.sun_path)) {
+        std::fprintf(stderr, "bad unix socket path: %s\n", address.c_str());
+        return false;
+    }
+    std::memset(&out, 0, sizeof(out));
+    out.sun_family = AF_UNIX;
+    std::memcpy(out.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// "host:port" (or just "port", meaning 127.0.0.1) to an IPv4 address.
+bool MakeTcpAddress(const std::string& address, sockaddr_in& out) {
+    size_t colon = address.rfind(':');
+    std::string host = (colon == std::string::npos) ? "127.0.0.1" : address.substr(0, colon);
+    std::string port = (colon == std::string::npos) ? address : address.substr(colon + 1);
+    if (host.empty() || host == "localhost") host = "127.0.0.1";
+
+    std::memset(&out, 0, sizeof(out));
+    out.sin_family = AF_INET;
+    out.sin_port = htons(static_cast<uint16_t>(std::atoi(port.c_str())));
+    if (out.sin_port == 0 || inet_pton(AF_INET, host.c_str(), &out.sin_addr) != 1) {
+        std::fprintf(stderr, "bad tcp address (want host:port): %s\n", address.c_str());
+        return false;
+    }
+    return true;
+}
+
+void DisableNagle(int fd) {
+    int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // Fails harmlessly on Unix sockets.
+}
+
+} // namespace
+
+bool SetNonBlocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+int ListenOn(const std::string& address) {
+    int fd = -1;
+    if (IsUnixAddress(address)) {
+        sockaddr_un addr;
+        if (!MakeUnixAddress(address, addr)) return -1;
+        ::unlink(addr.sun_path);
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    } else {
+        sockaddr_in addr;
+        if (!MakeTcpAddress(address, addr)) return -1;
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        if (fd >= 0) ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (fd >= 0 && ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    if (fd < 0 || ::listen(fd, SOMAXCONN) != 0 || !SetNonBlocking(fd)) {
+        std::fprintf(stderr, "can't listen on %s: %s\n", address.c_str(), std::strerror(errno));
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int ConnectTo(const std::string& address) {
+    int fd = -1;
+    int result = -1;
+    if (IsUnixAddress(address)) {
+        sockaddr_un addr;
+        if (!MakeUnixAddress(address, addr)) return -1;
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0) result = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    } else {
+        sockaddr_in addr;
+        if (!MakeTcpAddress(address, addr)) return -1;
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0) result = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        if (result == 0) DisableNagle(fd);
+    }
+
+    if (result != 0 || !SetNonBlocking(fd)) {
+        std::fprintf(stderr, "can't connect to %s: %s\n", address.c_str(), std::strerror(errno));
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int AcceptFrom(int listen_fd) {
+    int fd = ::accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) return -1;
+    if (!SetNonBlocking(fd)) {
+        ::close(fd);
+        return -1;
+    }
+    DisableNagle(fd);
+    return fd;
+}
@@ -0,0 +1,150 @@
+#include "Profiler.h"
+
+#if TETRIS_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace profiler {
+namespace {
+
+const char* const COUNTER_NAMES[] = {"collision checks", "rotations attempted", "terminal bytes"};
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<int>(ProfileCounter::Count),
+              "every counter needs a name");
+
+// One timed scope, or (with 'counter' >= 0) one counter sample.
+struct Event {
+    const char* name;
+    int64_t start_ns;
+    int64_t value;   // Duration in ns for a scope, the running total for a counter.
+    int counter;     // -1 for scopes.
+};
+
+// A thread's ring. The oldest events are overwritten once it is full.
+struct ThreadRing {
+    static const int CAPACITY = 1 << 14;
+
+    int thread_index = 0;
+    uint64_t written = 0;
+    Event events[CAPACITY];
+
+    void Push(const Event& event) { events[written++ % CAPACITY] = event; }
+};
+
+// Every ring ever created, so the trace can cover threads that have
+// finished. Only touched when a thread records its very first event.
+std::mutex g_registry_mutex;
+std::vector<std::unique_ptr<ThreadRing>> g_registry;
+
+thread_local ThreadRing* g_ring = nullptr;
+
+ThreadRing& CurrentRing() {
+    if (g_ring == nullptr) {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        g_registry.emplace_back(new ThreadRing());
+        g_ring = g_registry.back().get();
+        g_ring->thread_index = static_cast<int>(g_registry.size());
+    }
+    return *g_ring;
+}
+
+const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+} // namespace
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void RecordScope(const char* name, int64_t start_ns, int64_t end_ns) {
+    CurrentRing().Push(Event{name, start_ns, end_ns - start_ns, -1});
+}
+
+uint64_t CounterTotal(ProfileCounter counter) {
+    return g_thread_counters[static_cast<int>(counter)];
+}
+
+ProfileSummary Summarize(const char* name, int max_samples) {
+    // Walk back from the newest event into a fixed buffer: no allocation.
+    const int MAX_SAMPLES = 4096;
+    int64_t samples[MAX_SAMPLES];
+    int count = 0;
+    max_samples = std::min(max_samples, MAX_SAMPLES);
+
+    ThreadRing& ring = CurrentRing();
+    uint64_t available = std::min<uint64_t>(ring.written, ThreadRing::CAPACITY);
+    for (uint64_t i = 1; i <= available && count < max_samples; ++i) {
+        const Event& event = ring.events[(ring.written - i) % ThreadRing::CAPACITY];
+        if (event.counter < 0 && (event.name == name || std::strcmp(event.name, name) == 0)) samples[count++] = event.value;
+    }
+
+    ProfileSummary summary;
+    summary.samples = count;
+    if (count == 0) return summary;
+
+    std::nth_element(samples, samples + count / 2, samples + count);
+    summary.p50_ms = samples[count / 2] / 1e6;
+    int p99 = std::min(count - 1, count * 99 / 100);
+    std::nth_element(samples, samples + p99, samples + count);
+    summary.p99_ms = samples[p99] / 1e6;
+    return summary;
+}
+
+void SampleCounters() {
+    ThreadRing& ring = CurrentRing();
+    int64_t now = NowNs();
+    for (int i = 0; i < static_cast<int>(ProfileCounter::Count); ++i) {
+        ring.Push(Event{COUNTER_NAMES[i], now, static_cast<int64_t>(g_thread_counters[i]), i});
+    }
+}
+
+bool WriteChromeTrace(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (const std::unique_ptr<ThreadRing>& ring : g_registry) {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                     first ? "" : ",\n", ring->thread_index, ring->thread_index);
+        first = false;
+
+        // Oldest first, from wherever the ring wrapped to.
+        uint64_t available = std::min<uint64_t>(ring->written, ThreadRing::CAPACITY);
+        for (uint64_t i = ring->written - available; i < ring->written; ++i) {
+            const Event& event = ring->events[i % ThreadRing::CAPACITY];
+            if (event.counter < 0) {
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                             event.name, ring->thread_index, event.start_ns / 1e3, event.value / 1e3);
+            } else {
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"total\":%lld}}",
+                             event.name, ring->thread_index, event.start_ns / 1e3,
+                             static_cast<long long>(event.value));
+            }
+        }
+    }
+    std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return std::fclose(file) == 0;
+}
+
+} // namespace profiler
+
+#else
+
+// Compiled out: the macros are empty and these just answer "nothing".
+namespace profiler {
+
+uint64_t CounterTotal(ProfileCounter) { return 0; }
+ProfileSummary Summarize(const char*, int) { return ProfileSummary(); }
+void SampleCounters() {}
+bool WriteChromeTrace(const std::string&) { return false; }
+
+} // namespace profiler
+
+#endif
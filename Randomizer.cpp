@@ -0,0 +1,118 @@
+#include "Randomizer.h"
+#include "Tetromino.h"
+
+static uint64_t RotateLeft(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+void Randomizer::Reset(uint64_t new_seed) {
+    Reset(new_seed, mode);
+}
+
+void Randomizer::Reset(uint64_t new_seed, RandomizerMode new_mode) {
+    seed = new_seed;
+    mode = new_mode;
+
+    // splitmix64 steps spread the one seed out into the four words xoshiro needs.
+    uint64_t x = seed;
+    for (uint64_t& word : s) {
+        word = SplitMix64(x);
+        x += 0x9E3779B97F4A7C15ull;
+    }
+
+    bag_left = 0;
+    head = 0;
+    for (uint8_t& slot : queue) slot = Generate();
+}
+
+uint8_t Randomizer::Next() {
+    uint8_t piece = queue[head];
+    queue[head] = Generate(); // The freed slot becomes the back of the queue.
+    head = static_cast<uint8_t>((head + 1) % QUEUE_SIZE);
+    return piece;
+}
+
+void Randomizer::WriteState(uint8_t* out) const {
+    auto put_u64 = [&out](uint64_t value) {
+        for (int i = 0; i < 8; ++i) *out++ = static_cast<uint8_t>(value >> (8 * i));
+    };
+    put_u64(seed);
+    for (uint64_t word : s) put_u64(word);
+    *out++ = static_cast<uint8_t>(mode);
+    for (uint8_t piece : bag) *out++ = piece;
+    *out++ = bag_left;
+    for (uint8_t piece : queue) *out++ = piece;
+    *out++ = head;
+}
+
+bool Randomizer::ReadState(const uint8_t* in) {
+    auto get_u64 = [&in]() {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(*in++) << (8 * i);
+        return value;
+    };
+
+    Randomizer loaded;
+    loaded.seed = get_u64();
+    for (uint64_t& word : loaded.s) word = get_u64();
+    uint8_t raw_mode = *in++;
+    for (uint8_t& piece : loaded.bag) piece = *in++;
+    loaded.bag_left = *in++;
+    for (uint8_t& piece : loaded.queue) piece = *in++;
+    loaded.head = *in++;
+
+    // xoshiro never reaches the all-zero state, and everything else is an index.
+    if (raw_mode > static_cast<uint8_t>(RandomizerMode::SevenBag)) return false;
+    if ((loaded.s[0] | loaded.s[1] | loaded.s[2] | loaded.s[3]) == 0) return false;
+    if (loaded.bag_left > PIECE_TYPE_COUNT || loaded.head >= QUEUE_SIZE) return false;
+    for (uint8_t piece : loaded.bag) {
+        if (piece >= PIECE_TYPE_COUNT) return false;
+    }
+    for (uint8_t piece : loaded.queue) {
+        if (piece >= PIECE_TYPE_COUNT) return false;
+    }
+    loaded.mode = static_cast<RandomizerMode>(raw_mode);
+    *this = loaded;
+    return true;
+}
+
+uint64_t Randomizer::NextRaw() {
+    uint64_t result = RotateLeft(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = RotateLeft(s[3], 45);
+    return result;
+}
+
+int Randomizer::Below(int bound) {
+    // Lemire's multiply-shift with rejection, so no piece is more likely than another.
+    uint32_t range = static_cast<uint32_t>(bound);
+    uint32_t threshold = static_cast<uint32_t>(-range) % range;
+    while (true) {
+        uint64_t product = (NextRaw() >> 32) * range;
+        if (static_cast<uint32_t>(product) >= threshold) return static_cast<int>(product >> 32);
+    }
+}
+
+uint8_t Randomizer::Generate() {
+    if (mode == RandomizerMode::PureRandom) {
+        return static_cast<uint8_t>(Below(PIECE_TYPE_COUNT));
+    }
+
+    // 7-bag: refill with one of each piece and shuffle (Fisher-Yates) when empty.
+    if (bag_left == 0) {
+        for (int i = 0; i < PIECE_TYPE_COUNT; ++i) bag[i] = static_cast<uint8_t>(i);
+        for (int i = PIECE_TYPE_COUNT - 1; i > 0; --i) {
+            int j = Below(i + 1);
+            uint8_t tmp = bag[i];
+            bag[i] = bag[j];
+            bag[j] = tmp;
+        }
+        bag_left = PIECE_TYPE_COUNT;
+    }
+    return bag[--bag_left];
+}
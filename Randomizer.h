@@ -0,0 +1,69 @@
+#ifndef TETRIS_RANDOMIZER_H
+#define TETRIS_RANDOMIZER_H
+
+#include <cstdint>
+
+// How the randomizer deals out pieces.
+enum class RandomizerMode : uint8_t {
+    PureRandom, // Every piece is an independent roll of a 7-sided die.
+    SevenBag    // All 7 pieces in a shuffled "bag", then a new bag.
+};
+
+// The splitmix64 mixer: one 64-bit number in, a well-scrambled one out, so
+// neighbouring inputs give unrelated outputs. Used for seeding and hash keys.
+constexpr uint64_t SplitMix64(uint64_t x) {
+    uint64_t z = x + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// The per-game piece generator. It owns its own xoshiro256** state seeded
+// from one 64-bit number, so the same seed always gives the same pieces and
+// games running side by side never share anything.
+// It also keeps a small queue of upcoming pieces, which is what the preview
+// window (and any bot looking ahead) reads from. Plain data, safe to copy.
+class Randomizer {
+public:
+    // How many upcoming pieces can be peeked at.
+    static const int QUEUE_SIZE = 8;
+
+    // The size of the state WriteState packs the randomizer into.
+    static const int STATE_SIZE = 8 + 4 * 8 + 1 + 7 + 1 + QUEUE_SIZE + 1;
+
+    // Starts a fresh sequence. The mode sticks around for later Resets.
+    void Reset(uint64_t seed);
+    void Reset(uint64_t seed, RandomizerMode new_mode);
+
+    // Takes the piece at the front of the queue (0..6) and refills the back.
+    uint8_t Next();
+
+    // Looks at an upcoming piece without taking it; 0 is the one Next() returns.
+    uint8_t Peek(int index) const { return queue[(head + index) % QUEUE_SIZE]; }
+
+    uint64_t Seed() const { return seed; }
+    RandomizerMode Mode() const { return mode; }
+
+    // The whole randomizer as STATE_SIZE little-endian bytes, for save files
+    // (see Snapshot.h). ReadState refuses bytes no randomizer could be in
+    // and leaves itself alone if so.
+    void WriteState(uint8_t* out) const;
+    bool ReadState(const uint8_t* in);
+
+private:
+    uint64_t NextRaw();   // One step of xoshiro256**.
+    int Below(int bound); // An unbiased number in [0, bound).
+    uint8_t Generate();   // The next piece according to 'mode'.
+
+    uint64_t seed = 0;
+    uint64_t s[4] = {};
+    RandomizerMode mode = RandomizerMode::SevenBag;
+
+    uint8_t bag[7] = {};
+    uint8_t bag_left = 0;
+
+    uint8_t queue[QUEUE_SIZE] = {};
+    uint8_t head = 0;
+};
+
+#endif
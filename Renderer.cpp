@@ -0,0 +1,79 @@
+#include "Renderer.h"
+#include <cstdio>
+#include <cstring>
+
+// Rewriting a short stretch of unchanged cells is cheaper than the ~6 bytes
+// of a cursor move, so changes closer together than this are sent as one run.
+static const int MERGE_GAP = 6;
+
+Renderer::Renderer(int screen_width, int screen_height)
+    : width(screen_width), height(screen_height),
+      back(static_cast<size_t>(screen_width) * screen_height, ' '),
+      front(static_cast<size_t>(screen_width) * screen_height, 0) {
+    output.reserve(back.size() * 2);
+    Invalidate();
+}
+
+void Renderer::BeginFrame() {
+    std::memset(back.data(), ' ', back.size());
+}
+
+void Renderer::Put(int x, int y, const char* text) {
+    // Copy the width: writes through a char* could alias it and force a reload per cell.
+    const int screen_width = width;
+    x += origin_x;
+    y += origin_y;
+    if (y < 0 || y >= height) return;
+    char* row = &back[y * screen_width];
+    for (; *text != '\0' && x < screen_width; ++text, ++x) {
+        if (x >= 0) row[x] = *text;
+    }
+}
+
+void Renderer::Invalidate() {
+    // A value that never appears in a frame, so every cell counts as changed.
+    std::memset(front.data(), 0, front.size());
+    cursor_x = -1;
+    cursor_y = -1;
+}
+
+void Renderer::MoveCursor(int x, int y) {
+    if (x == cursor_x && y == cursor_y) return; // Already there, save the bytes.
+    char sequence[16];
+    int length = std::snprintf(sequence, sizeof(sequence), "\x1b[%d;%dH", y + 1, x + 1);
+    output.append(sequence, length);
+}
+
+const std::string& Renderer::Present() {
+    output.clear();
+
+    const int screen_width = width;
+    const int screen_height = height;
+    for (int y = 0; y < screen_height; ++y) {
+        const char* back_row = &back[y * screen_width];
+        char* front_row = &front[y * screen_width];
+        int x = 0;
+        while (x < screen_width) {
+            // Skip over cells that already look right.
+            if (back_row[x] == front_row[x]) {
+                ++x;
+                continue;
+            }
+
+            // Grow the run until we see MERGE_GAP unchanged cells in a row.
+            int start = x;
+            int end = x + 1; // One past the last changed cell.
+            for (int scan = end; scan < screen_width && scan - end < MERGE_GAP; ++scan) {
+                if (back_row[scan] != front_row[scan]) end = scan + 1;
+            }
+
+            MoveCursor(start, y);
+            output.append(&back_row[start], end - start);
+            std::memcpy(&front_row[start], &back_row[start], end - start);
+            cursor_x = end;
+            cursor_y = y;
+            x = end;
+        }
+    }
+    return output;
+}
@@ -0,0 +1,60 @@
+#ifndef TETRIS_RENDERER_H
+#define TETRIS_RENDERER_H
+
+#include <string>
+#include <vector>
+
+// A double-buffered text screen.
+// Each frame is drawn into the "back" buffer with Put(). Present() compares
+// it with the "front" buffer (what the terminal is showing right now) and
+// builds one string that only repaints the cells that changed, jumping
+// between them with ANSI cursor-move sequences. The caller sends that string
+// with a single write, and an unchanged frame costs zero bytes.
+class Renderer {
+public:
+    // The console game's screen; bigger boards ask for a bigger one.
+    static const int SCREEN_WIDTH = 72;
+    static const int SCREEN_HEIGHT = 24;
+
+    explicit Renderer(int width = SCREEN_WIDTH, int height = SCREEN_HEIGHT);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+    // Blanks the back buffer so a new frame can be drawn.
+    void BeginFrame();
+
+    // Writes text into the back buffer at column x, row y (clipped to the screen).
+    void Put(int x, int y, const char* text);
+
+    // Moves where (0, 0) is for the following Puts, so something drawn at the
+    // top-left corner (like DrawPlayfield) can be placed anywhere.
+    void SetOrigin(int x, int y) {
+        origin_x = x;
+        origin_y = y;
+    }
+
+    // Diffs back against front, returns the bytes to send and makes the back
+    // buffer the new front. Returns an empty string when nothing changed.
+    const std::string& Present();
+
+    // Forget what the terminal shows (e.g. after it was cleared), so the next
+    // Present repaints every cell.
+    void Invalidate();
+
+private:
+    void MoveCursor(int x, int y);
+
+    // Both buffers are width * height cells, row by row, sized once up front.
+    int width;
+    int height;
+    std::vector<char> back;
+    std::vector<char> front;
+    std::string output;
+    int origin_x = 0;
+    int origin_y = 0;
+    int cursor_x = -1; // Where the terminal cursor is after our last write (-1 = unknown).
+    int cursor_y = -1;
+};
+
+#endif
@@ -0,0 +1,258 @@
+#include "Replay.h"
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <iterator>
+
+static const char REPLAY_MAGIC[4] = {'T', 'R', 'P', 'L'};
+static const uint8_t REPLAY_VERSION = 4;
+static const uint8_t END_OF_EVENTS = 15; // Action nibble that marks the footer.
+
+// --- Little encoding helpers ---
+
+static void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void PutU64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+static bool GetVarint(const std::vector<uint8_t>& in, size_t& offset, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= in.size()) return false;
+        uint8_t byte = in[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+static bool GetU64(const std::vector<uint8_t>& in, size_t& offset, uint64_t& value) {
+    if (offset + 8 > in.size()) return false;
+    value = 0;
+    for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(in[offset++]) << (8 * i);
+    return true;
+}
+
+// --- ReplayWriter ---
+
+// The longest a varint gets, and the header / footer at their longest.
+static const size_t MAX_VARINT_BYTES = 10;
+static const size_t MAX_HEADER_BYTES = 4 + 3 + 8 + 2 * MAX_VARINT_BYTES + 1;
+static const size_t MAX_FOOTER_BYTES = 2 * MAX_VARINT_BYTES + 8;
+
+ReplayWriter::ReplayWriter(size_t block_size)
+    : block_bytes(std::max(block_size, MAX_HEADER_BYTES + MAX_FOOTER_BYTES)) {
+    data.reserve(block_bytes);
+    // Unbuffered, so writing a block never makes stdio allocate a buffer of its own.
+    spill_file = std::tmpfile();
+    if (spill_file) std::setvbuf(spill_file, nullptr, _IONBF, 0);
+}
+
+ReplayWriter::~ReplayWriter() {
+    if (spill_file) std::fclose(spill_file);
+}
+
+void ReplayWriter::MakeRoom(size_t bytes) {
+    if (data.size() + bytes <= block_bytes || !can_spill) return;
+    if (std::fwrite(data.data(), 1, data.size(), spill_file) != data.size()) {
+        // Keep what made it out intact and let the rest stay in memory.
+        std::fseek(spill_file, static_cast<long>(spilled_bytes), SEEK_SET);
+        can_spill = false;
+        return;
+    }
+    spilled_bytes += data.size();
+    data.clear(); // Keeps the capacity.
+}
+
+void ReplayWriter::Begin(const GameState& state) {
+    data.clear();
+    spilled_bytes = 0;
+    can_spill = (spill_file != nullptr) && std::fseek(spill_file, 0, SEEK_SET) == 0;
+
+    for (char c : REPLAY_MAGIC) data.push_back(static_cast<uint8_t>(c));
+    data.push_back(REPLAY_VERSION);
+    data.push_back(static_cast<uint8_t>(state.randomizer.Mode()));
+    data.push_back(static_cast<uint8_t>(state.rotation_system));
+    PutU64(data, state.randomizer.Seed());
+    PutVarint(data, static_cast<uint64_t>(state.line_clear_delay_ms));
+    PutVarint(data, static_cast<uint64_t>(state.lock_delay_ms));
+    data.push_back(static_cast<uint8_t>(state.mode));
+
+    last_frame = state.frame;
+    is_recording = true;
+}
+
+void ReplayWriter::Record(uint64_t frame, Action action) {
+    if (!is_recording || action == Action::None) return;
+    MakeRoom(MAX_VARINT_BYTES);
+    PutVarint(data, ((frame - last_frame) << 4) | static_cast<uint64_t>(action));
+    last_frame = frame;
+}
+
+void ReplayWriter::End(const GameState& state) {
+    if (!is_recording) return;
+    MakeRoom(MAX_FOOTER_BYTES);
+    PutVarint(data, ((state.frame - last_frame) << 4) | END_OF_EVENTS);
+    PutVarint(data, static_cast<uint64_t>(state.score));
+    PutU64(data, state.board.Hash());
+    is_recording = false;
+}
+
+bool ReplayWriter::SaveToFile(const std::string& path) const {
+    std::ofstream outFile(path, std::ios::binary);
+    if (!outFile.is_open()) return false;
+
+    // The blocks in the scratch file come first, then what is still in memory.
+    if (spilled_bytes > 0) {
+        char buffer[4096];
+        bool is_ok = std::fseek(spill_file, 0, SEEK_SET) == 0;
+        for (size_t left = spilled_bytes; is_ok && left > 0;) {
+            size_t chunk = std::min(left, sizeof(buffer));
+            is_ok = std::fread(buffer, 1, chunk, spill_file) == chunk;
+            outFile.write(buffer, static_cast<std::streamsize>(chunk));
+            left -= chunk;
+        }
+        std::fseek(spill_file, static_cast<long>(spilled_bytes), SEEK_SET);
+        if (!is_ok) return false;
+    }
+    outFile.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return outFile.good();
+}
+
+// --- ReplayReader ---
+
+bool ReplayReader::Open(std::vector<uint8_t> bytes) {
+    data = std::move(bytes);
+    header = ReplayHeader();
+    footer = ReplayFooter();
+
+    size_t offset = 0;
+    if (data.size() < 6 || !std::equal(REPLAY_MAGIC, REPLAY_MAGIC + 4, data.begin())) return false;
+    uint8_t version = data[4];
+    if (version < 1 || version > REPLAY_VERSION) return false;
+    if (data[5] > static_cast<uint8_t>(RandomizerMode::SevenBag)) return false;
+    header.randomizer_mode = static_cast<RandomizerMode>(data[5]);
+    offset = 6;
+    if (version >= 2) {
+        if (offset >= data.size() || data[offset] > static_cast<uint8_t>(RotationSystem::SRS)) return false;
+        header.rotation_system = static_cast<RotationSystem>(data[offset++]);
+    }
+
+    uint64_t value = 0;
+    if (!GetU64(data, offset, header.seed)) return false;
+    // Delays must fit an int; a bigger varint would come out negative.
+    if (!GetVarint(data, offset, value) || value > INT_MAX) return false;
+    header.line_clear_delay_ms = static_cast<int>(value);
+    if (version >= 3) {
+        if (!GetVarint(data, offset, value) || value > INT_MAX) return false;
+        header.lock_delay_ms = static_cast<int>(value);
+    }
+    if (version >= 4) {
+        if (offset >= data.size() || data[offset] >= GAME_MODE_COUNT) return false;
+        header.mode = static_cast<GameMode>(data[offset++]);
+    }
+    events_offset = offset;
+
+    // Walk the events once so a truncated file is caught up front.
+    uint64_t frame = 0;
+    ReplayEvent event;
+    while (Decode(offset, frame, event)) {}
+    if (offset >= data.size()) return false;
+
+    // Decode stopped at the end marker; the footer follows it.
+    if (!GetVarint(data, offset, value)) return false;
+    footer.final_frame = frame + (value >> 4);
+    if (!GetVarint(data, offset, value) || value > INT_MAX) return false;
+    footer.final_score = static_cast<int>(value);
+    if (!GetU64(data, offset, footer.board_hash)) return false;
+
+    cursor = events_offset;
+    cursor_frame = 0;
+    return true;
+}
+
+bool ReplayReader::LoadFromFile(const std::string& path) {
+    std::ifstream inFile(path, std::ios::binary);
+    if (!inFile.is_open()) return false;
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+    return Open(std::move(bytes));
+}
+
+// Decodes the event at 'offset'. On the end marker it returns false and
+// leaves 'offset' pointing at the marker.
+bool ReplayReader::Decode(size_t& offset, uint64_t& frame, ReplayEvent& event) const {
+    size_t start = offset;
+    uint64_t value = 0;
+    if (!GetVarint(data, offset, value)) {
+        offset = data.size();
+        return false;
+    }
+    if ((value & 0xF) == END_OF_EVENTS) {
+        offset = start;
+        return false;
+    }
+    if ((value & 0xF) > static_cast<uint64_t>(Action::Hold)) {
+        offset = data.size(); // Not an action: the file is corrupt.
+        return false;
+    }
+    frame += value >> 4;
+    event.frame = frame;
+    event.action = static_cast<Action>(value & 0xF);
+    return true;
+}
+
+void ReplayReader::Start(GameState& state) {
+    state.line_clear_delay_ms = header.line_clear_delay_ms;
+    state.rotation_system = header.rotation_system;
+    state.lock_delay_ms = header.lock_delay_ms;
+    state.mode = header.mode;
+    state.randomizer.Reset(header.seed, header.randomizer_mode);
+    ResetGameState(state, header.seed);
+    cursor = events_offset;
+    cursor_frame = 0;
+}
+
+bool ReplayReader::NextEvent(ReplayEvent& event) {
+    return Decode(cursor, cursor_frame, event);
+}
+
+bool ReplayReader::PeekFrame(uint64_t& frame) const {
+    size_t offset = cursor;
+    uint64_t peek_frame = cursor_frame;
+    ReplayEvent event;
+    if (!Decode(offset, peek_frame, event)) return false;
+    frame = event.frame;
+    return true;
+}
+
+// --- Headless playback ---
+
+ReplayCheck VerifyReplay(ReplayReader& reader, GameState& state) {
+    ReplayCheck check;
+    reader.Start(state);
+
+    // Jump straight from one event to the next: AdvanceGame only loops over
+    // gravity drops, so there is no per-millisecond cost.
+    ReplayEvent event;
+    while (reader.NextEvent(event)) {
+        if (event.frame > state.frame) {
+            check.pieces += AdvanceGame(state, static_cast<int>(event.frame - state.frame)).pieces_locked;
+        }
+        check.pieces += StepGame(state, event.action).pieces_locked;
+        check.events++;
+    }
+    if (reader.Footer().final_frame > state.frame) {
+        check.pieces += AdvanceGame(state, static_cast<int>(reader.Footer().final_frame - state.frame)).pieces_locked;
+    }
+
+    check.score_matches = (state.score == reader.Footer().final_score);
+    check.hash_matches = (state.board.Hash() == reader.Footer().board_hash);
+    return check;
+}
@@ -0,0 +1,128 @@
+#ifndef TETRIS_REPLAY_H
+#define TETRIS_REPLAY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Engine.h"
+
+// A replay is everything needed to play a game again, frame for frame:
+// the seed, the couple of settings that change the rules, and every action
+// with the game time (GameState::frame) it happened at.
+//
+// File layout (all varints are LEB128):
+//   "TRPL" version:u8 randomizer_mode:u8 rotation_system:u8 seed:u64le
+//          line_clear_delay_ms:varint lock_delay_ms:varint mode:u8
+//   events:  varint((frame_delta << 4) | action)   ... repeated
+//   end:     varint((frame_delta << 4) | 15) score:varint board_hash:u64le
+// Frame deltas are counted from the previous event, so a typical action
+// costs one or two bytes and a whole piece only a handful.
+// Version 1 files have no rotation_system byte; they are always Classic.
+// Versions 1 and 2 have no lock_delay_ms; pieces lock at once.
+// Versions 1 to 3 have no mode byte; they are always GameMode::Classic.
+
+struct ReplayHeader {
+    uint64_t seed = 0;
+    RandomizerMode randomizer_mode = RandomizerMode::SevenBag;
+    RotationSystem rotation_system = RotationSystem::Classic;
+    int line_clear_delay_ms = 0;
+    int lock_delay_ms = 0;
+    GameMode mode = GameMode::Classic;
+};
+
+struct ReplayFooter {
+    uint64_t final_frame = 0;
+    int final_score = 0;
+    uint64_t board_hash = 0;
+};
+
+struct ReplayEvent {
+    uint64_t frame = 0;
+    Action action = Action::None;
+};
+
+// Records a game as it is played.
+class ReplayWriter {
+public:
+    // The recording is built up in one block of this many bytes, reserved
+    // once and reused from game to game. The bot records about 100-200
+    // bytes a second, so a long game does fill it (after 5-10 minutes):
+    // then the block is written to a scratch file opened up front and
+    // started again, and SaveToFile joins the two. A game of any length
+    // records without touching the heap.
+    static const size_t BLOCK_BYTES = 64 * 1024;
+
+    explicit ReplayWriter(size_t block_bytes = BLOCK_BYTES);
+    ~ReplayWriter();
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    // Starts a new recording from a freshly reset game.
+    void Begin(const GameState& state);
+
+    // Call right before StepGame(state, action, ...) with the state's current frame.
+    void Record(uint64_t frame, Action action);
+
+    // Seals the recording with the final score and board hash.
+    void End(const GameState& state);
+
+    bool IsRecording() const { return is_recording; }
+    size_t Size() const { return spilled_bytes + data.size(); } // The whole recording, in bytes.
+    bool SaveToFile(const std::string& path) const;
+
+private:
+    // Writes the block out to the scratch file if 'bytes' more wouldn't fit.
+    void MakeRoom(size_t bytes);
+
+    std::vector<uint8_t> data;        // The end of the recording that is still in memory.
+    size_t block_bytes;
+    std::FILE* spill_file = nullptr;  // Scratch file for full blocks; null if none could be made.
+    bool can_spill = false;           // False after a failed write: 'data' just grows.
+    size_t spilled_bytes = 0;         // How much of this recording is in spill_file.
+    uint64_t last_frame = 0;
+    bool is_recording = false;
+};
+
+// Reads a recording back one event at a time.
+class ReplayReader {
+public:
+    // Checks the header and walks the stream once to find the footer.
+    bool Open(std::vector<uint8_t> bytes);
+    bool LoadFromFile(const std::string& path);
+
+    const ReplayHeader& Header() const { return header; }
+    const ReplayFooter& Footer() const { return footer; }
+
+    // Resets 'state' to the game the replay starts from and rewinds the events.
+    void Start(GameState& state);
+
+    // The next recorded action, or false once the stream is used up.
+    bool NextEvent(ReplayEvent& event);
+
+    // The frame of the next event without consuming it (false at the end).
+    bool PeekFrame(uint64_t& frame) const;
+
+private:
+    bool Decode(size_t& offset, uint64_t& frame, ReplayEvent& event) const;
+
+    std::vector<uint8_t> data;
+    size_t events_offset = 0;
+    size_t cursor = 0;
+    uint64_t cursor_frame = 0;
+    ReplayHeader header;
+    ReplayFooter footer;
+};
+
+struct ReplayCheck {
+    bool score_matches = false;
+    bool hash_matches = false;
+    uint64_t events = 0;
+    int pieces = 0;
+};
+
+// Plays the whole replay headless as fast as possible and compares the end
+// result with the footer.
+ReplayCheck VerifyReplay(ReplayReader& reader, GameState& state);
+
+#endif
@@ -0,0 +1,130 @@
+#include "Scheduler.h"
+#include <algorithm>
+
+FixedStepClock::FixedStepClock(std::chrono::nanoseconds step_size) : step(step_size) {
+    Reset(Clock::now());
+}
+
+void FixedStepClock::Reset(Clock::time_point now) {
+    last = now;
+    accumulator = std::chrono::nanoseconds(0);
+}
+
+int FixedStepClock::TakeSteps(Clock::time_point now) {
+    accumulator += now - last;
+    last = now;
+
+    int steps = static_cast<int>(accumulator / step);
+    accumulator -= steps * step;
+    return steps;
+}
+
+void FixedStepClock::Skip(Clock::time_point now) {
+    last = now;
+}
+
+int FixedStepClock::MsUntil(int steps) const {
+    auto wait = steps * step - accumulator;
+    if (wait <= std::chrono::nanoseconds(0)) return 0;
+    // Round up, so we never wake a hair too early and spin.
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(wait);
+    return static_cast<int>(ms.count());
+}
+
+void LatencyStats::Record(std::chrono::nanoseconds latency) {
+    int64_t ns = latency.count();
+    samples_ns[total_count % CAPACITY] = ns;
+    total_count++;
+    max_ns = std::max(max_ns, ns);
+}
+
+void LatencyStats::Clear() {
+    total_count = 0;
+    max_ns = 0;
+}
+
+LatencyStats::Summary LatencyStats::Summarize() const {
+    Summary summary;
+    summary.count = total_count;
+    if (total_count == 0) return summary;
+
+    // Sorted in a copy on the stack: the server answers stats requests with
+    // this mid-tick, so it mustn't allocate either.
+    size_t kept = static_cast<size_t>(std::min<uint64_t>(total_count, CAPACITY));
+    int64_t sorted[CAPACITY];
+    std::copy(samples_ns, samples_ns + kept, sorted);
+    std::sort(sorted, sorted + kept);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < kept; ++i) sum += static_cast<double>(sorted[i]);
+    auto percentile = [&](double p) {
+        return sorted[std::min(kept - 1, static_cast<size_t>(p * kept))];
+    };
+
+    summary.mean_ns = sum / kept;
+    summary.p50_ns = percentile(0.50);
+    summary.p90_ns = percentile(0.90);
+    summary.p99_ns = percentile(0.99);
+    summary.max_ns = max_ns;
+    return summary;
+}
+
+void LatencyStats::Print(std::FILE* out, const char* title) const {
+    if (total_count == 0) {
+        std::fprintf(out, "%s: no samples\n", title);
+        return;
+    }
+
+    Summary summary = Summarize();
+    std::fprintf(out, "%s: %llu samples, mean %.3f ms, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                 title, static_cast<unsigned long long>(summary.count), summary.mean_ns / 1e6,
+                 summary.p50_ns / 1e6, summary.p90_ns / 1e6, summary.p99_ns / 1e6, summary.max_ns / 1e6);
+}
+
+void RunStats::Start(Clock::time_point now) {
+    *this = RunStats();
+    running_since = now;
+    is_running = true;
+}
+
+void RunStats::Pause(Clock::time_point now) {
+    if (!is_running) return;
+    banked_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(now - running_since).count();
+    is_running = false;
+}
+
+void RunStats::Resume(Clock::time_point now) {
+    if (is_running || is_stopped) return;
+    running_since = now;
+    is_running = true;
+}
+
+void RunStats::Stop(Clock::time_point now) {
+    Pause(now);
+    is_stopped = true;
+}
+
+void RunStats::UpdateLines(int total_lines, Clock::time_point now) {
+    int64_t elapsed = ElapsedNs(now);
+    while (split_count < MAX_SPLITS && total_lines >= (split_count + 1) * SPLIT_LINES) {
+        splits_ns[split_count++] = elapsed;
+    }
+}
+
+int64_t RunStats::ElapsedNs(Clock::time_point now) const {
+    if (!is_running) return banked_ns;
+    return banked_ns + std::chrono::duration_cast<std::chrono::nanoseconds>(now - running_since).count();
+}
+
+double RunStats::PiecesPerSecond(Clock::time_point now) const {
+    int64_t elapsed = ElapsedNs(now);
+    return elapsed > 0 ? pieces * 1e9 / static_cast<double>(elapsed) : 0.0;
+}
+
+void FormatRunTime(int64_t ns, char* text, size_t size, int decimals) {
+    decimals = std::max(1, std::min(decimals, 3));
+    int divisor = (decimals == 1) ? 100 : (decimals == 2) ? 10 : 1;
+    int64_t ms = std::max<int64_t>(ns, 0) / 1000000;
+    std::snprintf(text, size, "%lld:%02lld.%0*lld", static_cast<long long>(ms / 60000),
+                  static_cast<long long>(ms / 1000 % 60), decimals, static_cast<long long>(ms % 1000 / divisor));
+}
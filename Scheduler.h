@@ -0,0 +1,117 @@
+#ifndef TETRIS_SCHEDULER_H
+#define TETRIS_SCHEDULER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Turns real time into whole logic steps.
+// Real time (from the monotonic steady_clock, so changing the wall clock
+// can't speed up or freeze gravity) goes into an accumulator, and the game
+// takes it back out in fixed-size steps. Whatever is left over stays for next
+// time, so no time is lost or counted twice no matter when the loop wakes up.
+class FixedStepClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FixedStepClock(std::chrono::nanoseconds step_size = std::chrono::milliseconds(1));
+
+    // Starts counting from 'now' with an empty accumulator.
+    void Reset(Clock::time_point now);
+
+    // The number of whole steps that passed since the last call.
+    int TakeSteps(Clock::time_point now);
+
+    // Throws away the time since the last call (used while paused).
+    void Skip(Clock::time_point now);
+
+    // How many ms of real time until 'steps' more whole steps are due.
+    int MsUntil(int steps) const;
+
+private:
+    std::chrono::nanoseconds step;
+    std::chrono::nanoseconds accumulator{0};
+    Clock::time_point last;
+};
+
+// Collects input-to-present latencies: the time from the moment a key
+// press woke the loop to the moment the frame showing its effect was written.
+// Samples live in a fixed ring buffer, so recording never allocates.
+class LatencyStats {
+public:
+    static const int CAPACITY = 4096;
+
+    void Record(std::chrono::nanoseconds latency);
+
+    // Starts over with no samples.
+    void Clear();
+
+    // Mean and percentiles over the kept samples (max over every sample).
+    struct Summary {
+        uint64_t count = 0;
+        double mean_ns = 0.0;
+        int64_t p50_ns = 0, p90_ns = 0, p99_ns = 0, max_ns = 0;
+    };
+    Summary Summarize() const;
+
+    // Prints count, mean, p50, p90, p99 and max (over the kept samples).
+    void Print(std::FILE* out, const char* title) const;
+
+private:
+    int64_t samples_ns[CAPACITY] = {};
+    uint64_t total_count = 0;
+    int64_t max_ns = 0;
+};
+
+// The clock and counters for one run: its time (steady_clock, in
+// nanoseconds), a split every SPLIT_LINES lines, pieces per second and keys
+// per piece. The clock only runs while the game does: paused time is left
+// out and Stop freezes it for good. Fixed-size, so nothing here allocates.
+class RunStats {
+public:
+    using Clock = std::chrono::steady_clock;
+    static const int SPLIT_LINES = 10;
+    static const int MAX_SPLITS = 16;   // Room for a whole 150 line marathon.
+
+    // Starts a new run at 'now' with everything at zero.
+    void Start(Clock::time_point now);
+
+    void Pause(Clock::time_point now);
+    void Resume(Clock::time_point now);
+    void Stop(Clock::time_point now);
+
+    void AddKeys(int count) { keys += count; }
+    void AddPieces(int count) { pieces += count; }
+
+    // Call with the game's line total whenever it changes: every multiple
+    // of SPLIT_LINES it went past is stamped with the time at 'now'.
+    void UpdateLines(int total_lines, Clock::time_point now);
+
+    bool IsRunning() const { return is_running; }
+    bool IsStopped() const { return is_stopped; }
+    int64_t ElapsedNs(Clock::time_point now) const;
+    int Pieces() const { return pieces; }
+    int Keys() const { return keys; }
+    double PiecesPerSecond(Clock::time_point now) const;
+    double KeysPerPiece() const { return pieces > 0 ? static_cast<double>(keys) / pieces : 0.0; }
+
+    // When line (i + 1) * SPLIT_LINES was reached, counted from the start.
+    int SplitCount() const { return split_count; }
+    int64_t SplitNs(int i) const { return splits_ns[i]; }
+
+private:
+    Clock::time_point running_since;  // Where the clock last started running.
+    int64_t banked_ns = 0;            // Time run before that.
+    bool is_running = false;
+    bool is_stopped = false;
+    int pieces = 0;
+    int keys = 0;
+    int split_count = 0;
+    int64_t splits_ns[MAX_SPLITS] = {};
+};
+
+// "m:ss.mmm" for a run time (or a split), with 1 to 3 decimals.
+void FormatRunTime(int64_t ns, char* text, size_t size, int decimals = 3);
+
+#endif
@@ -0,0 +1,63 @@
+#include "MatchServer.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void RequestStop(int) { g_stop = 1; }
+
+} // namespace
+
+// Hosts versus matches for any number of players on this machine.
+// Usage: tetris_server [--listen=ADDRESS]... [--tick-ms=16]
+//   ADDRESS is "unix:/path/to/socket" or "host:port" (default 127.0.0.1:7777).
+// Players connect with tetris_versus; tetris_loadtest measures how much it can take.
+int main(int argc, char** argv) {
+    ServerConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--listen=", 9) == 0) {
+            config.addresses.push_back(arg + 9);
+        } else if (std::strncmp(arg, "--tick-ms=", 10) == 0) {
+            config.tick_ms = std::atoi(arg + 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--listen=unix:PATH|HOST:PORT]... [--tick-ms=N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (config.addresses.empty()) config.addresses.push_back("127.0.0.1:7777");
+    if (config.tick_ms < 1) config.tick_ms = 1;
+
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Two sockets per match adds up: use every file descriptor we may.
+    rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    MatchServer server(config);
+    if (!server.Open()) return 1;
+
+    for (const std::string& address : config.addresses) {
+        std::printf("listening on %s (tick %d ms)\n", address.c_str(), config.tick_ms);
+    }
+    std::fflush(stdout);
+
+    server.Run(g_stop);
+
+    ServerStats stats = server.Stats();
+    std::printf("ticks: %llu, matches: %llu, tick p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                static_cast<unsigned long long>(stats.ticks),
+                static_cast<unsigned long long>(stats.matches_started),
+                stats.tick_p50_ns / 1e6, stats.tick_p99_ns / 1e6, stats.tick_max_ns / 1e6);
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef TETRIS_SHARED_MEMORY_H
+#define TETRIS_SHARED_MEMORY_H
+
+#include <cstddef>
+#include <string>
+
+// A named block of memory that other processes can map too. One process
+// creates it (and owns the name); any number of others map it read-only.
+// Each platform has its own SharedMemory_*.cpp: shm_open + mmap on POSIX,
+// a named file mapping on Windows. New blocks always start out zeroed.
+class SharedMemory {
+public:
+    SharedMemory() = default;
+    ~SharedMemory() { Close(); }
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // Creates a zeroed block of 'size' bytes called 'name' and maps it
+    // read-write. A block left behind by a crashed owner is replaced.
+    bool Create(const std::string& name, size_t size);
+
+    // Maps an existing block read-only. Fails if it is smaller than 'size'.
+    bool OpenReadOnly(const std::string& name, size_t size);
+
+    // Unmaps the block; the owner also removes its name, so nobody new can
+    // open it (processes that still have it mapped keep their view).
+    void Close();
+
+    bool IsOpen() const { return data != nullptr; }
+    void* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    void* data = nullptr;
+    size_t size = 0;
+    bool is_owner = false;
+    std::string system_name;  // The name as the OS knows it.
+    void* handle = nullptr;   // Windows only: the file mapping.
+};
+
+#endif
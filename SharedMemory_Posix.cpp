@@ -0,0 +1,62 @@
+#include "SharedMemory.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool SharedMemory::Create(const std::string& name, size_t bytes) {
+    Close();
+    std::string path = "/" + name;
+
+    // A game that crashed can't have removed its block; start from a new one.
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return false;
+
+    // ftruncate fills the new block with zeros.
+    void* mapped = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd); // The mapping keeps the block alive on its own.
+    if (mapped == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        return false;
+    }
+
+    data = mapped;
+    size = bytes;
+    is_owner = true;
+    system_name = path;
+    return true;
+}
+
+bool SharedMemory::OpenReadOnly(const std::string& name, size_t bytes) {
+    Close();
+    std::string path = "/" + name;
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= bytes) {
+        mapped = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    data = mapped;
+    size = bytes;
+    is_owner = false;
+    system_name = path;
+    return true;
+}
+
+void SharedMemory::Close() {
+    if (data == nullptr) return;
+    munmap(data, size);
+    if (is_owner) shm_unlink(system_name.c_str());
+    data = nullptr;
+    size = 0;
+    is_owner = false;
+}
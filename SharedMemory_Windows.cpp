@@ -0,0 +1,63 @@
+#include "SharedMemory.h"
+#include <windows.h>
+
+bool SharedMemory::Create(const std::string& name, size_t bytes) {
+    Close();
+    std::string mapping_name = "Local\\" + name;
+
+    // Backed by the page file. Windows removes the mapping once the last
+    // process closes it, so nothing can be left over from a crash.
+    unsigned long long size64 = bytes;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), mapping_name.c_str());
+    if (mapping == nullptr) return false;
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Another game is broadcasting under this name (or viewers still
+        // hold the last one open): don't write into their block.
+        CloseHandle(mapping);
+        return false;
+    }
+
+    void* mapped = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (mapped == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    data = mapped;
+    size = bytes;
+    is_owner = true;
+    system_name = mapping_name;
+    handle = mapping;
+    return true;
+}
+
+bool SharedMemory::OpenReadOnly(const std::string& name, size_t bytes) {
+    Close();
+    std::string mapping_name = "Local\\" + name;
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, mapping_name.c_str());
+    if (mapping == nullptr) return false;
+
+    void* mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, bytes);
+    if (mapped == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    data = mapped;
+    size = bytes;
+    is_owner = false;
+    system_name = mapping_name;
+    handle = mapping;
+    return true;
+}
+
+void SharedMemory::Close() {
+    if (data == nullptr) return;
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(handle));
+    data = nullptr;
+    size = 0;
+    is_owner = false;
+    handle = nullptr;
+}
@@ -0,0 +1,253 @@
+#include "Snapshot.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+static const char SNAPSHOT_MAGIC[4] = {'T', 'S', 'N', 'P'};
+static const uint8_t SNAPSHOT_VERSION = 2;
+static const size_t VERSION_1_SIZE = GameSnapshot::SERIALIZED_SIZE - 5; // No combo or mode yet.
+
+// The play columns of a board row, shifted down to bit 0.
+static const uint16_t PLAY_BITS = (1u << GameSnapshot::PLAY_WIDTH) - 1;
+
+// GameSnapshot::flags
+static const uint8_t FLAG_GAME_OVER = 1 << 0;
+static const uint8_t FLAG_CLEARING_LINES = 1 << 1;
+static const uint8_t FLAG_LAST_MOVE_WAS_ROTATION = 1 << 2;
+static const uint8_t FLAG_LAST_KICK_WAS_LONG = 1 << 3;
+static const uint8_t FLAG_CAN_HOLD = 1 << 4;
+static const uint8_t FLAG_GROUNDED = 1 << 5;
+static const uint8_t FLAG_BACK_TO_BACK = 1 << 6;
+static const uint8_t FLAG_GOAL_REACHED = 1 << 7;
+static const uint8_t ALL_FLAGS = 0xFF;
+
+static uint8_t FlagIf(bool condition, uint8_t flag) { return condition ? flag : 0; }
+
+// --- Save / Restore ---
+
+void GameSnapshot::Save(const GameState& state) {
+    const Bitboard& board = state.board;
+    for (int y = 0; y < PLAY_HEIGHT; ++y) {
+        rows[y] = static_cast<uint16_t>((board.rows[y + 1] >> 1) & PLAY_BITS);
+        const uint8_t* cells = board.ColorRow(y + 1) + 1;
+        for (int i = 0; i < PLAY_WIDTH / 2; ++i) {
+            colors[y][i] = static_cast<uint8_t>(cells[2 * i] | (cells[2 * i + 1] << 4));
+        }
+    }
+
+    randomizer = state.randomizer;
+    frame = state.frame;
+    lines_to_clear = state.lines_to_clear;
+    score = state.score;
+    level = state.level;
+    lines_cleared = state.lines_cleared;
+    line_clear_elapsed_ms = state.line_clear_elapsed_ms;
+    line_clear_delay_ms = state.line_clear_delay_ms;
+    lock_delay_ms = state.lock_delay_ms;
+    lock_elapsed_ms = state.lock_elapsed_ms;
+    gravity_elapsed_ms = state.gravity_elapsed_ms;
+    combo = state.combo;
+    type = state.current_piece.type;
+    rotation = state.current_piece.rotation;
+    x = static_cast<int8_t>(state.current_pos.x);
+    y = static_cast<int8_t>(state.current_pos.y);
+    held_type = static_cast<int8_t>(state.held_type);
+    lock_resets = static_cast<uint8_t>(state.lock_resets);
+    lowest_row = static_cast<uint8_t>(state.lowest_row);
+    rotation_system = state.rotation_system;
+    last_spin = state.last_spin;
+    mode = state.mode;
+    flags = static_cast<uint8_t>(FlagIf(state.is_game_over, FLAG_GAME_OVER) |
+                                 FlagIf(state.is_clearing_lines, FLAG_CLEARING_LINES) |
+                                 FlagIf(state.last_move_was_rotation, FLAG_LAST_MOVE_WAS_ROTATION) |
+                                 FlagIf(state.last_kick_was_long, FLAG_LAST_KICK_WAS_LONG) |
+                                 FlagIf(state.can_hold, FLAG_CAN_HOLD) |
+                                 FlagIf(state.is_grounded, FLAG_GROUNDED) |
+                                 FlagIf(state.back_to_back, FLAG_BACK_TO_BACK) |
+                                 FlagIf(state.is_goal_reached, FLAG_GOAL_REACHED));
+}
+
+void GameSnapshot::Restore(GameState& state) const {
+    // The ceiling and floor too, so any GameState (even a fresh one) can be restored into.
+    Bitboard& board = state.board;
+    const int floor_y = GAME_BOARD_HEIGHT - 1;
+    board.rows[0] = FULL_ROW_MASK;
+    board.rows[floor_y] = FULL_ROW_MASK;
+    std::fill(board.ColorRow(0), board.ColorRow(0) + LOGICAL_BOARD_WIDTH, WALL_CELL);
+    std::fill(board.ColorRow(floor_y), board.ColorRow(floor_y) + LOGICAL_BOARD_WIDTH, WALL_CELL);
+
+    for (int y = 0; y < PLAY_HEIGHT; ++y) {
+        board.rows[y + 1] = static_cast<RowMask>(WALL_ROW_MASK | (rows[y] << 1));
+        uint8_t* cells = board.ColorRow(y + 1);
+        cells[0] = WALL_CELL;
+        cells[LOGICAL_BOARD_WIDTH - 1] = WALL_CELL;
+        for (int i = 0; i < PLAY_WIDTH / 2; ++i) {
+            cells[1 + 2 * i] = colors[y][i] & 0x0F;
+            cells[2 + 2 * i] = colors[y][i] >> 4;
+        }
+    }
+    board.RebuildColumnTops();
+
+    state.randomizer = randomizer;
+    state.frame = frame;
+    state.lines_to_clear = lines_to_clear;
+    state.score = score;
+    state.level = level;
+    state.lines_cleared = lines_cleared;
+    state.line_clear_elapsed_ms = line_clear_elapsed_ms;
+    state.line_clear_delay_ms = line_clear_delay_ms;
+    state.lock_delay_ms = lock_delay_ms;
+    state.lock_elapsed_ms = lock_elapsed_ms;
+    state.gravity_elapsed_ms = gravity_elapsed_ms;
+    state.combo = combo;
+    state.current_piece = Piece{type, rotation};
+    state.current_pos = Position{x, y};
+    state.held_type = held_type;
+    state.lock_resets = lock_resets;
+    state.lowest_row = lowest_row;
+    state.rotation_system = rotation_system;
+    state.last_spin = last_spin;
+    state.mode = mode;
+    state.is_game_over = (flags & FLAG_GAME_OVER) != 0;
+    state.is_clearing_lines = (flags & FLAG_CLEARING_LINES) != 0;
+    state.last_move_was_rotation = (flags & FLAG_LAST_MOVE_WAS_ROTATION) != 0;
+    state.last_kick_was_long = (flags & FLAG_LAST_KICK_WAS_LONG) != 0;
+    state.can_hold = (flags & FLAG_CAN_HOLD) != 0;
+    state.is_grounded = (flags & FLAG_GROUNDED) != 0;
+    state.back_to_back = (flags & FLAG_BACK_TO_BACK) != 0;
+    state.is_goal_reached = (flags & FLAG_GOAL_REACHED) != 0;
+}
+
+// --- Serialize / Deserialize ---
+
+static void PutLittleEndian(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+static uint64_t GetLittleEndian(const uint8_t*& in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(*in++) << (8 * i);
+    return value;
+}
+
+void GameSnapshot::Serialize(std::vector<uint8_t>& out) const {
+    size_t start = out.size();
+    out.reserve(start + SERIALIZED_SIZE);
+
+    for (char c : SNAPSHOT_MAGIC) out.push_back(static_cast<uint8_t>(c));
+    out.push_back(SNAPSHOT_VERSION);
+    for (uint16_t row : rows) PutLittleEndian(out, row, 2);
+    for (const auto& row : colors) out.insert(out.end(), row, row + PLAY_WIDTH / 2);
+
+    uint8_t randomizer_state[Randomizer::STATE_SIZE];
+    randomizer.WriteState(randomizer_state);
+    out.insert(out.end(), randomizer_state, randomizer_state + Randomizer::STATE_SIZE);
+
+    PutLittleEndian(out, frame, 8);
+    PutLittleEndian(out, lines_to_clear, 8);
+    for (int32_t value : {score, level, lines_cleared, line_clear_elapsed_ms, line_clear_delay_ms,
+                          lock_delay_ms, lock_elapsed_ms, gravity_elapsed_ms}) {
+        PutLittleEndian(out, static_cast<uint32_t>(value), 4);
+    }
+    for (uint8_t value : {type, rotation, static_cast<uint8_t>(x), static_cast<uint8_t>(y),
+                          static_cast<uint8_t>(held_type), lock_resets, lowest_row,
+                          static_cast<uint8_t>(rotation_system), static_cast<uint8_t>(last_spin), flags}) {
+        out.push_back(value);
+    }
+    PutLittleEndian(out, static_cast<uint32_t>(combo), 4);
+    out.push_back(static_cast<uint8_t>(mode));
+}
+
+bool GameSnapshot::Deserialize(const uint8_t* data, size_t size) {
+    if (size < VERSION_1_SIZE || !std::equal(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 4, data)) return false;
+    uint8_t version = data[4];
+    if (version < 1 || version > SNAPSHOT_VERSION) return false;
+    if (version >= 2 && size < SERIALIZED_SIZE) return false;
+    const uint8_t* in = data + 5;
+
+    GameSnapshot loaded;
+    for (uint16_t& row : loaded.rows) row = static_cast<uint16_t>(GetLittleEndian(in, 2));
+    for (auto& row : loaded.colors) {
+        std::copy(in, in + PLAY_WIDTH / 2, row);
+        in += PLAY_WIDTH / 2;
+    }
+    if (!loaded.randomizer.ReadState(in)) return false;
+    in += Randomizer::STATE_SIZE;
+
+    loaded.frame = GetLittleEndian(in, 8);
+    loaded.lines_to_clear = GetLittleEndian(in, 8);
+    for (int32_t* value : {&loaded.score, &loaded.level, &loaded.lines_cleared,
+                           &loaded.line_clear_elapsed_ms, &loaded.line_clear_delay_ms,
+                           &loaded.lock_delay_ms, &loaded.lock_elapsed_ms, &loaded.gravity_elapsed_ms}) {
+        *value = static_cast<int32_t>(GetLittleEndian(in, 4));
+        if (*value < 0) return false; // None of them ever go negative.
+    }
+    loaded.type = *in++;
+    loaded.rotation = *in++;
+    loaded.x = static_cast<int8_t>(*in++);
+    loaded.y = static_cast<int8_t>(*in++);
+    loaded.held_type = static_cast<int8_t>(*in++);
+    loaded.lock_resets = *in++;
+    loaded.lowest_row = *in++;
+    uint8_t raw_rotation_system = *in++;
+    uint8_t raw_last_spin = *in++;
+    loaded.flags = *in++;
+    loaded.combo = -1;
+    uint8_t raw_mode = 0;
+    if (version >= 2) {
+        loaded.combo = static_cast<int32_t>(GetLittleEndian(in, 4));
+        raw_mode = *in++;
+    }
+
+    // Every cell has to agree with its row bit, and hold a piece or garbage.
+    for (int y = 0; y < PLAY_HEIGHT; ++y) {
+        if (loaded.rows[y] & ~PLAY_BITS) return false;
+        for (int x = 0; x < PLAY_WIDTH; ++x) {
+            uint8_t color = (loaded.colors[y][x / 2] >> (4 * (x & 1))) & 0x0F;
+            bool is_set = (loaded.rows[y] >> x) & 1;
+            if (is_set != (color != 0) || color > GARBAGE_CELL) return false;
+        }
+    }
+
+    const RowSet play_rows = ((RowSet(1) << PLAY_HEIGHT) - 1) << 1;
+    if (loaded.lines_to_clear & ~play_rows) return false;
+    if (loaded.level < 1 || loaded.type >= PIECE_TYPE_COUNT || loaded.rotation >= ROTATION_COUNT) return false;
+    if (loaded.held_type < -1 || loaded.held_type >= PIECE_TYPE_COUNT) return false;
+    if (loaded.lock_resets > MAX_LOCK_RESETS || loaded.lowest_row >= GAME_BOARD_HEIGHT) return false;
+    if (raw_rotation_system > static_cast<uint8_t>(RotationSystem::SRS)) return false;
+    if (raw_last_spin > static_cast<uint8_t>(SpinType::Full)) return false;
+    if (loaded.flags & ~ALL_FLAGS) return false;
+    if (loaded.combo < -1 || raw_mode >= GAME_MODE_COUNT) return false;
+    if (version < 2 && (loaded.flags & (FLAG_BACK_TO_BACK | FLAG_GOAL_REACHED))) return false;
+    loaded.mode = static_cast<GameMode>(raw_mode);
+    loaded.rotation_system = static_cast<RotationSystem>(raw_rotation_system);
+    loaded.last_spin = static_cast<SpinType>(raw_last_spin);
+
+    // A piece still in play has to fit where it is; a finished game's last
+    // piece may overlap the stack, but it still has to be on the board.
+    if (loaded.x <= -4 || loaded.x >= LOGICAL_BOARD_WIDTH || loaded.y <= -4 || loaded.y >= GAME_BOARD_HEIGHT) return false;
+    if (!(loaded.flags & (FLAG_GAME_OVER | FLAG_CLEARING_LINES))) {
+        GameState check;
+        loaded.Restore(check);
+        if (CheckCollision(check, check.current_piece.Mask(), loaded.x, loaded.y)) return false;
+    }
+
+    *this = loaded;
+    return true;
+}
+
+bool GameSnapshot::SaveToFile(const std::string& path) const {
+    std::vector<uint8_t> data;
+    Serialize(data);
+    std::ofstream outFile(path, std::ios::binary);
+    if (!outFile.is_open()) return false;
+    outFile.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return outFile.good();
+}
+
+bool GameSnapshot::LoadFromFile(const std::string& path) {
+    std::ifstream inFile(path, std::ios::binary);
+    if (!inFile.is_open()) return false;
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+    return Deserialize(bytes.data(), bytes.size());
+}
@@ -0,0 +1,74 @@
+#ifndef TETRIS_SNAPSHOT_H
+#define TETRIS_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Engine.h"
+
+// A save state: everything in a GameState, squeezed into a few hundred
+// bytes of plain data so a bot's lookahead or a netplay rollback can keep
+// thousands of them around and jump back to any one of them.
+//
+// Only what can't be worked out again is kept. The walls, ceiling and floor
+// are the same on every board, so a row is just its 10 play bits and the
+// colors are two 4-bit cells per byte; the column tops are rebuilt on
+// Restore. Saving and restoring touch the same fixed number of bytes
+// whatever is on the board.
+//
+// Serialize writes a fixed-size, little-endian layout (independent of this
+// struct's padding) that Deserialize checks field by field:
+//   "TSNP" version:u8  rows:u16[20]  colors:u8[20][5]  randomizer:u8[58]
+//   frame:u64  lines_to_clear:u64  score:i32 level:i32 lines_cleared:i32
+//   line_clear_elapsed_ms:i32 line_clear_delay_ms:i32 lock_delay_ms:i32
+//   lock_elapsed_ms:i32 gravity_elapsed_ms:i32
+//   type:u8 rotation:u8 x:i8 y:i8 held_type:i8 lock_resets:u8 lowest_row:u8
+//   rotation_system:u8 last_spin:u8 flags:u8 combo:i32 mode:u8
+// Version 1 ends at flags; it is read as a Classic game with no combo.
+struct GameSnapshot {
+    static const int PLAY_WIDTH = LOGICAL_BOARD_WIDTH - 2;
+    static const int PLAY_HEIGHT = GAME_BOARD_HEIGHT - 2;
+    static const size_t SERIALIZED_SIZE = 4 + 1 + PLAY_HEIGHT * 2 + PLAY_HEIGHT * PLAY_WIDTH / 2 +
+                                          Randomizer::STATE_SIZE + 8 + 8 + 8 * 4 + 10 + 5;
+
+    // --- Board ---
+    uint16_t rows[PLAY_HEIGHT];                   // Bit x = play column x (0 = left-most).
+    uint8_t colors[PLAY_HEIGHT][PLAY_WIDTH / 2];  // Low nibble = the even column.
+
+    // --- Everything else, as in GameState ---
+    Randomizer randomizer;
+    uint64_t frame;
+    RowSet lines_to_clear;
+    int32_t score, level, lines_cleared;
+    int32_t line_clear_elapsed_ms, line_clear_delay_ms;
+    int32_t lock_delay_ms, lock_elapsed_ms;
+    int32_t gravity_elapsed_ms;
+    int32_t combo;
+    uint8_t type, rotation;
+    int8_t x, y;
+    int8_t held_type;
+    uint8_t lock_resets, lowest_row;
+    RotationSystem rotation_system;
+    SpinType last_spin;
+    GameMode mode;
+    uint8_t flags;  // The bools, see Snapshot.cpp.
+
+    void Save(const GameState& state);
+
+    // Puts 'state' back exactly as it was when this was saved.
+    void Restore(GameState& state) const;
+
+    // Appends SERIALIZED_SIZE bytes to 'out'.
+    void Serialize(std::vector<uint8_t>& out) const;
+
+    // Reads a serialized snapshot back. Returns false (and keeps the old
+    // contents) if the bytes are short, from another version or describe a
+    // game the rules could never reach.
+    bool Deserialize(const uint8_t* data, size_t size);
+
+    bool SaveToFile(const std::string& path) const;
+    bool LoadFromFile(const std::string& path);
+};
+
+#endif
@@ -0,0 +1,395 @@
+#include "Solver.h"
+#include <algorithm>
+#include <chrono>
+#include "Zobrist.h"
+
+namespace {
+
+// Worse than any board EvaluateBatch can score.
+const float LOSING_SCORE = -1e30f;
+
+// A dead end (the next piece can't even spawn) counts as fewer lines than
+// any real sequence, so MaxLines never picks one while it has a choice.
+const int DEAD_END_LINES = -1000;
+
+const RowMask PLAY_MASK = static_cast<RowMask>(~WALL_ROW_MASK);
+
+int CountBits(uint32_t bits) {
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1) ++count;
+    return count;
+}
+
+// How many play rows have at least one block in them.
+int UsedRows(const Bitboard& board) {
+    int used = 0;
+    for (int y = 1; y < GAME_BOARD_HEIGHT - 1; ++y) used += (board.rows[y] != WALL_ROW_MASK);
+    return used;
+}
+
+bool IsEmpty(const Bitboard& board) { return UsedRows(board) == 0; }
+
+// The cells a piece covers as (top row, up to 4 row masks), so two
+// placements that cover the same cells compare equal whatever their rotation.
+struct Cells {
+    int top = -1;
+    uint64_t rows = 0;
+
+    bool operator==(const Cells& other) const { return top == other.top && rows == other.rows; }
+};
+
+Cells CellsOf(Piece piece, Position pos) {
+    Cells cells;
+    int packed = 0;
+    for (int py = 0; py < 4; ++py) {
+        uint32_t bits = piece.Mask().rows[py];
+        if (bits == 0 && cells.top < 0) continue;
+        if (cells.top < 0) cells.top = pos.y + py;
+        bits = (pos.x >= 0) ? (bits << pos.x) : (bits >> -pos.x);
+        cells.rows |= static_cast<uint64_t>(bits & 0xFFFF) << (16 * packed++);
+    }
+    return cells;
+}
+
+// The keys a player has under each rotation system (a soft drop goes all
+// the way down). The classic rules only turn clockwise.
+const Action CLASSIC_FINESSE_KEYS[] = {Action::MoveLeft, Action::MoveRight, Action::Rotate, Action::SoftDrop};
+const Action SRS_FINESSE_KEYS[] = {Action::MoveLeft, Action::MoveRight, Action::Rotate, Action::RotateCCW,
+                                   Action::Rotate180, Action::SoftDrop};
+
+// The fewest key presses that get 'piece' from 'start' to a hard drop onto
+// the cells 'target' covers: a breadth-first search where a move, a turn or
+// a soft drop all the way down is one press each, and the final hard drop
+// is free. The bot's own search counts every row of a soft drop instead, so
+// its paths are the shortest in engine steps rather than in keys.
+bool FindFinessePath(const Bitboard& board, Piece piece, Position start, const BotMove& target,
+                     RotationSystem system, BotMove& out) {
+    const int x_min = -3;
+    const int x_span = 19;
+    const int node_count = ROTATION_COUNT * GAME_BOARD_HEIGHT * x_span;
+    auto node_of = [&](Piece p, Position pos) { return (p.rotation * GAME_BOARD_HEIGHT + pos.y) * x_span + (pos.x - x_min); };
+
+    uint16_t parent[node_count];
+    Action action[node_count];
+    uint8_t drop_rows[node_count];
+    bool seen[node_count] = {};
+    uint16_t queue[node_count];
+    if (board.Collides(piece.Mask(), start.x, start.y)) return false;
+
+    const Cells goal = CellsOf(target.piece, target.pos);
+    const bool is_srs = (system == RotationSystem::SRS);
+    const Action* keys = is_srs ? SRS_FINESSE_KEYS : CLASSIC_FINESSE_KEYS;
+    const int key_count = is_srs ? sizeof(SRS_FINESSE_KEYS) / sizeof(Action)
+                                 : sizeof(CLASSIC_FINESSE_KEYS) / sizeof(Action);
+
+    int head = 0;
+    int tail = 0;
+    int first = node_of(piece, start);
+    seen[first] = true;
+    parent[first] = static_cast<uint16_t>(first);
+    queue[tail++] = static_cast<uint16_t>(first);
+
+    while (head < tail) {
+        int index = queue[head++];
+        Piece current = {piece.type, static_cast<uint8_t>(index / (GAME_BOARD_HEIGHT * x_span))};
+        Position pos = {index % x_span + x_min, (index / x_span) % GAME_BOARD_HEIGHT};
+
+        if (CellsOf(current, LandingPosition(board, current, pos)) == goal) {
+            // Walk back to the start, writing the presses out as engine actions.
+            Action path[BotMove::MAX_ACTIONS];
+            int length = 0;
+            for (int node = index; parent[node] != node; node = parent[node]) {
+                int repeats = (action[node] == Action::SoftDrop) ? drop_rows[node] : 1;
+                for (int r = 0; r < repeats; ++r) {
+                    if (length == BotMove::MAX_ACTIONS - 1) return false;
+                    path[length++] = action[node];
+                }
+            }
+            out = target;
+            out.piece = current;
+            out.pos = LandingPosition(board, current, pos);
+            out.action_count = length + 1;
+            for (int i = 0; i < length; ++i) out.actions[i] = path[length - 1 - i];
+            out.actions[length] = Action::HardDrop;
+            return true;
+        }
+
+        for (int k = 0; k < key_count; ++k) {
+            Action key = keys[k];
+            Piece next_piece = current;
+            Position next = pos;
+            int rows = 1;
+            if (key == Action::SoftDrop) {
+                next = LandingPosition(board, current, pos);
+                rows = next.y - pos.y;
+                if (rows == 0) continue;
+            } else if (key == Action::MoveLeft || key == Action::MoveRight) {
+                next.x += (key == Action::MoveLeft) ? -1 : 1;
+                if (board.Collides(current.Mask(), next.x, next.y)) continue;
+            } else {
+                int turns = (key == Action::Rotate) ? 1 : (key == Action::Rotate180) ? 2 : 3;
+                if (RotateWithKicks(board, system, next_piece, next, turns) < 0 || next.y < 0) continue;
+            }
+
+            int next_index = node_of(next_piece, next);
+            if (seen[next_index]) continue;
+            seen[next_index] = true;
+            parent[next_index] = static_cast<uint16_t>(index);
+            action[next_index] = key;
+            drop_rows[next_index] = static_cast<uint8_t>(rows);
+            queue[tail++] = static_cast<uint16_t>(next_index);
+        }
+    }
+    return false;
+}
+
+// How many empty rows a piece starts above the stack. Kicks lift a piece at
+// most 2 rows, so from here on down it moves exactly as it would coming
+// from the spawn.
+const int KICK_ROOM = 3;
+
+// Where the placement search starts: the spawn column, dropped straight down
+// through the empty rows to just above the stack. Searching from the spawn
+// row itself finds the same spots, but spends most of its time shuffling the
+// piece around empty rows.
+Position DropZoneStart(const Bitboard& board) {
+    Position start = SpawnPosition(board);
+    int highest_top = GAME_BOARD_HEIGHT - 1;
+    for (int x = 1; x < LOGICAL_BOARD_WIDTH - 1; ++x) highest_top = std::min(highest_top, board.ColumnTop(x));
+    start.y = std::max(start.y, highest_top - 4 - KICK_ROOM);
+    return start;
+}
+
+} // namespace
+
+Solver::Solver(const SolverConfig& solver_config) : config(solver_config) {
+    // Hold changes the order pieces are placed in, never how many there are.
+    int queue_size = static_cast<int>(config.queue.size());
+    if (config.depth <= 0 || config.depth > queue_size) config.depth = queue_size;
+    memo.resize(size_t(1) << std::min(std::max(config.memo_bits, 10), 30));
+    stack.resize(config.depth + 1);
+}
+
+uint64_t Solver::MemoKey(uint64_t board_hash, int index, int held, int ply) const {
+    uint64_t slot = (static_cast<uint64_t>(index) << 16) | (static_cast<uint64_t>(held + 1) << 8) |
+                    static_cast<uint64_t>(ply);
+    uint64_t key = board_hash ^ SplitMix64(slot);
+    return key ? key : 1;
+}
+
+// Where the queue stands after placing a piece from (index, held).
+void Solver::NextQueueSlot(int index, int held, bool hold, int& next_index, int& next_held) const {
+    if (!hold) {
+        next_index = index + 1;
+        next_held = held;
+    } else if (index >= static_cast<int>(config.queue.size())) {
+        next_index = index; // The queue has run out: the held piece is the last one.
+        next_held = -1;
+    } else if (held < 0) {
+        next_index = index + 2; // The first hold pulls the piece after it out of the queue.
+        next_held = config.queue[index];
+    } else {
+        next_index = index + 1;
+        next_held = config.queue[index];
+    }
+}
+
+// Every row with a block in it has to be filled to clear, 4 cells a piece,
+// and the cells on the board plus the ones added must come to whole rows.
+bool Solver::CanStillPerfectClear(const Bitboard& board, int pieces_left) const {
+    int cells = 0;
+    int used_rows = 0;
+    for (int y = 1; y < GAME_BOARD_HEIGHT - 1; ++y) {
+        int count = CountBits(board.rows[y] & PLAY_MASK);
+        cells += count;
+        used_rows += (count != 0);
+    }
+    const int row_cells = LOGICAL_BOARD_WIDTH - 2;
+    for (int pieces = 0; pieces <= pieces_left; ++pieces) {
+        int total = cells + 4 * pieces;
+        if (total % row_cells == 0 && total >= row_cells * used_rows) return true;
+    }
+    return false;
+}
+
+void Solver::AddPieceOptions(const Bitboard& board, uint8_t type, bool hold, Children& children) {
+    int first = children.count;
+    int found = Bot::FindPlacements(board, Piece{type, 0}, DropZoneStart(board), &children.moves[first],
+                                    Children::CAPACITY - first, config.rotation_system);
+
+    for (int i = first; i < first + found; ++i) {
+        int slot = children.count;
+        Bitboard& after = children.boards[slot];
+        after = board;
+        int lines = Bot::PlaceAndClear(after, children.moves[i].piece, children.moves[i].pos);
+        if (config.max_height > 0 && UsedRows(after) > config.max_height) continue;
+
+        if (slot != i) children.moves[slot] = children.moves[i];
+        children.hold[slot] = hold;
+        children.lines[slot] = lines;
+        children.order[slot] = slot;
+        children.batch.Add(after);
+        children.count++;
+    }
+}
+
+void Solver::Expand(const Bitboard& board, int index, int held, Children& children) {
+    const int queue_size = static_cast<int>(config.queue.size());
+    children.count = 0;
+    children.batch.Clear();
+
+    int current = (index < queue_size) ? config.queue[index] : -1;
+    if (current >= 0) AddPieceOptions(board, static_cast<uint8_t>(current), false, children);
+    if (config.use_hold) {
+        int other = (held >= 0) ? held : (index + 1 < queue_size ? config.queue[index + 1] : -1);
+        // Holding a piece of the same type would only find the same boards again.
+        if (other >= 0 && other != current) AddPieceOptions(board, static_cast<uint8_t>(other), true, children);
+    }
+
+    // Score every board in one go and try the best looking ones first.
+    EvaluateBatch(children.batch, config.weights, children.scores, config.simd);
+    const float* scores = children.scores;
+    std::sort(children.order, children.order + children.count, [scores](int a, int b) {
+        return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+    });
+}
+
+bool Solver::BeatsValue(const Value& a, const Value& b) const {
+    return a.lines > b.lines || (a.lines == b.lines && a.score > b.score);
+}
+
+Solver::Value Solver::ChildValue(const Children& children, int child, int index, int held, int ply) {
+    result.nodes++;
+    const Bitboard& board = children.boards[child];
+    const int pieces_left = config.depth - ply - 1;
+
+    Value value;
+    if (config.goal == SolverGoal::PerfectClear) {
+        if (IsEmpty(board)) {
+            value.solutions = 1;
+            if (config.stop_at_first) stopped = true;
+            return value;
+        }
+        if (!CanStillPerfectClear(board, pieces_left)) return value;
+    } else if (pieces_left == 0) {
+        value.lines = children.lines[child];
+        value.score = children.scores[child];
+        return value;
+    }
+
+    int next_index = 0;
+    int next_held = 0;
+    NextQueueSlot(index, held, children.hold[child], next_index, next_held);
+    value = Search(board, next_index, next_held, ply + 1);
+    value.lines += children.lines[child];
+    return value;
+}
+
+Solver::Value Solver::Search(const Bitboard& board, int index, int held, int ply) {
+    uint64_t key = MemoKey(ZobristHash(board), index, held, ply);
+    MemoEntry& entry = memo[key & (memo.size() - 1)];
+    if (entry.key == key) {
+        result.memo_hits++;
+        return entry.value;
+    }
+
+    Children& children = stack[ply];
+    Expand(board, index, held, children);
+
+    Value best;
+    if (config.goal == SolverGoal::MaxLines) {
+        best.lines = DEAD_END_LINES;
+        best.score = LOSING_SCORE;
+    }
+    for (int k = 0; k < children.count; ++k) {
+        Value value = ChildValue(children, children.order[k], index, held, ply);
+        if (config.goal == SolverGoal::PerfectClear) {
+            best.solutions += value.solutions;
+        } else if (BeatsValue(value, best)) {
+            best = value;
+        }
+        if (stopped) return best; // Cut short: not the real value, so don't remember it.
+    }
+
+    // The subtrees may have taken this slot since; the newest result wins.
+    entry.key = key;
+    entry.value = best;
+    return best;
+}
+
+SolverResult Solver::Solve(const Bitboard& board) {
+    result = SolverResult();
+    result.final_board = board;
+    stopped = false;
+    std::fill(memo.begin(), memo.end(), MemoEntry());
+    if (config.depth == 0) return result;
+
+    auto start = std::chrono::steady_clock::now();
+    Value root = Search(board, 0, -1, 0);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t search_nodes = result.nodes;
+    uint64_t search_hits = result.memo_hits;
+    bool is_pc = (config.goal == SolverGoal::PerfectClear);
+
+    result.solutions = root.solutions;
+    result.best_lines = root.lines;
+    result.best_score = root.score;
+    if (is_pc ? root.solutions == 0 : root.lines == DEAD_END_LINES) return result;
+
+    // Walk the best line back out. Every finished subtree is in the memo, so
+    // this is mostly lookups: at each ply take the first child (in search
+    // order) that is worth what the rest of the line is worth.
+    Bitboard current = board;
+    int index = 0;
+    int held = -1;
+    Value wanted = root;
+    for (int ply = 0; ply < config.depth; ++ply) {
+        Children& children = stack[ply];
+        Expand(current, index, held, children);
+
+        int chosen = -1;
+        Value chosen_value;
+        for (int k = 0; k < children.count && chosen < 0; ++k) {
+            int child = children.order[k];
+            stopped = false;
+            Value value = ChildValue(children, child, index, held, ply);
+            bool matches = is_pc ? value.solutions > 0 : (value.lines == wanted.lines && value.score == wanted.score);
+            if (matches) {
+                chosen = child;
+                chosen_value = value;
+            }
+        }
+        if (chosen < 0) break; // Only if the memo lost an entry mid-walk; keep what we have.
+
+        SolverStep step;
+        step.hold = children.hold[chosen];
+        step.lines = children.lines[chosen];
+        step.move = children.moves[chosen];
+        Piece spawned = {step.move.piece.type, 0};
+        if (!FindFinessePath(current, spawned, SpawnPosition(current), children.moves[chosen],
+                             config.rotation_system, step.move)) {
+            // Only reachable thanks to the extra room below the ceiling: fall
+            // straight to the drop zone first, then take the path from there.
+            Position start = DropZoneStart(current);
+            int fall = start.y - SpawnPosition(current).y;
+            if (FindFinessePath(current, spawned, start, children.moves[chosen], config.rotation_system, step.move) &&
+                step.move.action_count + fall <= BotMove::MAX_ACTIONS) {
+                std::copy_backward(step.move.actions, step.move.actions + step.move.action_count,
+                                   step.move.actions + step.move.action_count + fall);
+                std::fill(step.move.actions, step.move.actions + fall, Action::SoftDrop);
+                step.move.action_count += fall;
+            }
+        }
+        result.steps.push_back(step);
+
+        current = children.boards[chosen];
+        wanted = chosen_value;
+        wanted.lines -= step.lines;
+        NextQueueSlot(index, held, step.hold, index, held);
+        if (is_pc && IsEmpty(current)) break;
+    }
+    result.final_board = current;
+    result.nodes = search_nodes;
+    result.memo_hits = search_hits;
+    return result;
+}
@@ -0,0 +1,116 @@
+#ifndef TETRIS_SOLVER_H
+#define TETRIS_SOLVER_H
+
+#include <cstdint>
+#include <vector>
+#include "BoardEval.h"
+#include "Bot.h"
+
+// An offline solver for training data: given a board and a known queue of
+// pieces, it searches every sequence of placements (the same reachable spots
+// and paths the bot uses, so tucks and kicks count) depth-first.
+//
+// - PerfectClear: counts the sequences of at most 'depth' pieces that leave
+//   the board completely empty, and keeps the first one it finds.
+// - MaxLines: finds the sequence of exactly 'depth' pieces that clears the
+//   most lines, ties going to the best-looking final board.
+//
+// Positions repeat a lot (the same two pieces placed in either order give
+// the same board), so every finished subtree is remembered in a
+// transposition table keyed by the board's Zobrist hash plus where in the
+// queue it is. At each node the boards after every placement are scored
+// together with EvaluateBatch, and the children are searched best first.
+// The steps of the answer come with finesse paths: the fewest key presses
+// (a soft drop all the way down counting as one) before the hard drop.
+
+enum class SolverGoal : uint8_t {
+    PerfectClear,
+    MaxLines
+};
+
+struct SolverConfig {
+    std::vector<uint8_t> queue;   // Piece types (0 = I ... 6 = Z), current piece first.
+    int depth = 0;                // How many pieces to place (at most the queue allows).
+    SolverGoal goal = SolverGoal::PerfectClear;
+    bool use_hold = false;        // Each piece may be swapped with the hold slot first.
+    bool stop_at_first = false;   // PerfectClear: stop once one is found.
+    int max_height = 0;           // Skip placements leaving more rows than this in use (0 = no limit).
+    RotationSystem rotation_system = RotationSystem::SRS;
+    SimdLevel simd = DetectSimdLevel();
+    EvalWeights weights;
+    int memo_bits = 20;           // The transposition table has 2^memo_bits entries.
+};
+
+// One piece of a solution.
+struct SolverStep {
+    bool hold = false;            // Hold first: 'move' is for the piece that comes out.
+    int lines = 0;                // Lines this placement cleared.
+    BotMove move;                 // Where it goes and the fewest keys that get it there.
+};
+
+struct SolverResult {
+    uint64_t nodes = 0;           // Placements tried.
+    uint64_t memo_hits = 0;
+    double seconds = 0.0;
+
+    uint64_t solutions = 0;       // PerfectClear: sequences found.
+    int best_lines = 0;           // MaxLines: lines of the best sequence.
+    float best_score = 0.0f;      // MaxLines: EvaluateBatch score of its final board.
+    std::vector<SolverStep> steps; // The first perfect clear, or the best sequence.
+    Bitboard final_board;         // The board after 'steps'.
+};
+
+class Solver {
+public:
+    explicit Solver(const SolverConfig& config);
+
+    SolverResult Solve(const Bitboard& board);
+
+private:
+    // What a subtree is worth. PerfectClear only uses 'solutions'.
+    struct Value {
+        uint64_t solutions = 0;
+        int lines = 0;
+        float score = 0.0f;
+    };
+
+    struct MemoEntry {
+        uint64_t key = 0;         // 0 = empty.
+        Value value;
+    };
+
+    // Every placement of one node (for the current piece and, with hold,
+    // the other one), scored and sorted best first.
+    struct Children {
+        static const int CAPACITY = BoardBatch::CAPACITY;
+
+        BotMove moves[CAPACITY];
+        bool hold[CAPACITY];
+        Bitboard boards[CAPACITY];
+        int lines[CAPACITY];
+        float scores[CAPACITY];
+        int order[CAPACITY];
+        int count = 0;
+        BoardBatch batch;
+    };
+
+    Value Search(const Bitboard& board, int index, int held, int ply);
+    void Expand(const Bitboard& board, int index, int held, Children& children);
+    void AddPieceOptions(const Bitboard& board, uint8_t type, bool hold, Children& children);
+    bool BeatsValue(const Value& a, const Value& b) const;
+    Value ChildValue(const Children& children, int child, int index, int held, int ply);
+    void NextQueueSlot(int index, int held, bool hold, int& next_index, int& next_held) const;
+    bool CanStillPerfectClear(const Bitboard& board, int pieces_left) const;
+    uint64_t MemoKey(uint64_t board_hash, int index, int held, int ply) const;
+
+    SolverConfig config;
+    std::vector<MemoEntry> memo;
+    std::vector<Children> stack; // One per ply, so the search never allocates.
+    SolverResult result;
+    bool stopped = false;
+};
+
+// The piece letters in type order, for reading queues and printing solutions.
+const char PIECE_LETTERS[PIECE_TYPE_COUNT + 1] = "IJLOSTZ";
+
+#endif
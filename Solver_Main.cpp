@@ -0,0 +1,218 @@
+#include "Solver.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace {
+
+const char* USAGE =
+    "usage: tetris_solver [--board=FILE] [--queue=PIECES | --seed=N] [--depth=K] [--goal=pc|lines]\n"
+    "                     [--hold] [--first] [--height=ROWS] [--rotation=srs|classic]\n"
+    "                     [--simd=auto|avx2|sse2|scalar] [--memo-bits=N]\n";
+
+// The short name of each action in a printed solution.
+const char* ActionName(Action action) {
+    switch (action) {
+        case Action::MoveLeft:  return "left";
+        case Action::MoveRight: return "right";
+        case Action::SoftDrop:  return "down";
+        case Action::HardDrop:  return "drop";
+        case Action::Rotate:    return "cw";
+        case Action::RotateCCW: return "ccw";
+        case Action::Rotate180: return "180";
+        case Action::Hold:      return "hold";
+        default:                return "none";
+    }
+}
+
+// Reads a board drawn in text: one line per row, the last line is the
+// bottom row, '.' or ' ' is empty and anything else is a block.
+bool LoadBoard(const char* path, Bitboard& board) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::fprintf(stderr, "could not open %s\n", path);
+        return false;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        lines.push_back(line);
+    }
+    while (!lines.empty() && lines.back().empty()) lines.pop_back();
+
+    const int play_height = GAME_BOARD_HEIGHT - 2;
+    const int play_width = LOGICAL_BOARD_WIDTH - 2;
+    if (static_cast<int>(lines.size()) > play_height) {
+        std::fprintf(stderr, "%s: the board is %d rows tall at most\n", path, play_height);
+        return false;
+    }
+
+    board.Reset();
+    int y = GAME_BOARD_HEIGHT - 1 - static_cast<int>(lines.size());
+    for (const std::string& row : lines) {
+        for (int x = 0; x < play_width && x < static_cast<int>(row.size()); ++x) {
+            if (row[x] == '.' || row[x] == ' ') continue;
+            board.rows[y] = static_cast<RowMask>(board.rows[y] | (RowMask(1) << (x + 1)));
+            board.ColorRow(y)[x + 1] = GARBAGE_CELL;
+        }
+        if (board.IsRowFull(y)) {
+            std::fprintf(stderr, "%s: row %d is already full\n", path, y);
+            return false;
+        }
+        ++y;
+    }
+    board.RebuildColumnTops();
+    return true;
+}
+
+bool ParseQueue(const char* text, std::vector<uint8_t>& queue) {
+    for (const char* c = text; *c; ++c) {
+        char letter = (*c >= 'a' && *c <= 'z') ? static_cast<char>(*c - 'a' + 'A') : *c;
+        const char* found = std::strchr(PIECE_LETTERS, letter);
+        if (!found) {
+            std::fprintf(stderr, "unknown piece '%c' (use %s)\n", *c, PIECE_LETTERS);
+            return false;
+        }
+        queue.push_back(static_cast<uint8_t>(found - PIECE_LETTERS));
+    }
+    return !queue.empty();
+}
+
+// The rows in use, top to bottom, in the same text form LoadBoard reads.
+void PrintBoard(const Bitboard& board) {
+    bool any = false;
+    for (int y = 1; y < GAME_BOARD_HEIGHT - 1; ++y) {
+        if (!any && board.rows[y] == WALL_ROW_MASK) continue;
+        any = true;
+        std::printf("  |");
+        for (int x = 1; x < LOGICAL_BOARD_WIDTH - 1; ++x) {
+            uint8_t color = board.Color(x, y);
+            std::putchar(color == 0 ? '.' : color == GARBAGE_CELL ? '#' : PIECE_LETTERS[color - 1]);
+        }
+        std::printf("|\n");
+    }
+    if (!any) std::printf("  (empty)\n");
+}
+
+// The left-most board column (0 = left wall side) the piece covers.
+int LeftColumn(const BotMove& move) {
+    const PieceMask& mask = move.piece.Mask();
+    for (int px = 0; px < 4; ++px) {
+        for (int py = 0; py < 4; ++py) {
+            if (mask.rows[py] & (1u << px)) return move.pos.x + px - 1;
+        }
+    }
+    return move.pos.x;
+}
+
+} // namespace
+
+// Searches a board and a known piece queue for perfect clears, or for the
+// most lines in K pieces, and prints how fast it went and what it found.
+int main(int argc, char** argv) {
+    SolverConfig config;
+    Bitboard board;
+    board.Reset();
+    uint64_t seed = 1;
+    bool has_queue = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--board=", 8) == 0) {
+            if (!LoadBoard(arg + 8, board)) return 2;
+        } else if (std::strncmp(arg, "--queue=", 8) == 0) {
+            if (!ParseQueue(arg + 8, config.queue)) return 2;
+            has_queue = true;
+        } else if (std::strncmp(arg, "--seed=", 7) == 0) {
+            seed = std::strtoull(arg + 7, nullptr, 10);
+        } else if (std::strncmp(arg, "--depth=", 8) == 0) {
+            config.depth = std::atoi(arg + 8);
+        } else if (std::strcmp(arg, "--goal=pc") == 0) {
+            config.goal = SolverGoal::PerfectClear;
+        } else if (std::strcmp(arg, "--goal=lines") == 0) {
+            config.goal = SolverGoal::MaxLines;
+        } else if (std::strcmp(arg, "--hold") == 0) {
+            config.use_hold = true;
+        } else if (std::strcmp(arg, "--first") == 0) {
+            config.stop_at_first = true;
+        } else if (std::strncmp(arg, "--height=", 9) == 0) {
+            config.max_height = std::atoi(arg + 9);
+        } else if (std::strcmp(arg, "--rotation=classic") == 0) {
+            config.rotation_system = RotationSystem::Classic;
+        } else if (std::strcmp(arg, "--rotation=srs") == 0) {
+            config.rotation_system = RotationSystem::SRS;
+        } else if (std::strcmp(arg, "--simd=auto") == 0) {
+            config.simd = DetectSimdLevel();
+        } else if (std::strcmp(arg, "--simd=scalar") == 0) {
+            config.simd = SimdLevel::Scalar;
+        } else if (std::strcmp(arg, "--simd=sse2") == 0 || std::strcmp(arg, "--simd=avx2") == 0) {
+            SimdLevel wanted = (arg[7] == 'a') ? SimdLevel::AVX2 : SimdLevel::SSE2;
+            if (wanted > DetectSimdLevel()) {
+                std::fprintf(stderr, "%s isn't available here (best is %s)\n", arg + 7,
+                             SimdLevelName(DetectSimdLevel()));
+                return 2;
+            }
+            config.simd = wanted;
+        } else if (std::strncmp(arg, "--memo-bits=", 12) == 0) {
+            config.memo_bits = std::atoi(arg + 12);
+        } else {
+            std::fputs(USAGE, stderr);
+            return 2;
+        }
+    }
+
+    // Without a queue, deal one from the 7-bag like a real game would.
+    if (!has_queue) {
+        if (config.depth <= 0) config.depth = 10;
+        int pieces = config.depth + (config.use_hold ? 1 : 0);
+        Randomizer randomizer;
+        randomizer.Reset(seed, RandomizerMode::SevenBag);
+        for (int i = 0; i < pieces; ++i) config.queue.push_back(randomizer.Next());
+    }
+
+    Solver solver(config);
+    SolverResult result = solver.Solve(board);
+
+    std::string queue;
+    for (uint8_t type : config.queue) queue += PIECE_LETTERS[type];
+    bool is_pc = (config.goal == SolverGoal::PerfectClear);
+
+    std::printf("goal:       %s\n", is_pc ? "perfect clear" : "most lines");
+    std::printf("queue:      %s%s\n", queue.c_str(), config.use_hold ? " (with hold)" : "");
+    std::printf("rotation:   %s\n", config.rotation_system == RotationSystem::SRS ? "srs" : "classic");
+    std::printf("simd:       %s\n", SimdLevelName(config.simd));
+    std::printf("board:\n");
+    PrintBoard(board);
+    std::printf("nodes:      %llu\n", static_cast<unsigned long long>(result.nodes));
+    std::printf("memo hits:  %llu\n", static_cast<unsigned long long>(result.memo_hits));
+    std::printf("seconds:    %.3f\n", result.seconds);
+    std::printf("nodes/sec:  %.0f\n", result.seconds > 0 ? result.nodes / result.seconds : 0.0);
+    if (is_pc) {
+        std::printf("solutions:  %llu%s\n", static_cast<unsigned long long>(result.solutions),
+                    config.stop_at_first ? " (stopped at the first)" : "");
+    } else {
+        std::printf("best lines: %d (final board scores %.2f)\n", result.best_lines, result.best_score);
+    }
+    if (result.steps.empty()) return 0;
+
+    std::printf("%s:\n", is_pc ? "first solution" : "best sequence");
+    for (size_t i = 0; i < result.steps.size(); ++i) {
+        const SolverStep& step = result.steps[i];
+        const BotMove& move = step.move;
+        std::printf("  %2zu. %c  rotation %d  column %d  lines %d  keys:", i + 1, PIECE_LETTERS[move.piece.type],
+                    move.piece.rotation, LeftColumn(move), step.lines);
+        if (step.hold) std::printf(" hold");
+        for (int a = 0; a < move.action_count; ++a) {
+            // A run of soft drops is one press held down to the floor.
+            if (a > 0 && move.actions[a] == Action::SoftDrop && move.actions[a - 1] == Action::SoftDrop) continue;
+            std::printf(" %s", ActionName(move.actions[a]));
+        }
+        std::printf("\n");
+    }
+    std::printf("final board:\n");
+    PrintBoard(result.final_board);
+    return 0;
+}
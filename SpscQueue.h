@@ -0,0 +1,46 @@
+#ifndef TETRIS_SPSC_QUEUE_H
+#define TETRIS_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// A fixed-size, lock-free queue for exactly one producer thread and one
+// consumer thread. Push and Pop never block and never allocate: each side
+// only writes its own index, and the other side reads it with acquire/release
+// ordering, so a slot is always fully written before the consumer sees it.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side. Returns false (and drops nothing) if the queue is full.
+    bool Push(const T& item) {
+        size_t tail = write_index.load(std::memory_order_relaxed);
+        if (tail - read_index.load(std::memory_order_acquire) == Capacity) return false;
+        slots[tail & (Capacity - 1)] = item;
+        write_index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if there was nothing to take.
+    bool Pop(T& item) {
+        size_t head = read_index.load(std::memory_order_relaxed);
+        if (head == write_index.load(std::memory_order_acquire)) return false;
+        item = slots[head & (Capacity - 1)];
+        read_index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool IsEmpty() const {
+        return read_index.load(std::memory_order_acquire) == write_index.load(std::memory_order_acquire);
+    }
+
+private:
+    // The two indices sit on their own cache lines so the threads don't
+    // keep stealing the line from each other.
+    alignas(64) std::atomic<size_t> write_index{0};
+    alignas(64) std::atomic<size_t> read_index{0};
+    T slots[Capacity];
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef TETRIS_TERMINAL_H
+#define TETRIS_TERMINAL_H
+
+#include <cstddef>
+
+// The few things the game needs from the text console. Each platform has its
+// own Terminal_*.cpp; the rest of the game only talks to this class.
+class Terminal {
+public:
+    // Hides the cursor, turns on ANSI escape sequences and clears the screen.
+    void Setup();
+
+    // Puts the console back the way we found it.
+    void Restore();
+
+    // Sends a whole frame to the screen in one system call.
+    void Write(const char* data, size_t size);
+
+    // Sleeps until a key is waiting or 'timeout_ms' has passed (-1 = forever).
+    // Returns true if there is input to read.
+    bool WaitForInput(int timeout_ms);
+
+    // The next key press, or -1 if none is waiting. Never blocks.
+    int ReadKey();
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "Terminal.h"
+#include <csignal>
+#include <cstdlib>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// The tty settings from before we switched to raw mode, so we can put them back.
+static struct termios g_original_settings;
+static bool g_is_raw = false;
+static bool g_is_set_up = false;    // Cursor hidden, needs restoring.
+static bool g_handlers_installed = false;
+
+static void WriteAll(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(STDOUT_FILENO, data, size);
+        if (written <= 0) return;
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+static void RestoreTty() {
+    if (!g_is_set_up) return;
+    g_is_set_up = false;
+
+    if (g_is_raw) {
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &g_original_settings);
+        g_is_raw = false;
+    }
+    // Show the cursor again and leave the prompt below the board.
+    const char reset[] = "\x1b[?25h\x1b[0m\x1b[25;1H\n";
+    WriteAll(reset, sizeof(reset) - 1);
+}
+
+// Ctrl+C (or a kill) must not leave the user's shell in raw mode.
+static void HandleSignal(int signal_number) {
+    RestoreTty();
+    std::signal(signal_number, SIG_DFL);
+    std::raise(signal_number);
+}
+
+void Terminal::Setup() {
+    if (!g_is_raw && isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &g_original_settings) == 0) {
+        // Raw-ish mode: keys arrive one at a time without Enter and without
+        // being echoed. Signals (Ctrl+C) and output processing stay on.
+        struct termios raw = g_original_settings;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_iflag &= ~(IXON | ICRNL);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        g_is_raw = (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == 0);
+    }
+
+    if (!g_handlers_installed) {
+        g_handlers_installed = true;
+        std::atexit(RestoreTty);
+        std::signal(SIGINT, HandleSignal);
+        std::signal(SIGTERM, HandleSignal);
+    }
+    g_is_set_up = true;
+
+    // Hide the cursor and wipe any old text.
+    const char clear[] = "\x1b[?25l\x1b[2J\x1b[H";
+    Write(clear, sizeof(clear) - 1);
+}
+
+void Terminal::Restore() {
+    RestoreTty();
+}
+
+void Terminal::Write(const char* data, size_t size) {
+    WriteAll(data, size);
+}
+
+bool Terminal::WaitForInput(int timeout_ms) {
+    struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+    return poll(&input, 1, timeout_ms) > 0 && (input.revents & POLLIN);
+}
+
+// The rest of an escape sequence arrives right behind the ESC; a lone ESC
+// (the Escape key itself) has nothing after it within this long.
+static const int ESCAPE_WAIT_MS = 10;
+
+// A byte read after an ESC that turned out not to start a sequence.
+static int g_pending_key = -1;
+
+static int ReadByte(int timeout_ms) {
+    struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+    if (poll(&input, 1, timeout_ms) <= 0 || !(input.revents & POLLIN)) return -1;
+    unsigned char byte = 0;
+    return (::read(STDIN_FILENO, &byte, 1) == 1) ? byte : -1;
+}
+
+// Arrow keys send "ESC [ A" (or "ESC O A" in application mode). Their last
+// letters must never reach the game as keys of their own, so the whole
+// sequence is read here: the arrows become the same keys as W / S / D / A
+// and anything else (Home, F1, ...) is dropped.
+static int TranslateEscapeSequence() {
+    int intro = ReadByte(ESCAPE_WAIT_MS);
+    if (intro == -1) return 0x1b;
+    if (intro != '[' && intro != 'O') {
+        g_pending_key = intro; // Alt+key: hand both bytes on as they came.
+        return 0x1b;
+    }
+
+    // "ESC [" may carry numbers and ';' before the final byte (0x40-0x7E).
+    int final_byte = ReadByte(ESCAPE_WAIT_MS);
+    while (intro == '[' && final_byte != -1 && (final_byte < 0x40 || final_byte > 0x7e)) {
+        final_byte = ReadByte(ESCAPE_WAIT_MS);
+    }
+    switch (final_byte) {
+        case 'A': return 'w'; // Up: rotate.
+        case 'B': return 's'; // Down: soft drop.
+        case 'C': return 'd'; // Right.
+        case 'D': return 'a'; // Left.
+        default: return 0;    // Not a key the game uses.
+    }
+}
+
+int Terminal::ReadKey() {
+    for (;;) {
+        int key = g_pending_key;
+        g_pending_key = -1;
+        if (key == -1) key = ReadByte(0);
+        if (key != 0x1b) return key;
+
+        key = TranslateEscapeSequence();
+        if (key != 0) return key;
+    }
+}
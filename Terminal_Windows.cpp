@@ -0,0 +1,73 @@
+#include "Terminal.h"
+#include <conio.h>
+#include <windows.h>
+
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+
+// This prepares the command prompt window for the game.
+void Terminal::Setup() {
+    HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+
+    // Let the console understand ANSI escape sequences, which is how the
+    // renderer moves the cursor around.
+    DWORD mode = 0;
+    if (GetConsoleMode(consoleHandle, &mode)) {
+        SetConsoleMode(consoleHandle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+
+    // We hide the blinking underscore (the cursor) so it doesn't distract the player.
+    CONSOLE_CURSOR_INFO cursorInfo;
+    GetConsoleCursorInfo(consoleHandle, &cursorInfo);
+    cursorInfo.bVisible = FALSE;
+    SetConsoleCursorInfo(consoleHandle, &cursorInfo);
+
+    // Wipe any old text and set the window title.
+    const char clear[] = "\x1b[2J\x1b[H";
+    Write(clear, sizeof(clear) - 1);
+    SetConsoleTitleA("Tetris Game (C++)");
+}
+
+void Terminal::Restore() {
+    HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+    CONSOLE_CURSOR_INFO cursorInfo;
+    GetConsoleCursorInfo(consoleHandle, &cursorInfo);
+    cursorInfo.bVisible = TRUE;
+    SetConsoleCursorInfo(consoleHandle, &cursorInfo);
+}
+
+void Terminal::Write(const char* data, size_t size) {
+    DWORD written = 0;
+    WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), data, static_cast<DWORD>(size), &written, nullptr);
+}
+
+bool Terminal::WaitForInput(int timeout_ms) {
+    if (_kbhit()) return true;
+
+    // The console input handle is signalled when events arrive. Mouse and focus
+    // events also wake us, which is harmless: ReadKey just finds nothing.
+    DWORD timeout = (timeout_ms < 0) ? INFINITE : static_cast<DWORD>(timeout_ms);
+    WaitForSingleObject(GetStdHandle(STD_INPUT_HANDLE), timeout);
+    return _kbhit() != 0;
+}
+
+int Terminal::ReadKey() {
+    /* _kbhit() checks if a key has been pressed so the game doesn't
+       stop and wait for you; it just keeps running. */
+    while (_kbhit()) {
+        int key = _getch();
+        if (key != 0 && key != 0xE0) return key;
+
+        // Arrows and function keys come as a prefix byte and a scan code.
+        // Map the arrows like the POSIX terminal does and drop the rest.
+        switch (_getch()) {
+            case 'H': return 'w'; // Up: rotate.
+            case 'P': return 's'; // Down: soft drop.
+            case 'M': return 'd'; // Right.
+            case 'K': return 'a'; // Left.
+            default: break;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,218 @@
+#ifndef TETRIS_TETROMINO_H
+#define TETRIS_TETROMINO_H
+
+#include <cstdint>
+#include "Bitboard.h"
+
+const int PIECE_TYPE_COUNT = 7;
+const int ROTATION_COUNT = 4;
+
+// Keeping the shapes here so they don't clutter up our logic functions.
+// These are the "Blueprints" for every piece in the game, drawn on a 4x4 grid:
+// 'X' is a solid block, and '.' is empty space.
+constexpr char TETROMINO_TEMPLATES[PIECE_TYPE_COUNT][4][5] = {
+    {"....", "XXXX", "....", "...."}, // I
+    {"....", ".X..", ".XXX", "...."}, // J
+    {"....", "..X.", ".XXX", "...."}, // L
+    {"....", ".XX.", ".XX.", "...."}, // O
+    {"....", "..XX", ".XX.", "...."}, // S
+    {"....", ".XXX", "..X.", "...."}, // T
+    {"....", ".XX.", "..XX", "...."}  // Z
+};
+
+// Squeezes a 4x4 'X'/'.' template into one bitmask per row.
+constexpr PieceMask BuildPieceMask(const char (&shape)[4][5]) {
+    PieceMask mask = {};
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            if (shape[y][x] == 'X') mask.rows[y] = static_cast<uint8_t>(mask.rows[y] | (1u << x));
+        }
+    }
+    return mask;
+}
+
+// This is a math trick to rotate a 4x4 grid by 90 degrees clockwise:
+// cell (x, y) moves to (3 - y, x), flipping rows into columns.
+constexpr PieceMask RotatePiece(const PieceMask& current) {
+    PieceMask rotated = {};
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            if (current.rows[y] & (1u << x)) {
+                rotated.rows[x] = static_cast<uint8_t>(rotated.rows[x] | (1u << (3 - y)));
+            }
+        }
+    }
+    return rotated;
+}
+
+// Every piece in every rotation, worked out by the compiler.
+struct PieceTable {
+    PieceMask masks[PIECE_TYPE_COUNT][ROTATION_COUNT];
+    PieceProfile profiles[PIECE_TYPE_COUNT][ROTATION_COUNT]; // For dropping without stepping (see LandingRow).
+};
+
+constexpr PieceTable BuildPieceTable() {
+    PieceTable table = {};
+    for (int type = 0; type < PIECE_TYPE_COUNT; ++type) {
+        table.masks[type][0] = BuildPieceMask(TETROMINO_TEMPLATES[type]);
+        for (int rotation = 1; rotation < ROTATION_COUNT; ++rotation) {
+            table.masks[type][rotation] = RotatePiece(table.masks[type][rotation - 1]);
+        }
+        for (int rotation = 0; rotation < ROTATION_COUNT; ++rotation) {
+            table.profiles[type][rotation] = BuildPieceProfile(table.masks[type][rotation]);
+        }
+    }
+    return table;
+}
+
+constexpr PieceTable PIECE_TABLE = BuildPieceTable();
+
+// A piece is just "which shape" and "which way round". Everything else comes
+// from PIECE_TABLE, so pieces are two bytes and copying one is free.
+struct Piece {
+    uint8_t type = 0;     // Index into TETROMINO_TEMPLATES (0 = I ... 6 = Z).
+    uint8_t rotation = 0; // 0..3, clockwise quarter turns from the template.
+
+    // The color/type ID stored on the board (1..7, walls are 9).
+    int Id() const { return type + 1; }
+
+    const PieceMask& Mask() const { return PIECE_TABLE.masks[type][rotation]; }
+    const PieceProfile& Profile() const { return PIECE_TABLE.profiles[type][rotation]; }
+
+    // True if the 4x4 cell (x, y) of this piece is solid.
+    bool HasCell(int x, int y) const { return (Mask().rows[y] >> x) & 1u; }
+
+    // The same piece turned 'turns' quarters clockwise (3 = one quarter counter-clockwise).
+    constexpr Piece Rotated(int turns = 1) const { return Piece{type, static_cast<uint8_t>((rotation + turns) & 3)}; }
+};
+
+// --- Super Rotation System (SRS) ---
+// SRS turns J, L, S, T and Z around the middle cell of a 3x3 box, and I and O
+// around the middle of their 4x4 box. PIECE_TABLE spins every shape around
+// the middle of the 4x4 grid instead, so after a turn a 3x3 piece sits a cell
+// away from where SRS puts it. The kick tables below have that difference
+// folded in: the first kick of every turn lands exactly on the SRS spot.
+
+const int PIECE_I = 0;
+const int PIECE_O = 3;
+const int PIECE_T = 5;
+
+// The SRS state (0 = spawn, 1 = R, 2 = 2, 3 = L) our rotation 0 is in. The T
+// template points down, which is SRS state 2; the others are drawn the SRS way.
+constexpr uint8_t SRS_STATE_OF_ROTATION_0[PIECE_TYPE_COUNT] = {0, 0, 0, 0, 0, 2, 0};
+
+// Where each piece turns around in its 4x4 grid at rotation 0, in half cells
+// so the I and O centers (which fall between cells) are whole numbers.
+constexpr int8_t SRS_CENTER_X2[PIECE_TYPE_COUNT][2] = {
+    {3, 3}, {4, 4}, {4, 4}, {3, 3}, {4, 4}, {4, 2}, {4, 4}
+};
+
+// The SRS state a piece is in.
+constexpr int SrsState(Piece piece) {
+    return (piece.rotation + SRS_STATE_OF_ROTATION_0[piece.type]) & 3;
+}
+
+// The turning center of a piece in its 4x4 grid, in half cells. Turning the
+// grid moves it the same way it moves a cell: (x, y) -> (3 - y, x).
+struct HalfCell {
+    int8_t x;
+    int8_t y;
+};
+
+constexpr HalfCell SrsCenterX2(Piece piece) {
+    HalfCell center = {SRS_CENTER_X2[piece.type][0], SRS_CENTER_X2[piece.type][1]};
+    for (int i = 0; i < piece.rotation; ++i) {
+        center = HalfCell{static_cast<int8_t>(6 - center.y), center.x};
+    }
+    return center;
+}
+
+// The published kick tests, by SRS state turned from and then by turn
+// (clockwise, 180, counter-clockwise). These use the guideline's axes: +y is
+// UP. Quarter turns have 5 tests; the unofficial 180 turns use the common
+// 6-test table (the guideline itself has no 180 turn). O never kicks.
+constexpr int8_t SRS_JLSTZ_KICKS[4][3][6][2] = {
+    {{{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}},          // 0 -> R
+     {{0, 0}, {0, 1}, {1, 1}, {-1, 1}, {1, 0}, {-1, 0}},     // 0 -> 2
+     {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}}},            // 0 -> L
+    {{{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},              // R -> 2
+     {{0, 0}, {1, 0}, {1, 2}, {1, 1}, {0, 2}, {0, 1}},       // R -> L
+     {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}}},             // R -> 0
+    {{{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}},             // 2 -> L
+     {{0, 0}, {0, -1}, {-1, -1}, {1, -1}, {-1, 0}, {1, 0}},  // 2 -> 0
+     {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}}},         // 2 -> R
+    {{{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}},           // L -> 0
+     {{0, 0}, {-1, 0}, {-1, 2}, {-1, 1}, {0, 2}, {0, 1}},    // L -> R
+     {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}}},          // L -> 2
+};
+
+constexpr int8_t SRS_I_KICKS[4][3][6][2] = {
+    {{{0, 0}, {-2, 0}, {1, 0}, {-2, -1}, {1, 2}},            // 0 -> R
+     {{0, 0}, {0, 1}, {1, 1}, {-1, 1}, {1, 0}, {-1, 0}},     // 0 -> 2
+     {{0, 0}, {-1, 0}, {2, 0}, {-1, 2}, {2, -1}}},           // 0 -> L
+    {{{0, 0}, {-1, 0}, {2, 0}, {-1, 2}, {2, -1}},            // R -> 2
+     {{0, 0}, {1, 0}, {1, 2}, {1, 1}, {0, 2}, {0, 1}},       // R -> L
+     {{0, 0}, {2, 0}, {-1, 0}, {2, 1}, {-1, -2}}},           // R -> 0
+    {{{0, 0}, {2, 0}, {-1, 0}, {2, 1}, {-1, -2}},            // 2 -> L
+     {{0, 0}, {0, -1}, {-1, -1}, {1, -1}, {-1, 0}, {1, 0}},  // 2 -> 0
+     {{0, 0}, {1, 0}, {-2, 0}, {1, -2}, {-2, 1}}},           // 2 -> R
+    {{{0, 0}, {1, 0}, {-2, 0}, {1, -2}, {-2, 1}},            // L -> 0
+     {{0, 0}, {-1, 0}, {-1, 2}, {-1, 1}, {0, 2}, {0, 1}},    // L -> R
+     {{0, 0}, {-2, 0}, {1, 0}, {-2, -1}, {1, 2}}},           // L -> 2
+};
+
+// The spots one turn may try, in order, as moves of the piece's (x, y) in
+// board space (+y is down).
+struct KickList {
+    static const int MAX_KICKS = 6;
+
+    int8_t offsets[MAX_KICKS][2];
+    uint8_t count;
+    // Bit i is set if test i is the long one-column, two-row kick that
+    // twists a T into a slot it could never fall into (see SpinType).
+    uint8_t long_kicks;
+};
+
+// Every piece, rotation and turn, worked out by the compiler. A turn is then
+// one lookup plus at most 6 Collides calls of up to 4 ANDs each.
+struct SrsKickTable {
+    KickList kicks[PIECE_TYPE_COUNT][ROTATION_COUNT][3]; // [type][rotation][turns - 1]
+};
+
+constexpr SrsKickTable BuildSrsKickTable() {
+    SrsKickTable table = {};
+    for (int type = 0; type < PIECE_TYPE_COUNT; ++type) {
+        for (int rotation = 0; rotation < ROTATION_COUNT; ++rotation) {
+            for (int turn = 0; turn < 3; ++turn) {
+                KickList& list = table.kicks[type][rotation][turn];
+                if (type == PIECE_O) {
+                    list.count = 1; // It looks the same every way round.
+                    continue;
+                }
+
+                // Keep the SRS center where it was: that is how far our grid
+                // has to move to make up for turning around its own middle.
+                Piece from = {static_cast<uint8_t>(type), static_cast<uint8_t>(rotation)};
+                HalfCell before = SrsCenterX2(from);
+                HalfCell after = SrsCenterX2(from.Rotated(turn + 1));
+                int shift_x = (before.x - after.x) / 2;
+                int shift_y = (before.y - after.y) / 2;
+
+                const int8_t (&tests)[6][2] = (type == PIECE_I) ? SRS_I_KICKS[SrsState(from)][turn]
+                                                                : SRS_JLSTZ_KICKS[SrsState(from)][turn];
+                list.count = (turn == 1) ? 6 : 5;
+                for (int i = 0; i < list.count; ++i) {
+                    list.offsets[i][0] = static_cast<int8_t>(shift_x + tests[i][0]);
+                    list.offsets[i][1] = static_cast<int8_t>(shift_y - tests[i][1]);
+                    bool is_long = (tests[i][0] == 1 || tests[i][0] == -1) && (tests[i][1] == 2 || tests[i][1] == -2);
+                    if (is_long) list.long_kicks = static_cast<uint8_t>(list.long_kicks | (1u << i));
+                }
+            }
+        }
+    }
+    return table;
+}
+
+constexpr SrsKickTable SRS_KICK_TABLE = BuildSrsKickTable();
+
+#endif
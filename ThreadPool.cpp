@@ -0,0 +1,96 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int thread_count) {
+    if (thread_count <= 0) {
+        thread_count = static_cast<int>(std::thread::hardware_concurrency());
+        if (thread_count <= 0) thread_count = 1;
+    }
+
+    for (int i = 0; i < thread_count; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+void ThreadPool::Run(int count, const void* task_object, TaskCall call) {
+    if (count <= 0) return;
+
+    // Set the task up before any index is visible in a queue; the queue
+    // mutexes make sure a worker that pops an index also sees these.
+    current_task = task_object;
+    current_call = call;
+    remaining.store(count);
+
+    // Deal the indices out in equal slices. Stealing evens out whatever is left.
+    int worker_count = ThreadCount();
+    for (int i = 0; i < worker_count; ++i) {
+        WorkerQueue& queue = *queues[i];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.begin = static_cast<int>(static_cast<int64_t>(count) * i / worker_count);
+        queue.end = static_cast<int>(static_cast<int64_t>(count) * (i + 1) / worker_count);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    generation++;
+    wake.notify_all();
+    done.wait(lock, [this] { return remaining.load() == 0; });
+    current_task = nullptr;
+    current_call = nullptr;
+}
+
+bool ThreadPool::PopOrSteal(int worker, int& task) {
+    // Our own queue first, newest task first (it's the warmest in cache).
+    {
+        WorkerQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.begin < own.end) {
+            task = --own.end;
+            return true;
+        }
+    }
+
+    // Then steal the oldest task from everybody else.
+    int worker_count = ThreadCount();
+    for (int offset = 1; offset < worker_count; ++offset) {
+        WorkerQueue& victim = *queues[(worker + offset) % worker_count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.begin < victim.end) {
+            task = victim.begin++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(int worker) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) return;
+            seen_generation = generation;
+        }
+
+        int task;
+        while (PopOrSteal(worker, task)) {
+            current_call(current_task, task);
+            if (remaining.fetch_sub(1) == 1) {
+                // Last one out wakes up ParallelFor.
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef TETRIS_THREAD_POOL_H
+#define TETRIS_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small work-stealing thread pool.
+// Every worker has its own queue of task indices. A worker takes work from
+// the back of its own queue and, once that runs dry, steals from the front of
+// somebody else's, so a few long tasks (e.g. long games) don't leave the
+// other cores idle.
+class ThreadPool {
+public:
+    // 0 threads = one per hardware core.
+    explicit ThreadPool(int thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int ThreadCount() const { return static_cast<int>(threads.size()); }
+
+    // Calls task(index) for every index in [0, count) across the workers and
+    // waits until all of them are finished. 'task' must be safe to call from
+    // several threads at once. It is only borrowed for the call, never copied
+    // into a std::function, so handing over a lambda doesn't allocate.
+    template <typename Task>
+    void ParallelFor(int count, const Task& task) {
+        Run(count, &task, [](const void* task_object, int index) { (*static_cast<const Task*>(task_object))(index); });
+    }
+
+private:
+    // A worker's share of the indices: [begin, end). The owner takes from
+    // the end, thieves from the beginning, so no list of tasks is ever built.
+    struct WorkerQueue {
+        std::mutex mutex;
+        int begin = 0;
+        int end = 0;
+    };
+
+    using TaskCall = void (*)(const void* task_object, int index);
+
+    void Run(int count, const void* task_object, TaskCall call);
+    void WorkerLoop(int worker);
+    bool PopOrSteal(int worker, int& task);
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+    std::mutex mutex;                     // Guards generation / stopping.
+    std::condition_variable wake;         // Workers sleep here between batches.
+    std::condition_variable done;         // ParallelFor sleeps here until remaining == 0.
+    uint64_t generation = 0;              // Bumped once per ParallelFor call.
+    bool stopping = false;
+
+    const void* current_task = nullptr;   // The task of the running ParallelFor...
+    TaskCall current_call = nullptr;      // ...and how to call it.
+    std::atomic<int> remaining{0};
+};
+
+#endif
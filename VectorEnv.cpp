@@ -0,0 +1,132 @@
+#include "VectorEnv.h"
+#include <algorithm>
+#include "BatchRunner.h"
+
+VectorEnv::VectorEnv(const EnvConfig& env_config, int thread_count)
+    : config(env_config), pool(thread_count) {
+    config.env_count = std::max(config.env_count, 1);
+    // A few ranges per worker so a thread that finishes early can steal.
+    range_count = std::min(config.env_count, pool.ThreadCount() * 4);
+    games.resize(config.env_count);
+    episodes.resize(config.env_count);
+    last_episodes.resize(config.env_count);
+    episode_counts.assign(config.env_count, 0);
+}
+
+template <typename Work>
+void VectorEnv::ForEachRange(const Work& work) {
+    int count = config.env_count;
+    if (range_count <= 1) {
+        work(0, count);
+        return;
+    }
+    pool.ParallelFor(range_count, [&](int range) {
+        work(static_cast<int>(static_cast<long long>(count) * range / range_count),
+             static_cast<int>(static_cast<long long>(count) * (range + 1) / range_count));
+    });
+}
+
+void VectorEnv::StartEpisode(int env) {
+    GameState& state = games[env];
+    EpisodeStats& episode = episodes[env];
+
+    episode = EpisodeStats();
+    episode.seed = BatchRunner::SeedForGame(BatchRunner::SeedForGame(base_seed, env),
+                                            static_cast<int>(episode_counts[env]++));
+    state.line_clear_delay_ms = 0; // An agent doesn't wait for the flash.
+    state.lock_delay_ms = config.lock_delay_ms;
+    state.rotation_system = config.rotation_system;
+    state.mode = config.mode;
+    state.randomizer.Reset(episode.seed, config.randomizer_mode);
+    ResetGameState(state, episode.seed);
+}
+
+void VectorEnv::WriteObservation(int env, float* row) const {
+    const GameState& state = games[env];
+    const int W = EnvObservation::PLAY_WIDTH;
+
+    float* board = row + EnvObservation::BOARD;
+    for (int y = 0; y < EnvObservation::PLAY_HEIGHT; ++y) {
+        uint64_t bits = static_cast<uint64_t>(state.board.rows[y + 1]) >> 1; // Skip the ceiling and left wall.
+        for (int x = 0; x < W; ++x) board[y * W + x] = static_cast<float>((bits >> x) & 1u);
+    }
+
+    // The falling piece on a grid of its own, clipped to the play area.
+    float* piece = row + EnvObservation::PIECE;
+    std::fill(piece, piece + EnvObservation::GRID_SIZE, 0.0f);
+    if (!state.is_game_over) {
+        const PieceMask& mask = state.current_piece.Mask();
+        for (int py = 0; py < 4; ++py) {
+            int y = state.current_pos.y + py - 1;
+            if (mask.rows[py] == 0 || y < 0 || y >= EnvObservation::PLAY_HEIGHT) continue;
+            for (int px = 0; px < 4; ++px) {
+                int x = state.current_pos.x + px - 1;
+                if (((mask.rows[py] >> px) & 1u) && x >= 0 && x < W) piece[y * W + x] = 1.0f;
+            }
+        }
+    }
+
+    std::fill(row + EnvObservation::CURRENT, row + EnvObservation::SCORE, 0.0f);
+    row[EnvObservation::CURRENT + state.current_piece.type] = 1.0f;
+    row[EnvObservation::NEXT + PeekPiece(state, 0).type] = 1.0f;
+    if (state.held_type >= 0) row[EnvObservation::HELD + state.held_type] = 1.0f;
+
+    row[EnvObservation::SCORE] = static_cast<float>(state.score);
+    row[EnvObservation::LINES] = static_cast<float>(state.lines_cleared);
+    row[EnvObservation::LEVEL] = static_cast<float>(state.level);
+}
+
+void VectorEnv::Reset(uint64_t seed, float* observations) {
+    base_seed = seed;
+    std::fill(episode_counts.begin(), episode_counts.end(), 0);
+    std::fill(last_episodes.begin(), last_episodes.end(), EpisodeStats());
+
+    ForEachRange([&](int first, int last) {
+        for (int env = first; env < last; ++env) {
+            StartEpisode(env);
+            WriteObservation(env, observations + static_cast<size_t>(env) * OBSERVATION_SIZE);
+        }
+    });
+}
+
+void VectorEnv::Step(const int32_t* actions, float* observations, float* rewards, uint8_t* dones,
+                     uint8_t* truncations) {
+    ForEachRange([&](int first, int last) {
+        for (int env = first; env < last; ++env) {
+            GameState& state = games[env];
+            EpisodeStats& episode = episodes[env];
+
+            int32_t value = actions[env];
+            Action action = (value >= 0 && value < ACTION_COUNT) ? static_cast<Action>(value) : Action::None;
+            int score_before = state.score;
+            StepResult result = StepGame(state, action, config.ms_per_step);
+            episode.pieces += result.pieces_locked;
+            episode.steps++;
+
+            float reward = static_cast<float>(state.score - score_before);
+            if (state.is_game_over && !state.is_goal_reached) reward += config.game_over_reward;
+            bool is_truncated = !state.is_game_over && config.max_episode_steps > 0 &&
+                                episode.steps >= config.max_episode_steps;
+            bool is_done = state.is_game_over || is_truncated;
+
+            rewards[env] = reward;
+            dones[env] = is_done ? 1 : 0;
+            if (truncations) truncations[env] = is_truncated ? 1 : 0;
+
+            if (is_done) {
+                episode.score = state.score;
+                episode.lines = state.lines_cleared;
+                episode.was_truncated = is_truncated;
+                last_episodes[env] = episode;
+                StartEpisode(env);
+            }
+            WriteObservation(env, observations + static_cast<size_t>(env) * OBSERVATION_SIZE);
+        }
+    });
+}
+
+uint64_t VectorEnv::EpisodesFinished() const {
+    uint64_t started = 0;
+    for (uint64_t count : episode_counts) started += count;
+    return started > 0 ? started - static_cast<uint64_t>(config.env_count) : 0;
+}
@@ -0,0 +1,109 @@
+#ifndef TETRIS_VECTOR_ENV_H
+#define TETRIS_VECTOR_ENV_H
+
+#include <cstdint>
+#include <vector>
+#include "Engine.h"
+#include "ThreadPool.h"
+
+// A reinforcement-learning environment in the style of Gym's vector envs:
+// M games on the same rules as the console game (the same StepGame, so the
+// same wall kicks in TryRotationWithWallKicks and the same GetFallSpeedMS
+// gravity), reset and stepped together across a thread pool.
+//
+// Nothing is returned by value. The caller owns one contiguous float buffer
+// of EnvCount() * OBSERVATION_SIZE (e.g. a numpy / torch tensor's memory)
+// plus reward and done arrays of EnvCount(), and every Step writes straight
+// into them, each environment into its own row. After the constructor no
+// Reset or Step touches the heap.
+
+// Where each part of one environment's observation row sits, in floats.
+// Grids are play rows top to bottom, each row left to right.
+struct EnvObservation {
+    static const int PLAY_WIDTH = LOGICAL_BOARD_WIDTH - 2;
+    static const int PLAY_HEIGHT = GAME_BOARD_HEIGHT - 2;
+    static const int GRID_SIZE = PLAY_WIDTH * PLAY_HEIGHT;
+
+    static const int BOARD = 0;                            // 1 = a locked block.
+    static const int PIECE = BOARD + GRID_SIZE;            // 1 = a cell of the falling piece.
+    static const int CURRENT = PIECE + GRID_SIZE;          // One-hot type of the falling piece.
+    static const int NEXT = CURRENT + PIECE_TYPE_COUNT;    // One-hot type of the next piece.
+    static const int HELD = NEXT + PIECE_TYPE_COUNT;       // One-hot type in the hold slot (all 0 = empty).
+    static const int SCORE = HELD + PIECE_TYPE_COUNT;      // The game's numbers, unscaled.
+    static const int LINES = SCORE + 1;
+    static const int LEVEL = LINES + 1;
+    static const int SIZE = LEVEL + 1;
+};
+
+struct EnvConfig {
+    int env_count = 64;
+    int ms_per_step = 16;                 // Game time that passes after every action.
+    uint64_t max_episode_steps = 0;       // Cut an episode off after this many steps (0 = never).
+    RandomizerMode randomizer_mode = RandomizerMode::SevenBag;
+    RotationSystem rotation_system = RotationSystem::Classic;
+    GameMode mode = GameMode::Classic;    // Sprint and Ultra episodes also end at their goal.
+    int lock_delay_ms = 0;
+    float game_over_reward = 0.0f;        // Added to the reward of the step that tops out.
+};
+
+// The final numbers of an environment's last finished episode.
+struct EpisodeStats {
+    uint64_t seed = 0;
+    int score = 0;
+    int lines = 0;
+    int pieces = 0;
+    uint64_t steps = 0;
+    bool was_truncated = false;           // Hit max_episode_steps rather than topping out.
+};
+
+class VectorEnv {
+public:
+    static const int OBSERVATION_SIZE = EnvObservation::SIZE;
+    static const int ACTION_COUNT = static_cast<int>(Action::Hold) + 1; // Actions are Action values.
+
+    // 0 threads = one per hardware core.
+    explicit VectorEnv(const EnvConfig& config, int thread_count = 0);
+
+    int EnvCount() const { return config.env_count; }
+
+    // Starts a new episode in every environment and writes their first
+    // observations. Environment i's episodes are seeded from (seed, i) and
+    // how many episodes it has played, so a run is the same for any number
+    // of threads.
+    void Reset(uint64_t seed, float* observations);
+
+    // Applies actions[i] to environment i (values outside [0, ACTION_COUNT)
+    // count as Action::None) and lets ms_per_step pass. rewards[i] is the
+    // score gained, dones[i] is 1 if the episode ended. 'truncations' may be
+    // null; if given, truncations[i] is 1 if that end was max_episode_steps.
+    // An environment that finishes is reset on the spot, so its row in
+    // 'observations' is already the first observation of its next episode
+    // (LastEpisode says how the old one went).
+    void Step(const int32_t* actions, float* observations, float* rewards, uint8_t* dones,
+              uint8_t* truncations = nullptr);
+
+    const GameState& State(int env) const { return games[env]; }
+    const EpisodeStats& LastEpisode(int env) const { return last_episodes[env]; }
+    uint64_t EpisodesFinished() const;
+
+private:
+    void StartEpisode(int env);
+    void WriteObservation(int env, float* row) const;
+
+    // Runs work(first, last) over contiguous ranges of environments, one
+    // range per pool task, so the pool is asked for a handful of tasks
+    // rather than one per environment.
+    template <typename Work>
+    void ForEachRange(const Work& work);
+
+    EnvConfig config;
+    ThreadPool pool;
+    int range_count = 1;
+    uint64_t base_seed = 0;
+    std::vector<GameState> games;
+    std::vector<EpisodeStats> episodes;       // The running episodes.
+    std::vector<EpisodeStats> last_episodes;
+    std::vector<uint64_t> episode_counts;     // Episodes started per environment.
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "Versus.h"
+
+int VersusMatch::GarbageForLines(int lines) {
+    switch (lines) {
+        case 0:
+        case 1:  return 0;
+        case 2:  return 1;
+        case 3:  return 2;
+        default: return 4; // A Tetris.
+    }
+}
+
+void VersusMatch::Start(uint64_t seed) {
+    for (Player& player : players) {
+        player = Player();
+        player.state.line_clear_delay_ms = 0;
+        ResetGameState(player.state, seed);
+    }
+    hole_seed = seed ^ 0x9E3779B97F4A7C15ull;
+    is_over = false;
+    winner = NO_WINNER;
+}
+
+void VersusMatch::Apply(int player, Action action) {
+    if (is_over) return;
+    HandleResult(player, StepGame(players[player].state, action, 0));
+    CheckForWinner();
+}
+
+void VersusMatch::Advance(int elapsed_ms) {
+    if (is_over) return;
+    for (int i = 0; i < PLAYER_COUNT; ++i) {
+        HandleResult(i, AdvanceGame(players[i].state, elapsed_ms));
+    }
+    CheckForWinner();
+}
+
+void VersusMatch::Forfeit(int player) {
+    if (is_over) return;
+    is_over = true;
+    winner = 1 - player;
+}
+
+void VersusMatch::HandleResult(int index, const StepResult& result) {
+    Player& player = players[index];
+    Player& opponent = players[1 - index];
+
+    // Lines cleared (counted in ShiftLinesDown) turn into an attack, which
+    // first cancels out our own incoming garbage.
+    int attack = GarbageForLines(result.lines_cleared);
+    int cancelled = (attack < player.pending_garbage) ? attack : player.pending_garbage;
+    player.pending_garbage -= cancelled;
+    attack -= cancelled;
+    opponent.pending_garbage += attack;
+    player.garbage_sent += attack;
+
+    // A lock that didn't clear anything lets the pending garbage in.
+    if (result.pieces_locked > 0 && result.lines_cleared == 0 && player.pending_garbage > 0) {
+        int rows = (player.pending_garbage < MAX_GARBAGE_PER_LOCK) ? player.pending_garbage : MAX_GARBAGE_PER_LOCK;
+        player.pending_garbage -= rows;
+        AddGarbage(player.state, rows, NextHoleColumn());
+    }
+}
+
+void VersusMatch::CheckForWinner() {
+    bool lost0 = players[0].state.is_game_over;
+    bool lost1 = players[1].state.is_game_over;
+    if (!lost0 && !lost1) return;
+
+    is_over = true;
+    winner = (lost0 && lost1) ? NO_WINNER : (lost0 ? 1 : 0);
+}
+
+int VersusMatch::NextHoleColumn() {
+    uint64_t z = SplitMix64(hole_seed);
+    hole_seed += 0x9E3779B97F4A7C15ull;
+    return static_cast<int>(z % (LOGICAL_BOARD_WIDTH - 2));
+}
@@ -0,0 +1,64 @@
+#ifndef TETRIS_VERSUS_H
+#define TETRIS_VERSUS_H
+
+#include <cstdint>
+#include "Engine.h"
+
+// Two players, two boards, one set of rules: clearing lines sends garbage
+// rows to the other side. Like the engine, this is plain data driven by
+// Apply/Advance, so a server can run thousands of matches on one thread.
+//
+// Garbage works the usual way: it waits in a "pending" meter first. Your
+// own clears cancel your pending garbage before anything is sent on, and
+// whatever is still pending rises into your board the next time you lock a
+// piece without clearing a line.
+class VersusMatch {
+public:
+    static const int PLAYER_COUNT = 2;
+    static const int NO_WINNER = -1;
+
+    // Never more garbage than this comes up on a single lock; the rest waits.
+    static const int MAX_GARBAGE_PER_LOCK = 8;
+
+    // Garbage sent for clearing 1, 2, 3 or 4 lines at once.
+    static int GarbageForLines(int lines);
+
+    // Both players get the same seed, so they see the same pieces in the
+    // same order. Line clears are instant: the garbage goes out on the very
+    // lock that earned it.
+    void Start(uint64_t seed);
+
+    // One player's input, applied right now.
+    void Apply(int player, Action action);
+
+    // Lets 'elapsed_ms' of game time pass on both boards.
+    void Advance(int elapsed_ms);
+
+    bool IsOver() const { return is_over; }
+    int Winner() const { return winner; } // NO_WINNER while playing, or on a draw.
+
+    // The player who disconnected or gave up loses.
+    void Forfeit(int player);
+
+    const GameState& State(int player) const { return players[player].state; }
+    int PendingGarbage(int player) const { return players[player].pending_garbage; }
+    int GarbageSent(int player) const { return players[player].garbage_sent; }
+
+private:
+    struct Player {
+        GameState state;
+        int pending_garbage = 0;  // Rows on their way into this board.
+        int garbage_sent = 0;     // Rows this player has sent in total.
+    };
+
+    void HandleResult(int player, const StepResult& result);
+    void CheckForWinner();
+    int NextHoleColumn();
+
+    Player players[PLAYER_COUNT];
+    uint64_t hole_seed = 0;  // Picks the gap column of each garbage batch.
+    bool is_over = false;
+    int winner = NO_WINNER;
+};
+
+#endif
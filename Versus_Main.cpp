@@ -0,0 +1,184 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "BoardView.h"
+#include "NetProtocol.h"
+#include "NetSocket.h"
+#include "Renderer.h"
+#include "Terminal.h"
+
+// A console client for tetris_server: your board on the left, your
+// opponent's on the right. It never runs the rules itself; key presses go to
+// the server and the boards are whatever its deltas say.
+// Usage: tetris_versus [--connect=ADDRESS]   (default 127.0.0.1:7777)
+
+namespace {
+
+const int BOARD_SCREEN_WIDTH = LOGICAL_BOARD_WIDTH * 2;
+const int OPPONENT_X = BOARD_SCREEN_WIDTH + 18;
+const int SCREEN_WIDTH = OPPONENT_X + BOARD_SCREEN_WIDTH + 14;
+
+// The same keys as the single player game.
+bool KeyToAction(int key, Action& action) {
+    switch (key) {
+        case '7': case 'a': case 'A': action = Action::MoveLeft; return true;
+        case '9': case 'd': case 'D': action = Action::MoveRight; return true;
+        case '4': case 's': case 'S': action = Action::SoftDrop; return true;
+        case '8': case 'w': case 'W': action = Action::Rotate; return true;
+        case 'z': case 'Z':           action = Action::RotateCCW; return true;
+        case 'x': case 'X':           action = Action::Rotate180; return true;
+        case 'c': case 'C':           action = Action::Hold; return true;
+        case ' ':                     action = Action::HardDrop; return true;
+        default:                      return false;
+    }
+}
+
+void SendMessage(int fd, const std::vector<uint8_t>& bytes) {
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        ssize_t sent = ::send(fd, bytes.data() + offset, bytes.size() - offset, MSG_NOSIGNAL);
+        if (sent > 0) offset += static_cast<size_t>(sent);
+        else if (sent < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        else return;
+    }
+}
+
+void DrawSide(Renderer& renderer, const PlayerView& view, int left, const char* title) {
+    GameState state;
+    view.ToState(state);
+
+    renderer.SetOrigin(left, 0);
+    DrawPlayfield(renderer, state, 0);
+
+    char text[64];
+    int x = BOARD_SCREEN_WIDTH + 1;
+    renderer.Put(x, 0, title);
+    std::snprintf(text, sizeof(text), "SCORE: %d", view.score);
+    renderer.Put(x, 2, text);
+    std::snprintf(text, sizeof(text), "LINES: %d", view.lines);
+    renderer.Put(x, 3, text);
+    std::snprintf(text, sizeof(text), "LEVEL: %d", view.level);
+    renderer.Put(x, 4, text);
+    std::snprintf(text, sizeof(text), "INCOMING: %d", view.pending_garbage);
+    renderer.Put(x, 6, text);
+
+    if (view.has_piece) {
+        renderer.Put(x, 8, "NEXT:");
+        Piece next = {view.next_type, 0};
+        for (int y = 0; y < 4; ++y) {
+            for (int cx = 0; cx < 4; ++cx) {
+                if (next.HasCell(cx, y)) renderer.Put(x + cx * 2, 9 + y, "[]");
+            }
+        }
+    }
+    renderer.SetOrigin(0, 0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string address = "127.0.0.1:7777";
+    if (argc > 1 && std::strncmp(argv[1], "--connect=", 10) == 0) address = argv[1] + 10;
+
+    int fd = ConnectTo(address);
+    if (fd < 0) return 1;
+
+    std::vector<uint8_t> out;
+    { MessageWriter message(out, MessageType::Join); }
+    SendMessage(fd, out);
+
+    Terminal terminal;
+    Renderer renderer(SCREEN_WIDTH, Renderer::SCREEN_HEIGHT);
+    terminal.Setup();
+
+    PlayerView views[VersusMatch::PLAYER_COUNT];
+    for (PlayerView& view : views) view.Reset();
+    int me = -1;              // Our player index while a match is on.
+    bool is_waiting = true;   // Joined, no opponent yet.
+    const char* status = "WAITING FOR AN OPPONENT...";
+    bool is_running = true;
+    std::vector<uint8_t> in;
+
+    while (is_running) {
+        terminal.WaitForInput(5);
+
+        // Keys: every action pressed since last time goes out in one message.
+        out.clear();
+        {
+            MessageWriter message(out, MessageType::Input);
+            int key;
+            while ((key = terminal.ReadKey()) != -1) {
+                Action action;
+                if (key == 'q' || key == 'Q') is_running = false;
+                else if (me >= 0 && KeyToAction(key, action)) message.U8(static_cast<uint8_t>(action));
+                else if (me < 0 && !is_waiting && key == '5') {
+                    is_waiting = true;
+                    status = "WAITING FOR AN OPPONENT...";
+                    std::vector<uint8_t> join;
+                    { MessageWriter join_message(join, MessageType::Join); }
+                    SendMessage(fd, join);
+                }
+            }
+        }
+        if (out.size() > MESSAGE_HEADER_SIZE) SendMessage(fd, out);
+
+        // Whatever the server sent.
+        uint8_t buffer[4096];
+        ssize_t received;
+        while ((received = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            in.insert(in.end(), buffer, buffer + received);
+        }
+        if (received == 0) {
+            status = "THE SERVER WENT AWAY. Q TO QUIT";
+            me = -1;
+        }
+
+        size_t offset = 0;
+        Message message;
+        int used;
+        while ((used = ParseMessage(in.data() + offset, in.size() - offset, message)) > 0) {
+            offset += static_cast<size_t>(used);
+            MessageReader reader(message.payload, message.payload_size);
+            uint32_t tick;
+            switch (message.type) {
+                case MessageType::MatchStart:
+                    reader.U64();
+                    me = reader.U8();
+                    is_waiting = false;
+                    for (PlayerView& view : views) view.Reset();
+                    status = "GO!";
+                    break;
+                case MessageType::Delta:
+                    ApplyDelta(message.payload, message.payload_size, views, tick);
+                    break;
+                case MessageType::MatchEnd: {
+                    uint8_t winner = reader.U8();
+                    status = (winner == DRAW_WINNER) ? "DRAW! 5: PLAY AGAIN  Q: QUIT"
+                           : (winner == me)          ? "YOU WIN! 5: PLAY AGAIN  Q: QUIT"
+                                                     : "YOU LOSE! 5: PLAY AGAIN  Q: QUIT";
+                    me = -1;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        in.erase(in.begin(), in.begin() + static_cast<std::ptrdiff_t>(offset));
+
+        renderer.BeginFrame();
+        int mine = (me >= 0) ? me : 0;
+        DrawSide(renderer, views[mine], 0, "YOU");
+        DrawSide(renderer, views[1 - mine], OPPONENT_X, "OPPONENT");
+        renderer.Put(0, Renderer::SCREEN_HEIGHT - 1, status);
+        const std::string& frame = renderer.Present();
+        if (!frame.empty()) terminal.Write(frame.data(), frame.size());
+    }
+
+    terminal.Restore();
+    ::close(fd);
+    return 0;
+}
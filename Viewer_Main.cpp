@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "BoardView.h"
+#include "Broadcast.h"
+#include "GameRules.h"
+#include "Renderer.h"
+#include "Scheduler.h"
+#include "Terminal.h"
+
+// A read-only spectator for a game started with "Tetris --broadcast". It
+// draws the same board and HUD as the game from the broadcast's shared
+// memory, and never sends anything back, so any number of them can watch
+// without the player's loop noticing.
+// Usage: tetris_viewer [--name=NAME]   (default "tetris")
+
+namespace {
+
+const int POLL_MS = 16;          // About 60 pictures a second, at most.
+const int REOPEN_MS = 500;       // How often to look for a game that isn't there (yet).
+const int STALE_MS = 1000;       // Quiet for this long: check it's still the same game.
+
+// The view carries no "goal reached" flag, but each mode's goal can be read
+// off its numbers: the line goal is down, or Ultra's clock has run out.
+bool IsGoalReached(const BroadcastView& view) {
+    switch (view.mode) {
+        case GameMode::Marathon: return view.lines >= MarathonRules::LINE_GOAL;
+        case GameMode::Sprint:   return view.lines >= SprintRules::LINE_GOAL;
+        case GameMode::Ultra:    return view.time_ms == 0;
+        default:                 return false;
+    }
+}
+
+// Laid out like the game's DrawStats and DrawRunStats.
+void DrawHud(Renderer& renderer, const BroadcastView& view, int left) {
+    char text[64];
+    char time[16];
+    if (view.mode == GameMode::Sprint) {
+        if (view.best_time_ms > 0) {
+            FormatRunTime(static_cast<int64_t>(view.best_time_ms) * 1000000, time, sizeof(time));
+        } else {
+            std::snprintf(time, sizeof(time), "-");
+        }
+        std::snprintf(text, sizeof(text), "BEST TIME: %s", time);
+    } else {
+        std::snprintf(text, sizeof(text), "BEST SCORE: %d", view.high_score);
+    }
+    renderer.Put(left, 0, text);
+    if (view.mode == GameMode::Sprint) {
+        std::snprintf(text, sizeof(text), "LINES CLEARED: %d / %d", view.lines, SprintRules::LINE_GOAL);
+    } else {
+        std::snprintf(text, sizeof(text), "LINES CLEARED: %d", view.lines);
+    }
+    renderer.Put(left, 1, text);
+    std::snprintf(text, sizeof(text), "LEVEL: %d", view.level);
+    renderer.Put(left, 3, text);
+    std::snprintf(text, sizeof(text), "SCORE: %d", view.score);
+    renderer.Put(left, 5, text);
+    if (view.spin == SpinType::Full) renderer.Put(left + 16, 5, "T-SPIN!");
+    if (view.spin == SpinType::Mini) renderer.Put(left + 16, 5, "T-SPIN MINI");
+    if (view.combo > 0) {
+        std::snprintf(text, sizeof(text), "COMBO x%d", view.combo);
+        renderer.Put(left, 6, text);
+    }
+    if (view.flags & BroadcastView::BACK_TO_BACK) renderer.Put(left + 16, 6, "BACK-TO-BACK");
+
+    // The run clock, in tenths while it runs.
+    bool is_running = (view.flags & BroadcastView::CLOCK_RUNNING) != 0;
+    FormatRunTime(static_cast<int64_t>(view.time_ms) * 1000000, time, sizeof(time), is_running ? 1 : 3);
+    std::snprintf(text, sizeof(text), "%s %s %s", HudModeTitle(view.mode),
+                  view.mode == GameMode::Ultra ? "LEFT:" : "TIME:", time);
+    renderer.Put(left, 2, text);
+    std::snprintf(text, sizeof(text), "PPS: %.2f  KPP: %.2f", view.pieces_per_second / 100.0,
+                  view.keys_per_piece / 100.0);
+    renderer.Put(left, 4, text);
+
+    int split_x = left + 12;
+    int shown = std::min<int>(view.split_count, BroadcastView::MAX_SPLITS);
+    if (shown > 0) renderer.Put(split_x, 7, "SPLITS:");
+    for (int i = 0; i < shown; ++i) {
+        FormatRunTime(static_cast<int64_t>(view.splits_ms[i]) * 1000000, time, sizeof(time));
+        std::snprintf(text, sizeof(text), "%3d %s", (view.split_count - shown + i + 1) * RunStats::SPLIT_LINES, time);
+        renderer.Put(split_x, 8 + i, text);
+    }
+
+    renderer.Put(left, 7, "HOLD:");
+    if (view.held_type >= 0) {
+        Piece held = {static_cast<uint8_t>(view.held_type), 0};
+        const char* cell = view.can_hold ? "[]" : "::";
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                if (held.HasCell(x, y)) renderer.Put(left + x * 2, 8 + y, cell);
+            }
+        }
+    }
+
+    // The preview column sits where the game puts it.
+    int preview_x = left + 34;
+    renderer.Put(preview_x, 0, "NEXT:");
+    for (int i = 0; i < view.preview_count; ++i) {
+        Piece next = {view.preview[i], 0};
+        for (int y = 0; y < 2; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                if (next.HasCell(x, y + 1)) renderer.Put(preview_x + x * 2, 1 + i * 3 + y, "[]");
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string name = "tetris";
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--name=", 7) == 0) {
+            name = argv[i] + 7;
+        } else {
+            std::fprintf(stderr, "usage: tetris_viewer [--name=NAME]\n");
+            return 2;
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    BroadcastViewer viewer;
+    BroadcastView view;
+    view.Reset();
+    GameState state;
+    Terminal terminal;
+    Renderer renderer;
+    terminal.Setup();
+
+    auto last_open_try = Clock::now() - std::chrono::milliseconds(REOPEN_MS);
+    auto last_record = Clock::now();
+    bool is_running = true;
+
+    while (is_running) {
+        terminal.WaitForInput(POLL_MS);
+        int key;
+        while ((key = terminal.ReadKey()) != -1) {
+            if (key == 'q' || key == 'Q') is_running = false;
+        }
+
+        auto now = Clock::now();
+        if (viewer.IsOpen() && !viewer.IsLive()) {
+            viewer.Close(); // The game has quit; wait for the next one.
+            view.Reset();
+        }
+        // A game that crashed never says it has gone, and its next run
+        // broadcasts in a new block under the same name: after a quiet
+        // spell, open the name again (cheap, and the same game just resyncs).
+        bool is_stale = viewer.IsOpen() && now - last_record > std::chrono::milliseconds(STALE_MS);
+        if ((!viewer.IsOpen() || is_stale) && now - last_open_try >= std::chrono::milliseconds(REOPEN_MS)) {
+            last_open_try = now;
+            if (viewer.Open(name)) last_record = now;
+        }
+        if (viewer.Poll(view) > 0) last_record = now;
+
+        renderer.BeginFrame();
+        view.ToState(state);
+        DrawPlayfield(renderer, state, (view.flags & BroadcastView::FLASH_ON) ? 1 : 0);
+        DrawHud(renderer, view, PlayfieldScreenWidth(state.board) + 4);
+
+        int center_y = PlayfieldScreenHeight(state.board) / 2;
+        if (view.flags & BroadcastView::GAME_OVER) {
+            renderer.Put(2, center_y - 1, "====================");
+            renderer.Put(2, center_y, IsGoalReached(view) ? " --- FINISHED! ---  " : " --- GAME OVER! --- ");
+            renderer.Put(2, center_y + 1, "====================");
+        } else if (view.flags & BroadcastView::PAUSED) {
+            renderer.Put(2, center_y - 1, "********************");
+            renderer.Put(2, center_y,     "   --- PAUSED ---   ");
+            renderer.Put(2, center_y + 1, "********************");
+        }
+
+        char status[64];
+        if (!viewer.IsOpen()) {
+            std::snprintf(status, sizeof(status), "WAITING FOR '%s' (Tetris --broadcast)", name.c_str());
+        } else {
+            const char* mode = (view.flags & BroadcastView::REPLAY)     ? " (REPLAY)"
+                             : (view.flags & BroadcastView::AUTOPLAY) ? " (AUTOPLAY)"
+                                                                       : "";
+            std::snprintf(status, sizeof(status), "WATCHING '%s'%s  Q: QUIT", name.c_str(), mode);
+        }
+        renderer.Put(0, Renderer::SCREEN_HEIGHT - 1, status);
+
+        const std::string& frame = renderer.Present();
+        if (!frame.empty()) terminal.Write(frame.data(), frame.size());
+    }
+
+    terminal.Restore();
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "Zobrist.h"
+
+namespace {
+
+// A play row is 10 cells; hashing it as two 5-cell halves needs 2 x 32
+// precomputed XORs per row instead of up to 10 key lookups.
+const int HALF_WIDTH = 5;
+const int HALF_VALUES = 1 << HALF_WIDTH;
+const int PLAY_WIDTH = LOGICAL_BOARD_WIDTH - 2;
+static_assert(PLAY_WIDTH == 2 * HALF_WIDTH, "the row halves cover the classic board");
+
+// Piece positions are kept with an offset, since a piece's box can hang past
+// the left wall or (after an SRS floor kick) above the ceiling.
+const int POSITION_OFFSET = 4;
+const int POSITION_RANGE = 32;
+
+// Every key comes from its own slot number, so adding keys for something new
+// never changes the old ones.
+constexpr uint64_t CellKey(int x, int y) { return SplitMix64(static_cast<uint64_t>(y * 64 + x)); }
+constexpr uint64_t ExtraKey(int slot) { return SplitMix64(0x10000u + static_cast<uint64_t>(slot)); }
+
+struct ZobristTable {
+    // halves[y][h][bits]: the XOR of the keys of row y's cells in half h that 'bits' has set.
+    uint64_t halves[GAME_BOARD_HEIGHT][2][HALF_VALUES];
+    uint64_t pieces[PIECE_TYPE_COUNT][ROTATION_COUNT];
+    uint64_t x[POSITION_RANGE];
+    uint64_t y[POSITION_RANGE];
+    uint64_t held[PIECE_TYPE_COUNT + 1]; // [held_type + 1], so an empty slot has a key too.
+    uint64_t can_hold;
+};
+
+constexpr ZobristTable BuildZobristTable() {
+    ZobristTable table = {};
+    for (int y = 0; y < GAME_BOARD_HEIGHT; ++y) {
+        for (int half = 0; half < 2; ++half) {
+            for (int bits = 0; bits < HALF_VALUES; ++bits) {
+                uint64_t key = 0;
+                for (int i = 0; i < HALF_WIDTH; ++i) {
+                    if (bits & (1 << i)) key ^= CellKey(1 + half * HALF_WIDTH + i, y);
+                }
+                table.halves[y][half][bits] = key;
+            }
+        }
+    }
+
+    int slot = 0;
+    for (auto& rotations : table.pieces) {
+        for (uint64_t& key : rotations) key = ExtraKey(slot++);
+    }
+    for (uint64_t& key : table.x) key = ExtraKey(slot++);
+    for (uint64_t& key : table.y) key = ExtraKey(slot++);
+    for (uint64_t& key : table.held) key = ExtraKey(slot++);
+    table.can_hold = ExtraKey(slot++);
+    return table;
+}
+
+constexpr ZobristTable ZOBRIST_TABLE = BuildZobristTable();
+
+// 'row' is a board row mask (bit 0 = the left wall); walls are ignored.
+uint64_t RowKey(int y, uint32_t row) {
+    return ZOBRIST_TABLE.halves[y][0][(row >> 1) & (HALF_VALUES - 1)] ^
+           ZOBRIST_TABLE.halves[y][1][(row >> (1 + HALF_WIDTH)) & (HALF_VALUES - 1)];
+}
+
+} // namespace
+
+uint64_t ZobristHash(const Bitboard& board) {
+    uint64_t hash = 0;
+    for (int y = 1; y < GAME_BOARD_HEIGHT - 1; ++y) hash ^= RowKey(y, board.rows[y]);
+    return hash;
+}
+
+uint64_t ZobristCells(const PieceMask& piece, int x, int y) {
+    uint64_t hash = 0;
+    for (int py = 0; py < 4; ++py) {
+        uint32_t bits = piece.rows[py];
+        if (bits == 0) continue;
+        bits = (x >= 0) ? (bits << x) : (bits >> -x);
+        hash ^= RowKey(y + py, bits);
+    }
+    return hash;
+}
+
+uint64_t ZobristHash(const GameState& state) {
+    const Piece piece = state.current_piece;
+    const Position pos = state.current_pos;
+    uint64_t hash = ZobristHash(state.board);
+    hash ^= ZOBRIST_TABLE.pieces[piece.type][piece.rotation];
+    hash ^= ZOBRIST_TABLE.x[(pos.x + POSITION_OFFSET) & (POSITION_RANGE - 1)];
+    hash ^= ZOBRIST_TABLE.y[(pos.y + POSITION_OFFSET) & (POSITION_RANGE - 1)];
+    hash ^= ZOBRIST_TABLE.held[state.held_type + 1];
+    if (state.can_hold) hash ^= ZOBRIST_TABLE.can_hold;
+    return hash;
+}
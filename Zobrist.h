@@ -0,0 +1,32 @@
+#ifndef TETRIS_ZOBRIST_H
+#define TETRIS_ZOBRIST_H
+
+#include <cstdint>
+#include "Engine.h"
+
+// Zobrist hashing, for search code that wants a transposition table: every
+// play cell of the classic board has its own random 64-bit key, and a
+// board's hash is the XOR of the keys of its filled cells. Only which
+// cells are filled counts, not their colors, because that is all the rules
+// look at.
+//
+// XOR undoes itself, so a search that locks a piece can update the hash with
+// ZobristCells instead of hashing the board again (a line clear moves every
+// row above it, so after one the board has to be hashed from scratch).
+// The keys are fixed at compile time, so hashes are the same in every run
+// and can be stored.
+
+// The hash of the cells that are filled on 'board'. An empty board hashes to 0.
+uint64_t ZobristHash(const Bitboard& board);
+
+// The keys of the cells a piece covers at (x, y). After
+//   board.Place(piece.Mask(), x, y, ...)
+// with no line cleared, ZobristHash(board) == old_hash ^ ZobristCells(piece.Mask(), x, y).
+uint64_t ZobristCells(const PieceMask& piece, int x, int y);
+
+// The board plus the falling piece, where it is, the hold slot and whether
+// it can be used: what decides which moves come next. Two states that only
+// differ in score, timers or the piece queue hash the same.
+uint64_t ZobristHash(const GameState& state);
+
+#endif
@@ -1,14 +1,32 @@
+#include <cstdio>
 #include "Game.h"
 
-int main() {
-    // This line makes sure the game is random every time you play.
-    // Without it, the "random" pieces would fall in the exact same order
-    // every time you opened the game.
-    srand(static_cast<unsigned int>(time(0)));
+int main(int argc, char** argv) {
+    // "Tetris --replay last_game.replay" watches a recorded game at normal speed.
+    // "Tetris --broadcast" (or --broadcast=NAME) lets tetris_viewer watch along.
+    // "Tetris --mode=sprint" plays marathon, sprint (40 lines) or ultra (2 minutes).
+    std::string replay_path;
+    std::string broadcast_name;
+    GameMode mode = GameMode::Classic;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (arg == "--broadcast") {
+            broadcast_name = "tetris";
+        } else if (arg.compare(0, 12, "--broadcast=") == 0) {
+            broadcast_name = arg.substr(12);
+        } else if (arg.compare(0, 7, "--mode=") == 0) {
+            if (!ParseGameMode(arg.c_str() + 7, mode)) {
+                std::fprintf(stderr, "unknown mode '%s' (classic, marathon, sprint or ultra)\n", arg.c_str() + 7);
+                return 2;
+            }
+        }
+    }
 
     // Here we create the actual Tetris game object.
     // This sets up the board, the pieces, and the console window.
-    Game tetris_game;
+    Game tetris_game(replay_path, broadcast_name, mode);
 
     // This is the "on" switch. It starts the main loop that
     // listens for your keys, moves the pieces down, and draws the board.